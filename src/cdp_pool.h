@@ -0,0 +1,232 @@
+/*
+ *  Copyright (c) 2025 Victor M. Barrientos (https://github.com/FirmwGuy/CacadeDP)
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of
+ *  this software and associated documentation files (the "Software"), to deal in
+ *  the Software without restriction, including without limitation the rights to
+ *  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is furnished to do
+ *  so.
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+
+#ifndef CDP_POOL_H
+#define CDP_POOL_H
+
+
+#include "cdp_util.h"
+
+
+/*
+    Fixed capacity pool allocator
+
+    Serves every allocation from a single buffer given by the user (no
+    heap at all), so memory use is bounded and requests beyond it just
+    fail. Blocks carry their own size and the size of the block right
+    before them, so freed blocks merge with free neighbours at once.
+    Free blocks are found first-fit. As pool memory is scarce, building
+    with CDP_SLAB_DISABLE keeps records from reserving 64 KiB slabs.
+    Nothing is locked: a pool serves one thread at a time, so threads
+    sharing one must guard it themselves.
+*/
+
+typedef struct _cdpPoolBlock  cdpPoolBlock;
+
+struct _cdpPoolBlock {
+    size_t          size;       // Block bytes (header included), bit 0 is set if in use.
+    size_t          prevSize;   // Bytes of the block right before (0 for the first).
+    // Free blocks only:
+    cdpPoolBlock*   next;       // Next free block.
+    cdpPoolBlock*   prev;       // Previous free block.
+};
+
+typedef struct {
+    char*           base;       // Pool memory.
+    char*           end;        // End of the last block.
+    cdpPoolBlock*   free;       // Free blocks.
+    size_t          used;       // Bytes in use (headers included).
+    size_t          peak;       // Highest 'used' seen.
+    size_t          failures;   // Requests that didn't fit.
+} cdpPool;
+
+
+#define CDP_POOL_HEAD       (2 * sizeof(size_t))            // Header of used blocks (keeps a 16 byte alignment).
+#define CDP_POOL_MIN_BLOCK  sizeof(cdpPoolBlock)
+
+#define cdp_pool_block_size(b)    ((b)->size & ~(size_t)1)
+#define cdp_pool_block_used(b)    ((b)->size & 1)
+#define cdp_pool_block_of(p)      ((cdpPoolBlock*)((char*)(p) - CDP_POOL_HEAD))
+#define cdp_pool_payload(b)       ((void*)((char*)(b) + CDP_POOL_HEAD))
+
+
+static inline cdpPoolBlock* cdp_pool_next_block(cdpPool* pool, cdpPoolBlock* block) {
+    char* next = (char*)block + cdp_pool_block_size(block);
+    return (next < pool->end)?  (cdpPoolBlock*)next:  NULL;
+}
+
+
+static inline void cdp_pool_link(cdpPool* pool, cdpPoolBlock* block) {
+    block->prev = NULL;
+    block->next = pool->free;
+    if (pool->free)
+        pool->free->prev = block;
+    pool->free = block;
+}
+
+
+static inline void cdp_pool_unlink(cdpPool* pool, cdpPoolBlock* block) {
+    if (block->prev) block->prev->next = block->next;
+    else             pool->free = block->next;
+    if (block->next) block->next->prev = block->prev;
+}
+
+
+static inline void cdp_pool_resize(cdpPool* pool, cdpPoolBlock* block, size_t size) {
+    // Sets a (free) block size and tells the block after it.
+    block->size = size;
+    cdpPoolBlock* next = cdp_pool_next_block(pool, block);
+    if (next)
+        next->prevSize = size;
+}
+
+
+static inline void* cdp_pool_take(cdpPool* pool, cdpPoolBlock* block, size_t gap, size_t need) {
+    // Carves 'need' bytes from a free block, starting 'gap' bytes into it.
+    cdp_pool_unlink(pool, block);
+    if (gap) {
+        size_t size = cdp_pool_block_size(block);
+        cdp_pool_resize(pool, block, gap);
+        cdp_pool_link(pool, block);
+        cdpPoolBlock* rest = (cdpPoolBlock*)((char*)block + gap);
+        rest->prevSize = gap;
+        cdp_pool_resize(pool, rest, size - gap);
+        block = rest;
+    }
+    size_t size = cdp_pool_block_size(block);
+    if (size - need >= CDP_POOL_MIN_BLOCK) {
+        cdp_pool_resize(pool, block, need);
+        cdpPoolBlock* tail = (cdpPoolBlock*)((char*)block + need);
+        tail->prevSize = need;
+        cdp_pool_resize(pool, tail, size - need);
+        cdp_pool_link(pool, tail);
+        size = need;
+    }
+    block->size = size | 1;
+
+    pool->used += size;
+    if (pool->used > pool->peak)
+        pool->peak = pool->used;
+    return cdp_pool_payload(block);
+}
+
+
+static inline size_t cdp_pool_need(size_t size) {
+    size_t need = ((size + 15) & ~(size_t)15) + CDP_POOL_HEAD;
+    return cdp_max(need, CDP_POOL_MIN_BLOCK);
+}
+
+
+static inline void* cdp_pool_aligned(void* context, size_t alignment, size_t size) {
+    cdpPool* pool = context;
+    assert(pool && alignment && !(alignment & (alignment - 1)));
+    if CDP_RARELY(size > (size_t)(pool->end - pool->base)) {
+        pool->failures++;
+        return NULL;
+    }
+    size_t need = cdp_pool_need(size);
+    alignment = cdp_max(alignment, (size_t)16);
+
+    for (cdpPoolBlock* block = pool->free;  block;  block = block->next) {
+        uintptr_t payload = (uintptr_t) cdp_pool_payload(block);
+        uintptr_t aligned = (payload + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+        size_t    gap     = aligned - payload;
+        while (gap  &&  gap < CDP_POOL_MIN_BLOCK) {
+            gap += alignment;       // The skipped front must make a block by itself.
+        }
+        if (gap + need <= cdp_pool_block_size(block))
+            return cdp_pool_take(pool, block, gap, need);
+    }
+    pool->failures++;
+    return NULL;
+}
+
+
+static inline void* cdp_pool_alloc(void* context, size_t size) {
+    return cdp_pool_aligned(context, 16, size);
+}
+
+
+static inline void cdp_pool_free(void* context, void* ptr) {
+    cdpPool* pool = context;
+    if (!ptr)
+        return;
+    cdpPoolBlock* block = cdp_pool_block_of(ptr);
+    assert((char*)block >= pool->base  &&  (char*)block < pool->end  &&  cdp_pool_block_used(block));
+    size_t size = cdp_pool_block_size(block);
+    pool->used -= size;
+
+    cdpPoolBlock* next = cdp_pool_next_block(pool, block);
+    if (next  &&  !cdp_pool_block_used(next)) {
+        cdp_pool_unlink(pool, next);
+        size += cdp_pool_block_size(next);
+    }
+    if (block->prevSize) {
+        cdpPoolBlock* prev = (cdpPoolBlock*)((char*)block - block->prevSize);
+        if (!cdp_pool_block_used(prev)) {
+            // The previous block (already linked) takes this one.
+            cdp_pool_resize(pool, prev, cdp_pool_block_size(prev) + size);
+            return;
+        }
+    }
+    cdp_pool_resize(pool, block, size);
+    cdp_pool_link(pool, block);
+}
+
+
+static inline void* cdp_pool_realloc(void* context, void* ptr, size_t size) {
+    if (!ptr)
+        return cdp_pool_alloc(context, size);
+    size_t have = cdp_pool_block_size(cdp_pool_block_of(ptr)) - CDP_POOL_HEAD;
+    if (size <= have)
+        return ptr;
+    void* moved = cdp_pool_alloc(context, size);
+    if (moved) {
+        memcpy(moved, ptr, have);
+        cdp_pool_free(context, ptr);
+    }
+    return moved;
+}
+
+
+static inline void cdp_pool_init(cdpPool* pool, void* buffer, size_t size) {
+    assert(pool && buffer);
+    CDP_0(pool);
+    uintptr_t start = ((uintptr_t)buffer + 15) & ~(uintptr_t)15;
+    size_t    bytes = (size - (start - (uintptr_t)buffer)) & ~(size_t)15;
+    assert(size > (start - (uintptr_t)buffer)  &&  bytes >= CDP_POOL_MIN_BLOCK);
+    pool->base = (char*) start;
+    pool->end  = pool->base + bytes;
+
+    cdpPoolBlock* block = (cdpPoolBlock*) pool->base;
+    block->size     = bytes;
+    block->prevSize = 0;
+    cdp_pool_link(pool, block);
+}
+
+
+#define cdp_pool_allocator(pool)  ((cdpAllocator){cdp_pool_alloc, cdp_pool_realloc, cdp_pool_aligned, cdp_pool_free, (pool)})
+
+
+#endif
@@ -26,6 +26,9 @@
 #include "cdp_record.h"
 
 #include <stdarg.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
 
 
 
@@ -44,16 +47,53 @@ static inline int record_compare_by_name(const cdpRecord* restrict key, const cd
 }
 
 
+static inline uint64_t record_data_hash(const cdpRecord* record) {
+    return (cdp_record_is_normal(record) && record->data)?  cdp_data_hash(record->data):  0;
+}
+
+
+typedef struct {
+    cdpCompare  compare;
+    void*       context;
+} cdpHashCompare;
+
+static int record_compare_by_hash(const cdpRecord* restrict key, const cdpRecord* restrict rec, void* context) {
+    // Orders by content hash first, so only records with the same hash reach the (slower) compare function.
+    uint64_t keyHash = record_data_hash(key);
+    uint64_t recHash = record_data_hash(rec);
+    if (keyHash != recHash)
+        return (keyHash > recHash)?  1:  -1;
+    cdpHashCompare* byHash = context;
+    return byHash->compare(key, rec, byHash->context);
+}
+
+#define STORE_SORTS_BY_HASH(store)                                              \
+    ((store)->indexing == CDP_INDEX_BY_HASH                                    \
+  && (store)->storage != CDP_STORAGE_HASH_TABLE                                \
+  && (store)->storage != CDP_STORAGE_OCTREE)
+
+
+
+
+static void record_sort(cdpRecord* record, size_t count, cdpCompare compare, void* context);
+static void store_child_adopt(cdpStore* store, cdpRecord* record);
+static void store_child_orphan(cdpStore* store, cdpRecord* record);
 
 
 /*
     Include child storage techs
 */
+#include "storage/cdp_slab.h"
 #include "storage/cdp_linked_list.h"
 #include "storage/cdp_dynamic_array.h"
 #include "storage/cdp_packed_queue.h"
 #include "storage/cdp_red_black_tree.h"
 #include "storage/cdp_octree.h"
+#include "storage/cdp_hash_table.h"
+#include "storage/cdp_btree.h"
+#include "storage/cdp_skiplist.h"
+#include "storage/cdp_art.h"
+#include "storage/cdp_inline.h"
 
 
 
@@ -65,7 +105,53 @@ static inline int record_compare_by_name(const cdpRecord* restrict key, const cd
  ***********************************************/
 
 
-cdpRecord CDP_ROOT;   // The root record.
+cdpRecord    CDP_ROOT;                          // The root record.
+cdpAllocator CDP_ALLOCATOR = CDP_ALLOCATOR_LIBC;  // Memory used by records (and the rest of CDP).
+
+static struct {
+    cdpData**   slot;       // Open addressed (linear probing) interned data.
+    size_t      capacity;   // Slots (a power of two, 0 until first used).
+    size_t      count;
+    atomic_flag lock;
+} DATA_INTERN;              // Interning table (for read-only data).
+
+typedef struct {
+    cdpRecord*  record;     // Current address of the record (NULL if the slot is free).
+    cdpStore*   store;      // Store counting the record among its handled children (NULL if it is in none).
+    uint32_t    generation; // Bumped each time the slot is given back.
+    union {
+        uint32_t    next;       // Next free slot (plus one).
+        uint32_t    shadowing;  // Links pointing to the record (CDP_SHADOW_*), while in use.
+    };
+    cdpHandle   resolved;   // Final (non link) record a link leads to, as cached by cdp_link_resolve (if the record is a link).
+    union {
+        cdpHandle   linked; // The link shadowing the record (if just one).
+        cdpShadow*  shadow; // Links shadowing the record (if several).
+    };
+} cdpHandleSlot;
+
+#define HANDLE_CHUNKS   26      // Chunk k (past the first) holds HANDLE_MIN << (k - 1) slots.
+
+static struct {
+    cdpHandleSlot*  chunk[HANDLE_CHUNKS];   // Slots, in chunks that never move (so handles resolve without locking).
+    uint32_t*       index;      // Open addressed (linear probing) slots (plus one), by record address.
+    uint32_t        capacity;   // Slots (published last when growing).
+    uint32_t        indexCap;   // Index entries (a power of two).
+    uint32_t        free;       // First free slot (plus one).
+    atomic_flag     lock;       // Guards the table and the shadows (records in shared stores may be handled from any thread).
+} HANDLES;                  // Handle table.
+size_t CDP_HANDLE_COUNT;    // Live handles.
+size_t CDP_HANDLE_LOOSE;    // Live handles of records in no store (stores count the rest as 'handled').
+static bool LINK_UNTRACKED; // Some link couldn't get into its target shadow (out of memory), so link chains aren't cached anymore.
+
+
+/*
+    Sets the allocator for the record system (before initiating it)
+*/
+void cdp_record_system_allocator(const cdpAllocator* allocator) {
+    assert(cdp_record_is_void(&CDP_ROOT));     // Nothing may remain from the previous one.
+    CDP_ALLOCATOR = allocator?  *allocator:  CDP_ALLOCATOR_LIBC;
+}
 
 
 /*
@@ -83,7 +169,20 @@ void cdp_record_system_initiate(void) {
     Shutdowns the record system
 */
 void cdp_record_system_shutdown(void) {
+    skiplist_shutdown();
     cdp_record_finalize(&CDP_ROOT);
+    cdp_store_chunk_pool_flush();
+    assert(!DATA_INTERN.count);
+    cdp_free(DATA_INTERN.slot);
+    CDP_0(&DATA_INTERN);
+    assert(!CDP_HANDLE_COUNT);
+    for (unsigned k = 0;  k < HANDLE_CHUNKS;  k++)
+        cdp_free(HANDLES.chunk[k]);
+    cdp_free(HANDLES.index);
+    CDP_0(&HANDLES);
+    LINK_UNTRACKED = false;
+    slab_shutdown();
+    CDP_0(&CDP_ROOT);
 }
 
 
@@ -115,12 +214,14 @@ cdpData* cdp_data_new(  cdpDT* dt, cdpID encoding, cdpID attribute,
         size_t dmax  = cdp_max(VALUE_CAP_MIN, capacity);
         size_t alocz = DATA_HEAD_SIZE + dmax;
 
+        data = slab_try_alloc(alocz);
+        if CDP_RARELY(!data)
+            break;
         if (size) {
-            data = cdp_malloc(alocz);
             memset(data, 0, DATA_HEAD_SIZE);
             memcpy(data->value, value, size);
         } else {
-            data = cdp_malloc0(alocz);
+            memset(data, 0, alocz);
             size = capacity;
         }
         data->capacity = dmax;
@@ -136,18 +237,22 @@ cdpData* cdp_data_new(  cdpDT* dt, cdpID encoding, cdpID attribute,
         cdpDel destructor = va_arg(args, cdpDel);
         assert(capacity  &&  (capacity >= size));
 
-        data = cdp_malloc0(sizeof(cdpData));
+        data = slab_try_new_item(cdpData);
+        if CDP_RARELY(!data)
+            break;
 
         if (destructor) {
             data->data       = value;
             data->destructor = destructor;
         } else {
-            if (size) {
-                data->data = cdp_malloc(capacity);
-                memcpy(data->data, value, size);
-            } else {
-                data->data = cdp_malloc0(capacity);
+            data->data = size?  cdp_try_malloc(capacity):  cdp_try_malloc0(capacity);
+            if CDP_RARELY(!data->data) {
+                slab_del_item(cdpData, data);
+                data = NULL;
+                break;
             }
+            if (size)
+                memcpy(data->data, value, size);
             data->destructor = cdp_free;
         }
         data->capacity = capacity;
@@ -162,7 +267,9 @@ cdpData* cdp_data_new(  cdpDT* dt, cdpID encoding, cdpID attribute,
         cdpRecord* library = va_arg(args, cdpRecord*);
         assert(handle && library);
 
-        data = cdp_malloc0(sizeof(cdpData));
+        data = slab_try_new_item(cdpData);
+        if CDP_RARELY(!data)
+            break;
 
         data->handle  = handle;
         data->library = library;
@@ -176,7 +283,9 @@ cdpData* cdp_data_new(  cdpDT* dt, cdpID encoding, cdpID attribute,
         cdpRecord* library = va_arg(args, cdpRecord*);
         assert(stream && library);
 
-        data = cdp_malloc0(sizeof(cdpData));
+        data = slab_try_new_item(cdpData);
+        if CDP_RARELY(!data)
+            break;
 
         data->stream  = stream;
         data->library = library;
@@ -188,13 +297,19 @@ cdpData* cdp_data_new(  cdpDT* dt, cdpID encoding, cdpID attribute,
 
     va_end(args);
 
+    if CDP_RARELY(!data)
+        return NULL;        // Out of memory.
+
     data->domain    = dt->domain;
     data->tag       = dt->tag;
     data->datatype  = datatype;
     data->writable  = writable;
+    data->interned  = false;
 
     data->encoding      = encoding;
     data->attribute._id = attribute;
+    data->refs          = 1;
+    data->hash          = 0;
 
     CDP_PTR_SEC_SET(dataloc, address);
 
@@ -202,8 +317,17 @@ cdpData* cdp_data_new(  cdpDT* dt, cdpID encoding, cdpID attribute,
 }
 
 
+static bool data_intern_release(cdpData* data);
+
 void cdp_data_del(cdpData* data) {
-    assert(data);
+    assert(data && data->refs);
+
+    if (data->interned) {
+        if (!data_intern_release(data))
+            return;
+    } else if (__atomic_fetch_sub(&data->refs, 1, __ATOMIC_ACQ_REL) > 1) {
+        return;     // Still used by other records.
+    }
 
     switch (data->datatype) {
       case CDP_DATATYPE_DATA: {
@@ -218,7 +342,209 @@ void cdp_data_del(cdpData* data) {
       }
     }
 
-    cdp_free(data);
+    if (data->datatype == CDP_DATATYPE_VALUE)
+        slab_free(data, DATA_HEAD_SIZE + data->capacity);
+    else
+        slab_del_item(cdpData, data);
+}
+
+
+/*
+   Shares data with another record (no copy is made until one of them updates it)
+*/
+cdpData* cdp_data_share(cdpData* data) {
+    assert(cdp_data_valid(data));
+    __atomic_fetch_add(&data->refs, 1, __ATOMIC_RELAXED);
+    return data;
+}
+
+
+/*
+   Gets the hash of data content (computed once, until the content changes)
+*/
+uint64_t cdp_data_hash(cdpData* data) {
+    assert(cdp_data_valid(data));
+
+    uint64_t hash = __atomic_load_n(&data->hash, __ATOMIC_RELAXED);
+    if CDP_EXPECT(hash)
+        return hash;
+
+    const void* content = (data->datatype <= CDP_DATATYPE_DATA)?  cdp_data(data):  NULL;
+    hash = cdp_hash64(content, content? data->size: 0, 0);
+    if (!hash)
+        hash = 1;       // Zero means "not computed yet".
+    __atomic_store_n(&data->hash, hash, __ATOMIC_RELAXED);
+    return hash;
+}
+
+
+/*
+    Data interning
+*/
+#define DATA_INTERN_MIN     64
+
+static inline void data_intern_lock(void) {
+    while (atomic_flag_test_and_set_explicit(&DATA_INTERN.lock, memory_order_acquire));
+}
+#define data_intern_unlock()    atomic_flag_clear_explicit(&DATA_INTERN.lock, memory_order_release)
+
+
+static inline uint64_t data_intern_hash(cdpData* data) {
+    return cdp_data_hash(data) ^ cdp_dt_hash(&data->_dt) ^ ((data->encoding + data->size) * 0x9E3779B97F4A7C15ULL);
+}
+
+
+static inline bool data_intern_equal(const cdpData* a, const cdpData* b) {
+    return a->domain == b->domain  &&  a->tag == b->tag  &&  a->datatype == b->datatype
+        && a->encoding == b->encoding  &&  a->attribute._id == b->attribute._id
+        && a->size == b->size  &&  !memcmp(cdp_data(a), cdp_data(b), a->size);
+}
+
+
+static inline void data_intern_put(cdpData** slot, size_t mask, cdpData* data) {
+    size_t i = data_intern_hash(data) & mask;
+    while (slot[i])
+        i = (i + 1) & mask;
+    slot[i] = data;
+}
+
+
+static bool data_intern_grow(void) {
+    size_t capacity = DATA_INTERN.capacity?  (DATA_INTERN.capacity << 1):  DATA_INTERN_MIN;
+    cdpData** slot = cdp_try_malloc0(capacity * sizeof(cdpData*));
+    if CDP_RARELY(!slot)
+        return false;
+    for (size_t n = 0;  n < DATA_INTERN.capacity;  n++) {
+        if (DATA_INTERN.slot[n])
+            data_intern_put(slot, capacity - 1, DATA_INTERN.slot[n]);
+    }
+    cdp_free(DATA_INTERN.slot);
+    DATA_INTERN.slot     = slot;
+    DATA_INTERN.capacity = capacity;
+    return true;
+}
+
+
+static void data_intern_remove(cdpData* data) {
+    size_t mask = DATA_INTERN.capacity - 1;
+    size_t i = data_intern_hash(data) & mask;
+    while (DATA_INTERN.slot[i] != data) {
+        assert(DATA_INTERN.slot[i]);
+        i = (i + 1) & mask;
+    }
+
+    // Shifts back the entries probed past it (so no tombstones are needed).
+    for (size_t j = (i + 1) & mask;  DATA_INTERN.slot[j];  j = (j + 1) & mask) {
+        size_t home = data_intern_hash(DATA_INTERN.slot[j]) & mask;
+        if (((j - home) & mask)  >=  ((j - i) & mask)) {
+            DATA_INTERN.slot[i] = DATA_INTERN.slot[j];
+            i = j;
+        }
+    }
+    DATA_INTERN.slot[i] = NULL;
+    DATA_INTERN.count--;
+}
+
+
+static bool data_intern_release(cdpData* data) {
+    // Interned data may be found again at any time, so it is only dropped inside the lock.
+    data_intern_lock();
+    bool last = (1 == __atomic_fetch_sub(&data->refs, 1, __ATOMIC_ACQ_REL));
+    if (last)
+        data_intern_remove(data);
+    data_intern_unlock();
+    return last;
+}
+
+
+/*
+   Interns read-only data: returns the (shared) data already interned with
+   the same DT, encoding, attribute and content (deleting the given one),
+   or else interns the given one. Entries go away with their last user.
+*/
+cdpData* cdp_data_intern(cdpData* data) {
+    if (!data)
+        return NULL;
+    assert(cdp_data_valid(data) && !cdp_data_is_shared(data));
+    if (data->interned)
+        return data;
+    if (data->datatype > CDP_DATATYPE_DATA)
+        return data;        // Only content is interned.
+
+    data->writable = false;
+    uint64_t hash = data_intern_hash(data);
+
+    data_intern_lock();
+    if (DATA_INTERN.capacity) {
+        size_t mask = DATA_INTERN.capacity - 1;
+        for (size_t i = hash & mask;  DATA_INTERN.slot[i];  i = (i + 1) & mask) {
+            cdpData* found = DATA_INTERN.slot[i];
+            if (data_intern_equal(found, data)) {
+                __atomic_fetch_add(&found->refs, 1, __ATOMIC_RELAXED);
+                data_intern_unlock();
+                cdp_data_del(data);
+                return found;
+            }
+        }
+    }
+    if ((DATA_INTERN.count + 1) * 4  >  DATA_INTERN.capacity * 3) {
+        if CDP_RARELY(!data_intern_grow()) {
+            data_intern_unlock();
+            return data;    // Out of memory: just not interned.
+        }
+    }
+    data_intern_put(DATA_INTERN.slot, DATA_INTERN.capacity - 1, data);
+    DATA_INTERN.count++;
+    data->interned = true;
+    data_intern_unlock();
+    return data;
+}
+
+
+size_t cdp_data_interned_count(void) {
+    return __atomic_load_n(&DATA_INTERN.count, __ATOMIC_RELAXED);
+}
+
+
+/*
+   Makes a private copy of shared data (with room for 'capacity' bytes)
+*/
+static cdpData* data_unshare(cdpData* data, size_t capacity, bool swap) {
+    cdpData* copy;
+
+    if (data->datatype == CDP_DATATYPE_VALUE) {
+        size_t dmax = cdp_max(data->capacity, capacity);
+        copy = slab_try_alloc(DATA_HEAD_SIZE + dmax);
+        if CDP_RARELY(!copy)
+            return NULL;
+        memcpy(copy, data, DATA_HEAD_SIZE + data->size);
+        copy->capacity = dmax;
+    } else {
+        assert(data->datatype == CDP_DATATYPE_DATA);
+        copy = slab_try_new_item(cdpData);
+        if CDP_RARELY(!copy)
+            return NULL;
+        *copy = *data;
+        if (swap) {
+            copy->data = NULL;      // The swapped in buffer takes its place (same destructor).
+        } else {
+            size_t dmax = cdp_max(data->capacity, capacity);
+            copy->data = cdp_try_malloc(dmax);
+            if CDP_RARELY(!copy->data) {
+                slab_del_item(cdpData, copy);
+                return NULL;
+            }
+            memcpy(copy->data, data->data, data->size);
+            copy->capacity   = dmax;
+            copy->destructor = cdp_free;
+        }
+    }
+    copy->next     = NULL;
+    copy->refs     = 1;
+    copy->interned = false;
+
+    cdp_data_del(data);     // One less sharing the original.
+    return copy;
 }
 
 
@@ -262,13 +588,14 @@ static inline void* cdp_data_update(cdpData* data, size_t size, size_t capacity,
         assert(data->capacity >= capacity);
         memcpy(data->value, value, size);
         data->size = size;
+        cdp_data_hash_reset(data);
         return data->value;
       }
 
       case CDP_DATATYPE_DATA: {
         assert(value);
         if (swap) {
-            if (data->destructor)
+            if (data->destructor && data->data)
                 data->destructor(data->data);
             data->data     = value;
             data->capacity = capacity;
@@ -277,6 +604,7 @@ static inline void* cdp_data_update(cdpData* data, size_t size, size_t capacity,
             memcpy(data->data, value, size);
         }
         data->size = size;
+        cdp_data_hash_reset(data);
         return data->data;
       }
 
@@ -293,9 +621,83 @@ static inline void* cdp_data_update(cdpData* data, size_t size, size_t capacity,
 
 
 
+/*
+    Name membership filter
+
+    A blocked Bloom filter over the children names of an (unsorted) store:
+    both bits of a name fall in the same 64-bit word, so probing costs a
+    single memory access and absent names skip the linear scan. Bits of
+    removed names can't be cleared, so the filter is rebuilt from the
+    children once most of what it holds is stale (or once it's too full).
+*/
+struct _cdpStoreFilter {
+    size_t      words;      // Filter size in 64-bit words (a power of two).
+    size_t      names;      // Names set since the last rebuild.
+    size_t      stale;      // Names removed since the last rebuild (their bits are still set).
+    uint64_t    word[];
+};
+
+#define STORE_FILTER_MIN_WORDS      2
+#define STORE_FILTER_WORD_NAMES     4       // Names per word before growing (16 bits per name).
+
+static void store_filter_rebuild(cdpStore* store);
+
+
+static inline uint64_t store_filter_mask(uint64_t hash) {
+    // Bit positions come from the high hash bits (the low ones select the word).
+    return (UINT64_C(1) << ((hash >> 52) & 63))  |  (UINT64_C(1) << (hash >> 58));
+}
+
+
+static inline void store_filter_set(cdpStoreFilter* filter, const cdpDT* name) {
+    uint64_t hash = cdp_dt_hash(name);
+    filter->word[hash & (filter->words - 1)] |= store_filter_mask(hash);
+    filter->names++;
+}
+
+
+static inline bool store_filter_test(const cdpStoreFilter* filter, const cdpDT* name) {
+    uint64_t hash = cdp_dt_hash(name);
+    uint64_t mask = store_filter_mask(hash);
+    return mask == (filter->word[hash & (filter->words - 1)] & mask);
+}
+
+
+static inline void store_filter_add(cdpStore* store, const cdpRecord* child) {
+    cdpStoreFilter* filter = store->filter;
+    store_filter_set(filter, cdp_record_get_name(child));
+    if (filter->names > filter->words * STORE_FILTER_WORD_NAMES)
+        store_filter_rebuild(store);        // Grow it.
+}
+
+
+static inline void store_filter_remove(cdpStore* store) {
+    cdpStoreFilter* filter = store->filter;
+    filter->stale++;
+    if ((filter->stale << 1) > filter->names)
+        store_filter_rebuild(store);        // Mostly stale.
+}
+
+
 /*
     Creates a new child store for records
 */
+#define STORE_PROFILE(store, counter)   do{ if CDP_RARELY((store)->profile) __atomic_add_fetch(&(store)->profile->counter, 1, __ATOMIC_RELAXED); }while(0)     /* Shared stores are profiled from several threads. */
+#define STORE_CHILDREN(store)           __atomic_load_n(&(store)->chdCount, __ATOMIC_RELAXED)      /* Shared stores update it from several threads. */
+
+static uint64_t STORE_GENERATION;       // Above the last generation of every deleted store (new stores start there).
+
+#define STORE_TOUCH(store)              __atomic_add_fetch(&(store)->generation, 1, __ATOMIC_RELEASE)
+#define STORE_GENERATION_OF(store)      __atomic_load_n(&(store)->generation, __ATOMIC_ACQUIRE)
+
+static inline void store_generation_retire(cdpStore* store) {
+    // A new store may take the address of this one: it must not repeat any of its generations.
+    uint64_t next = STORE_GENERATION_OF(store) + 1;
+    uint64_t seen = __atomic_load_n(&STORE_GENERATION, __ATOMIC_RELAXED);
+    while (seen < next  &&  !__atomic_compare_exchange_n(&STORE_GENERATION, &seen, next, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+
 cdpStore* cdp_store_new(cdpDT* dt, unsigned storage, unsigned indexing, ...) {
     assert(cdp_dt_valid(dt) && (storage < CDP_STORAGE_COUNT) && (indexing < CDP_INDEX_COUNT));
 
@@ -335,17 +737,48 @@ cdpStore* cdp_store_new(cdpDT* dt, unsigned storage, unsigned indexing, ...) {
         store = (cdpStore*) octree_new(&bound);
         break;
       }
+      case CDP_STORAGE_HASH_TABLE: {
+        size_t capacity = va_arg(args, size_t);
+        assert(capacity  &&  (indexing == CDP_INDEX_BY_NAME  ||  indexing == CDP_INDEX_BY_HASH));
+        store = (cdpStore*) hash_table_new(capacity);
+        break;
+      }
+      case CDP_STORAGE_BTREE: {
+        assert(indexing != CDP_INDEX_BY_INSERTION);
+        store = (cdpStore*) btree_new();
+        break;
+      }
+      case CDP_STORAGE_SKIPLIST: {
+        assert(indexing != CDP_INDEX_BY_INSERTION);
+        store = (cdpStore*) skiplist_new();
+        break;
+      }
+      case CDP_STORAGE_ART: {
+        assert(indexing == CDP_INDEX_BY_NAME);
+        store = (cdpStore*) art_new();
+        break;
+      }
+      case CDP_STORAGE_INLINE: {
+        size_t capacity = va_arg(args, size_t);
+        store = (cdpStore*) inline_new(capacity);
+        break;
+      }
     }
 
     if (indexing == CDP_INDEX_BY_FUNCTION
      || indexing == CDP_INDEX_BY_HASH) {
         cdpCompare compare = va_arg(args, cdpCompare);
         assert(compare);
-        store->compare = compare;
+        if CDP_EXPECT_PTR(store)
+            store->compare = compare;
     }
 
     va_end(args);
 
+    if CDP_RARELY(!store)
+        return NULL;        // Out of memory.
+
+    store->generation = __atomic_load_n(&STORE_GENERATION, __ATOMIC_RELAXED);
     store->domain   = dt->domain;
     store->tag      = dt->tag;
     store->storage  = storage;
@@ -362,6 +795,12 @@ void cdp_store_del(cdpStore* store) {
 
     // ToDo: cleanup shadows.
 
+    cdpArena* arena = store->arena;     // Whatever the branch left in it goes at once.
+
+    store_generation_retire(store);
+    cdp_free(store->profile);
+    cdp_free(store->filter);
+
     switch (store->storage) {
       case CDP_STORAGE_LINKED_LIST: {
         list_del_all_children((cdpList*) store);
@@ -388,7 +827,35 @@ void cdp_store_del(cdpStore* store) {
         octree_del((cdpOctree*) store);
         break;
       }
+      case CDP_STORAGE_HASH_TABLE: {
+        hash_table_del_all_children((cdpHashTable*) store);
+        hash_table_del((cdpHashTable*) store);
+        break;
+      }
+      case CDP_STORAGE_BTREE: {
+        btree_del_all_children((cdpBTree*) store);
+        btree_del((cdpBTree*) store);
+        break;
+      }
+      case CDP_STORAGE_SKIPLIST: {
+        skiplist_del_all_children((cdpSkipList*) store);
+        skiplist_del((cdpSkipList*) store);
+        break;
+      }
+      case CDP_STORAGE_ART: {
+        art_del_all_children((cdpArt*) store);
+        art_del((cdpArt*) store);
+        break;
+      }
+      case CDP_STORAGE_INLINE: {
+        inline_del_all_children((cdpInline*) store);
+        inline_del((cdpInline*) store);
+        break;
+      }
     }
+
+    if (arena)
+        slab_arena_del(arena);
 }
 
 
@@ -416,10 +883,34 @@ void cdp_store_delete_children(cdpStore* store) {
         octree_del_all_children((cdpOctree*) store);
         break;
       }
+      case CDP_STORAGE_HASH_TABLE: {
+        hash_table_del_all_children((cdpHashTable*) store);
+        break;
+      }
+      case CDP_STORAGE_BTREE: {
+        btree_del_all_children((cdpBTree*) store);
+        break;
+      }
+      case CDP_STORAGE_SKIPLIST: {
+        skiplist_del_all_children((cdpSkipList*) store);
+        break;
+      }
+      case CDP_STORAGE_ART: {
+        art_del_all_children((cdpArt*) store);
+        break;
+      }
+      case CDP_STORAGE_INLINE: {
+        inline_del_all_children((cdpInline*) store);
+        break;
+      }
     }
 
     store->chdCount = 0;
     store->autoid   = 1;
+    STORE_TOUCH(store);
+
+    if (store->filter)
+        store_filter_rebuild(store);
 }
 
 
@@ -434,6 +925,40 @@ static inline void store_check_auto_id(cdpStore* store, cdpRecord* child) {
 }
 
 
+/*
+    Moves the children of a full inline store into a regular array
+*/
+static inline cdpStore* store_inline_promote(cdpStore* store) {
+    cdpRecord* owner = store->owner;
+    assert(owner  &&  owner->store == store);
+    if CDP_RARELY(!cdp_record_convert_storage(owner, CDP_STORAGE_ARRAY))
+        return NULL;
+    return owner->store;
+}
+
+
+/*
+    Adds a child to a skip list (which may be shared by several threads)
+*/
+static inline cdpRecord* store_skiplist_add(cdpStore* store, cdpRecord* child, cdpCompare compare, void* context) {
+    if (cdp_record_id_is_pending(child))
+        child->metarecord.tag = cdp_id_to_numeric(__atomic_fetch_add(&store->autoid, 1, __ATOMIC_RELAXED));
+
+    cdpRecord* record = skiplist_insert((cdpSkipList*) store, child, compare, context);
+    if (!record) {
+        // Already there (or out of memory): the copy is discarded (as it would be once added).
+        cdp_record_finalize(child);
+        CDP_0(child);
+        return NULL;
+    }
+
+    CDP_0(child);
+    __atomic_add_fetch(&store->chdCount, 1, __ATOMIC_RELAXED);
+    STORE_TOUCH(store);
+    return record;
+}
+
+
 /*
     Adds/inserts a *copy* of the specified record into a store
 */
@@ -443,6 +968,12 @@ cdpRecord* cdp_store_add_child(cdpStore* store, uintptr_t context, cdpRecord* ch
     if (!store->writable)
         return NULL;
 
+    if (store->storage == CDP_STORAGE_INLINE  &&  inline_is_full((cdpInline*) store)) {
+        store = store_inline_promote(store);
+        if CDP_RARELY(!store)
+            return NULL;
+    }
+
     cdpRecord* record;
 
     switch (store->indexing) {
@@ -450,6 +981,11 @@ cdpRecord* cdp_store_add_child(cdpStore* store, uintptr_t context, cdpRecord* ch
       {
         assert(store->chdCount >= (size_t)context);
 
+        if (!context  ||  (size_t)context == store->chdCount)
+            STORE_PROFILE(store, headTail);
+        else
+            STORE_PROFILE(store, inserts);
+
         switch (store->storage) {
           case CDP_STORAGE_LINKED_LIST: {
             record = list_insert((cdpList*) store, child, (size_t)context);
@@ -459,6 +995,10 @@ cdpRecord* cdp_store_add_child(cdpStore* store, uintptr_t context, cdpRecord* ch
             record = array_insert((cdpArray*) store, child, (size_t)context);
             break;
           }
+          case CDP_STORAGE_INLINE: {
+            record = inline_insert((cdpInline*) store, child, (size_t)context);
+            break;
+          }
           default: {
             assert(store->storage < CDP_STORAGE_PACKED_QUEUE);
             return NULL;
@@ -469,6 +1009,8 @@ cdpRecord* cdp_store_add_child(cdpStore* store, uintptr_t context, cdpRecord* ch
 
       case CDP_INDEX_BY_NAME:
       {
+        STORE_PROFILE(store, inserts);
+
         switch (store->storage) {
           case CDP_STORAGE_LINKED_LIST: {
             record = list_named_insert((cdpList*) store, child);
@@ -482,6 +1024,25 @@ cdpRecord* cdp_store_add_child(cdpStore* store, uintptr_t context, cdpRecord* ch
             record = rb_tree_named_insert((cdpRbTree*) store, child);
             break;
           }
+          case CDP_STORAGE_HASH_TABLE: {
+            record = hash_table_named_insert((cdpHashTable*) store, child);
+            break;
+          }
+          case CDP_STORAGE_BTREE: {
+            record = btree_named_insert((cdpBTree*) store, child);
+            break;
+          }
+          case CDP_STORAGE_SKIPLIST: {
+            return store_skiplist_add(store, child, record_compare_by_name, NULL);
+          }
+          case CDP_STORAGE_ART: {
+            record = art_named_insert((cdpArt*) store, child);
+            break;
+          }
+          case CDP_STORAGE_INLINE: {
+            record = inline_named_insert((cdpInline*) store, child);
+            break;
+          }
           default: {
             assert(store->indexing != CDP_INDEX_BY_NAME);
             return NULL;
@@ -493,13 +1054,23 @@ cdpRecord* cdp_store_add_child(cdpStore* store, uintptr_t context, cdpRecord* ch
       case CDP_INDEX_BY_FUNCTION:
       case CDP_INDEX_BY_HASH:
       {
+        STORE_PROFILE(store, inserts);
+
+        cdpCompare compare = store->compare;
+        cdpHashCompare byHash = {compare, (void*)context};
+        void* cmpContext = (void*)context;
+        if (STORE_SORTS_BY_HASH(store)) {
+            compare    = record_compare_by_hash;
+            cmpContext = &byHash;
+        }
+
         switch (store->storage) {
           case CDP_STORAGE_LINKED_LIST: {
-            record = list_sorted_insert((cdpList*) store, child, store->compare, (void*)context);
+            record = list_sorted_insert((cdpList*) store, child, compare, cmpContext);
             break;
           }
           case CDP_STORAGE_ARRAY: {
-            record = array_sorted_insert((cdpArray*) store, child, store->compare, (void*)context);
+            record = array_sorted_insert((cdpArray*) store, child, compare, cmpContext);
             break;
           }
           case CDP_STORAGE_PACKED_QUEUE: {
@@ -507,25 +1078,59 @@ cdpRecord* cdp_store_add_child(cdpStore* store, uintptr_t context, cdpRecord* ch
             return NULL;
           }
           case CDP_STORAGE_RED_BLACK_T: {
-            record = rb_tree_sorted_insert((cdpRbTree*) store, child, store->compare, (void*)context);
+            record = rb_tree_sorted_insert((cdpRbTree*) store, child, compare, cmpContext);
             break;
           }
           case CDP_STORAGE_OCTREE: {
             record = octree_sorted_insert((cdpOctree*) store, child, store->compare, (void*)context);
             break;
           }
+          case CDP_STORAGE_HASH_TABLE: {
+            if (store->indexing != CDP_INDEX_BY_HASH) {
+                assert(store->indexing == CDP_INDEX_BY_HASH);
+                return NULL;
+            }
+            record = hash_table_hashed_insert((cdpHashTable*) store, child, store->compare, (void*)context);
+            break;
+          }
+          case CDP_STORAGE_BTREE: {
+            record = btree_sorted_insert((cdpBTree*) store, child, compare, cmpContext);
+            break;
+          }
+          case CDP_STORAGE_SKIPLIST: {
+            return store_skiplist_add(store, child, compare, cmpContext);
+          }
+          case CDP_STORAGE_ART: {
+            assert(store->storage != CDP_STORAGE_ART);    // Only names are indexed.
+            return NULL;
+          }
+          case CDP_STORAGE_INLINE: {
+            record = inline_sorted_insert((cdpInline*) store, child, compare, cmpContext);
+            break;
+          }
+          default: {
+            assert(store->storage < CDP_STORAGE_COUNT);
+            return NULL;
+          }
         }
         break;
       }
     }
 
+    if CDP_RARELY(!record)
+        return NULL;        // Out of memory (child is left as it was).
+
     store_check_auto_id(store, record);
 
     //cdp_record_transfer(child, record);
     CDP_0(child);      // This avoids deleting children during move operations.
 
-    record->parent = store;
+    store_child_adopt(store, record);
     store->chdCount++;
+    STORE_TOUCH(store);
+
+    if (store->filter)
+        store_filter_add(store, record);
 
     return record;
 }
@@ -540,6 +1145,12 @@ cdpRecord* cdp_store_append_child(cdpStore* store, bool prepend, cdpRecord* chil
     if (!store->writable)
         return NULL;
 
+    if (store->storage == CDP_STORAGE_INLINE  &&  inline_is_full((cdpInline*) store)) {
+        store = store_inline_promote(store);
+        if CDP_RARELY(!store)
+            return NULL;
+    }
+
     cdpRecord* record;
 
     if (store->indexing != CDP_INDEX_BY_INSERTION) {
@@ -547,6 +1158,8 @@ cdpRecord* cdp_store_append_child(cdpStore* store, bool prepend, cdpRecord* chil
         return NULL;
     }
 
+    STORE_PROFILE(store, headTail);
+
     switch (store->storage) {
       case CDP_STORAGE_LINKED_LIST: {
         record = list_append((cdpList*) store, child, prepend);
@@ -560,63 +1173,319 @@ cdpRecord* cdp_store_append_child(cdpStore* store, bool prepend, cdpRecord* chil
         record = packed_q_append((cdpPackedQ*) store, child, prepend);
         break;
       }
+      case CDP_STORAGE_INLINE: {
+        record = inline_append((cdpInline*) store, child, prepend);
+        break;
+      }
       default: {
         assert(store->storage < CDP_STORAGE_RED_BLACK_T);
         return NULL;
       }
     }
 
+    if CDP_RARELY(!record)
+        return NULL;
+
     store_check_auto_id(store, record);
 
     //cdp_record_transfer(child, record);
     CDP_0(child);
 
-    record->parent = store;
+    store_child_adopt(store, record);
     store->chdCount++;
+    STORE_TOUCH(store);
+
+    if (store->filter)
+        store_filter_add(store, record);
 
     return record;
 }
 
 
 /*
-    Gets the first child record from store
+    Enables (or disables) the name membership filter of an unsorted store
 */
-static inline cdpRecord* store_first_child(const cdpStore* store) {
-    assert(cdp_store_valid(store));
-
-    if (!store->chdCount)
-        return NULL;
-
-    switch (store->storage) {
-      case CDP_STORAGE_LINKED_LIST: {
-        return list_first((cdpList*) store);
-      }
-      case CDP_STORAGE_ARRAY: {
-        return array_first((cdpArray*) store);
-      }
-      case CDP_STORAGE_PACKED_QUEUE: {
-        return packed_q_first((cdpPackedQ*) store);
-      }
-      case CDP_STORAGE_RED_BLACK_T: {
-        return rb_tree_first((cdpRbTree*) store);
-      }
-      case CDP_STORAGE_OCTREE: {
-        return octree_first((cdpOctree*) store);
-      }
+void cdp_store_filter(cdpStore* store, bool enable) {
+    assert(cdp_store_valid(store) && store->indexing == CDP_INDEX_BY_INSERTION);
+
+    if (enable) {
+        if (!store->filter)
+            store_filter_rebuild(store);
+    } else if (store->filter) {
+        cdp_free(store->filter);
+        store->filter = NULL;
     }
-    return NULL;
 }
 
 
 /*
-    Gets the last child record from store
+    Enables (or disables) access profiling of a store
 */
-static inline cdpRecord* store_last_child(const cdpStore* store) {
+void cdp_store_profile(cdpStore* store, bool enable) {
     assert(cdp_store_valid(store));
 
-    if (!store->chdCount)
+    if (enable) {
+        if (!store->profile)
+            store->profile = cdp_malloc0(sizeof(cdpStoreProfile));
+    } else if (store->profile) {
+        cdp_free(store->profile);
+        store->profile = NULL;
+    }
+}
+
+
+static inline size_t store_profile_total(const cdpStoreProfile* profile) {
+    return profile->inserts + profile->headTail + profile->lookups + profile->positional + profile->traversals;
+}
+
+static inline void store_profile_read(const cdpStoreProfile* profile, cdpStoreProfile* copy) {
+    // Counters may be bumping meanwhile (each one is read on its own).
+    copy->inserts    = __atomic_load_n(&profile->inserts,    __ATOMIC_RELAXED);
+    copy->headTail   = __atomic_load_n(&profile->headTail,   __ATOMIC_RELAXED);
+    copy->lookups    = __atomic_load_n(&profile->lookups,    __ATOMIC_RELAXED);
+    copy->positional = __atomic_load_n(&profile->positional, __ATOMIC_RELAXED);
+    copy->traversals = __atomic_load_n(&profile->traversals, __ATOMIC_RELAXED);
+}
+
+static inline void store_profile_clear(cdpStoreProfile* profile) {
+    __atomic_store_n(&profile->inserts,    0, __ATOMIC_RELAXED);
+    __atomic_store_n(&profile->headTail,   0, __ATOMIC_RELAXED);
+    __atomic_store_n(&profile->lookups,    0, __ATOMIC_RELAXED);
+    __atomic_store_n(&profile->positional, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&profile->traversals, 0, __ATOMIC_RELAXED);
+}
+
+
+/*
+    Suggests the storage that best suits the observed access pattern
+*/
+unsigned cdp_store_advise(const cdpStore* store, const cdpStoreTuning* tuning) {
+    assert(cdp_store_valid(store));
+
+    if (!store->profile  ||  store->storage > CDP_STORAGE_RED_BLACK_T)
+        return store->storage;      // Only general purpose storages are switched.
+    cdpStoreProfile counted;
+    store_profile_read(store->profile, &counted);
+    const cdpStoreProfile* profile = &counted;
+
+    cdpStoreTuning defaults = CDP_STORE_TUNING_DEFAULT;
+    if (!tuning)
+        tuning = &defaults;
+
+    size_t total = store_profile_total(profile);
+    if (total < tuning->minOps)
+        return store->storage;
+
+    switch (store->indexing) {
+      case CDP_INDEX_BY_INSERTION: {
+        if (profile->positional * 100  >=  total * tuning->positional)
+            return CDP_STORAGE_ARRAY;
+        if (!profile->inserts  &&  (profile->headTail * 100  >=  total * tuning->headTail))
+            return CDP_STORAGE_PACKED_QUEUE;
+        return CDP_STORAGE_LINKED_LIST;
+      }
+      case CDP_INDEX_BY_NAME:
+      case CDP_INDEX_BY_FUNCTION: {
+        if (store->chdCount > tuning->treeChildren  &&  (profile->positional * 100  <  total * tuning->positional))
+            return CDP_STORAGE_RED_BLACK_T;
+        return CDP_STORAGE_ARRAY;
+      }
+    }
+
+    return store->storage;
+}
+
+
+/*
+    Lets a packed queue share its spare chunks through a pool
+*/
+void cdp_store_share_chunks(cdpStore* store, bool shared) {
+    assert(cdp_store_valid(store) && store->storage == CDP_STORAGE_PACKED_QUEUE);
+    ((cdpPackedQ*) store)->shared = shared;
+}
+
+
+/*
+    Sets how many records an octree leaf takes before splitting and how deep it may go
+*/
+void cdp_store_octree_limits(cdpStore* store, unsigned leafCapacity, unsigned maxDepth) {
+    assert(cdp_store_valid(store) && store->storage == CDP_STORAGE_OCTREE && leafCapacity && maxDepth);
+    cdpOctree* octree = (cdpOctree*) store;
+    octree->leafCap  = leafCapacity;
+    octree->maxDepth = maxDepth;
+}
+
+
+/*
+    Registers the calling thread as a (possible) reader of shared stores
+*/
+void cdp_store_thread_online(void) {
+    skiplist_thread_online();
+}
+
+
+/*
+    Tells that the calling thread won't touch shared stores until online again
+*/
+void cdp_store_thread_offline(void) {
+    skiplist_thread_offline();
+    slab_thread_flush();
+}
+
+
+/*
+    Tells that the calling thread holds no child of a shared store right now
+*/
+void cdp_store_quiescent(void) {
+    skiplist_quiescent();
+}
+
+
+/*
+    Creates an arena for building a branch whose records die together
+*/
+cdpArena* cdp_arena_new(void) {
+    CDP_NEW(cdpArena, arena);
+    return arena;
+}
+
+
+/*
+    Frees every slab of an arena (and whatever was still in them)
+*/
+void cdp_arena_del(cdpArena* arena) {
+    assert(arena);
+    slab_arena_del(arena);
+}
+
+
+/*
+    Makes the calling thread allocate stores, nodes and data from an arena
+*/
+cdpArena* cdp_arena_use(cdpArena* arena) {
+    cdpArena* previous = SLAB_ARENA;
+    SLAB_ARENA = arena;
+    return previous;
+}
+
+
+/*
+    Hands an arena to the store at the root of the branch built with it
+*/
+void cdp_store_arena(cdpStore* store, cdpArena* arena) {
+    assert(cdp_store_valid(store) && !store->arena);
+    store->arena = arena;
+}
+
+
+/*
+    Gets how many slabs are taken from the heap
+*/
+void cdp_slab_stats(cdpSlabStats* stats) {
+    assert(stats);
+    stats->slabs      = __atomic_load_n(&SLAB_STATS.slabs, __ATOMIC_RELAXED);
+    stats->arenaSlabs = __atomic_load_n(&SLAB_STATS.arenaSlabs, __ATOMIC_RELAXED);
+}
+
+
+/*
+    Returns the free items cached by the calling thread to their slabs
+*/
+void cdp_slab_flush(void) {
+    slab_thread_flush();
+}
+
+
+/*
+    Gets chunk recycling counters of a packed queue (or of all of them)
+*/
+void cdp_store_chunk_stats(const cdpStore* store, cdpChunkStats* stats) {
+    assert(stats);
+    if (store) {
+        assert(cdp_store_valid(store) && store->storage == CDP_STORAGE_PACKED_QUEUE);
+        cdpPackedQ* pkdq = (cdpPackedQ*) store;
+        *stats = pkdq->stats;
+        stats->spare = pkdq->spares;
+    } else {
+        *stats = PACKED_Q_TOTALS;
+    }
+}
+
+
+/*
+    Returns all idle chunks in the shared pool to the heap
+*/
+void cdp_store_chunk_pool_flush(void) {
+    packed_q_pool_flush();
+}
+
+
+/*
+    Gets the first child record from store (without profiling the access)
+*/
+static inline cdpRecord* store_peek_first(const cdpStore* store) {
+    assert(cdp_store_valid(store));
+
+    if (!STORE_CHILDREN(store))
+        return NULL;
+
+    switch (store->storage) {
+      case CDP_STORAGE_LINKED_LIST: {
+        return list_first((cdpList*) store);
+      }
+      case CDP_STORAGE_ARRAY: {
+        return array_first((cdpArray*) store);
+      }
+      case CDP_STORAGE_PACKED_QUEUE: {
+        return packed_q_first((cdpPackedQ*) store);
+      }
+      case CDP_STORAGE_RED_BLACK_T: {
+        return rb_tree_first((cdpRbTree*) store);
+      }
+      case CDP_STORAGE_OCTREE: {
+        return octree_first((cdpOctree*) store);
+      }
+      case CDP_STORAGE_HASH_TABLE: {
+        return hash_table_first((cdpHashTable*) store);
+      }
+      case CDP_STORAGE_BTREE: {
+        return btree_first((cdpBTree*) store);
+      }
+      case CDP_STORAGE_SKIPLIST: {
+        return skiplist_first((cdpSkipList*) store);
+      }
+      case CDP_STORAGE_ART: {
+        return art_first((cdpArt*) store);
+      }
+      case CDP_STORAGE_INLINE: {
+        return inline_first((cdpInline*) store);
+      }
+    }
+    return NULL;
+}
+
+
+/*
+    Gets the first child record from store
+*/
+static inline cdpRecord* store_first_child(const cdpStore* store) {
+    if (STORE_CHILDREN(store))
+        STORE_PROFILE(store, headTail);
+    return store_peek_first(store);
+}
+
+
+/*
+    Gets the last child record from store
+*/
+static inline cdpRecord* store_last_child(const cdpStore* store) {
+    assert(cdp_store_valid(store));
+
+    if (!STORE_CHILDREN(store))
         return NULL;
 
+    STORE_PROFILE(store, headTail);
+
     switch (store->storage) {
       case CDP_STORAGE_LINKED_LIST: {
         return list_last((cdpList*) store);
@@ -633,6 +1502,21 @@ static inline cdpRecord* store_last_child(const cdpStore* store) {
       case CDP_STORAGE_OCTREE: {
         return octree_last((cdpOctree*) store);
       }
+      case CDP_STORAGE_HASH_TABLE: {
+        return hash_table_last((cdpHashTable*) store);
+      }
+      case CDP_STORAGE_BTREE: {
+        return btree_last((cdpBTree*) store);
+      }
+      case CDP_STORAGE_SKIPLIST: {
+        return skiplist_last((cdpSkipList*) store);
+      }
+      case CDP_STORAGE_ART: {
+        return art_last((cdpArt*) store);
+      }
+      case CDP_STORAGE_INLINE: {
+        return inline_last((cdpInline*) store);
+      }
     }
     return NULL;
 }
@@ -644,7 +1528,12 @@ static inline cdpRecord* store_last_child(const cdpStore* store) {
 static inline cdpRecord* store_find_child_by_name(const cdpStore* store, const cdpDT* name) {
     assert(cdp_store_valid(store) && cdp_dt_valid(name));
 
-    if (!store->chdCount)
+    if (!STORE_CHILDREN(store))
+        return NULL;
+
+    STORE_PROFILE(store, lookups);
+
+    if (store->filter  &&  !store_filter_test(store->filter, name))
         return NULL;
 
     switch (store->storage) {
@@ -663,6 +1552,21 @@ static inline cdpRecord* store_find_child_by_name(const cdpStore* store, const c
       case CDP_STORAGE_OCTREE: {
         return octree_find_by_name((cdpOctree*) store, name);
       }
+      case CDP_STORAGE_HASH_TABLE: {
+        return hash_table_find_by_name((cdpHashTable*) store, name);
+      }
+      case CDP_STORAGE_BTREE: {
+        return btree_find_by_name((cdpBTree*) store, name);
+      }
+      case CDP_STORAGE_SKIPLIST: {
+        return skiplist_find_by_name((cdpSkipList*) store, name);
+      }
+      case CDP_STORAGE_ART: {
+        return art_find_by_name((cdpArt*) store, name);
+      }
+      case CDP_STORAGE_INLINE: {
+        return inline_find_by_name((cdpInline*) store, name);
+      }
     }
     return NULL;
 }
@@ -675,9 +1579,17 @@ static inline cdpRecord* store_find_child_by_name(const cdpStore* store, const c
 static inline cdpRecord* store_find_child_by_key(const cdpStore* store, cdpRecord* key, cdpCompare compare, void* context) {
     assert(cdp_store_valid(store) && !cdp_record_is_void(key) && compare);
 
-    if (!store->chdCount)
+    if (!STORE_CHILDREN(store))
         return NULL;
 
+    STORE_PROFILE(store, lookups);
+
+    cdpHashCompare byHash = {compare, context};
+    if (STORE_SORTS_BY_HASH(store)) {
+        compare = record_compare_by_hash;
+        context = &byHash;
+    }
+
     switch (store->storage) {
       case CDP_STORAGE_LINKED_LIST: {
         return list_find_by_key((cdpList*) store, key, compare, context);
@@ -695,6 +1607,21 @@ static inline cdpRecord* store_find_child_by_key(const cdpStore* store, cdpRecor
       case CDP_STORAGE_OCTREE: {
         return octree_find_by_key((cdpOctree*) store, key, compare, context);
       }
+      case CDP_STORAGE_HASH_TABLE: {
+        return hash_table_find_by_key((cdpHashTable*) store, key, compare, context);
+      }
+      case CDP_STORAGE_BTREE: {
+        return btree_find_by_key((cdpBTree*) store, key, compare, context);
+      }
+      case CDP_STORAGE_SKIPLIST: {
+        return skiplist_find_by_key((cdpSkipList*) store, key, compare, context);
+      }
+      case CDP_STORAGE_ART: {
+        return art_find_by_key((cdpArt*) store, key, compare, context);
+      }
+      case CDP_STORAGE_INLINE: {
+        return inline_find_by_key((cdpInline*) store, key, compare, context);
+      }
     }
     return NULL;
 }
@@ -706,9 +1633,11 @@ static inline cdpRecord* store_find_child_by_key(const cdpStore* store, cdpRecor
 static inline cdpRecord* store_find_child_by_position(const cdpStore* store, size_t position) {
     assert(cdp_store_valid(store));
 
-    if (store->chdCount <= position)
+    if (STORE_CHILDREN(store) <= position)
         return NULL;
 
+    STORE_PROFILE(store, positional);
+
     switch (store->storage) {
       case CDP_STORAGE_LINKED_LIST: {
         return list_find_by_position((cdpList*) store, position);
@@ -725,6 +1654,21 @@ static inline cdpRecord* store_find_child_by_position(const cdpStore* store, siz
       case CDP_STORAGE_OCTREE: {
         return octree_find_by_position((cdpOctree*) store, position);
       }
+      case CDP_STORAGE_HASH_TABLE: {
+        return hash_table_find_by_position((cdpHashTable*) store, position);
+      }
+      case CDP_STORAGE_BTREE: {
+        return btree_find_by_position((cdpBTree*) store, position);
+      }
+      case CDP_STORAGE_SKIPLIST: {
+        return skiplist_find_by_position((cdpSkipList*) store, position);
+      }
+      case CDP_STORAGE_ART: {
+        return art_find_by_position((cdpArt*) store, position);
+      }
+      case CDP_STORAGE_INLINE: {
+        return inline_find_by_position((cdpInline*) store, position);
+      }
     }
 
     return NULL;
@@ -753,6 +1697,21 @@ static inline cdpRecord* store_prev_child(const cdpStore* store, cdpRecord* chil
       case CDP_STORAGE_OCTREE: {
         return octree_prev(child);
       }
+      case CDP_STORAGE_HASH_TABLE: {
+        return hash_table_prev(child);
+      }
+      case CDP_STORAGE_BTREE: {
+        return btree_prev(child);
+      }
+      case CDP_STORAGE_SKIPLIST: {
+        return skiplist_prev((cdpSkipList*) store, child);
+      }
+      case CDP_STORAGE_ART: {
+        return art_prev(child);
+      }
+      case CDP_STORAGE_INLINE: {
+        return inline_prev((cdpInline*) store, child);
+      }
     }
 
     return NULL;
@@ -781,6 +1740,21 @@ static inline cdpRecord* store_next_child(const cdpStore* store, cdpRecord* chil
       case CDP_STORAGE_OCTREE: {
         return octree_next(child);
       }
+      case CDP_STORAGE_HASH_TABLE: {
+        return hash_table_next(child);
+      }
+      case CDP_STORAGE_BTREE: {
+        return btree_next(child);
+      }
+      case CDP_STORAGE_SKIPLIST: {
+        return skiplist_next(child);
+      }
+      case CDP_STORAGE_ART: {
+        return art_next(child);
+      }
+      case CDP_STORAGE_INLINE: {
+        return inline_next((cdpInline*) store, child);
+      }
     }
 
     return NULL;
@@ -789,13 +1763,57 @@ static inline cdpRecord* store_next_child(const cdpStore* store, cdpRecord* chil
 
 
 
+/*
+    Gets the position of a child record in store
+*/
+static inline size_t store_index_of_child(const cdpStore* store, const cdpRecord* child) {
+    assert(cdp_store_valid(store) && !cdp_record_is_void(child));
+
+    STORE_PROFILE(store, positional);
+
+    switch (store->storage) {
+      case CDP_STORAGE_LINKED_LIST:
+      case CDP_STORAGE_OCTREE:
+      case CDP_STORAGE_HASH_TABLE:
+      case CDP_STORAGE_ART: {
+        break;      // Previous siblings are counted below.
+      }
+      case CDP_STORAGE_ARRAY: {
+        return array_index_of((cdpArray*) store, child);
+      }
+      case CDP_STORAGE_INLINE: {
+        return inline_index_of((cdpInline*) store, child);
+      }
+      case CDP_STORAGE_PACKED_QUEUE: {
+        return packed_q_index_of((cdpPackedQ*) store, child);
+      }
+      case CDP_STORAGE_RED_BLACK_T: {
+        return rb_tree_index_of(child);
+      }
+      case CDP_STORAGE_BTREE: {
+        return btree_index_of(child);
+      }
+      case CDP_STORAGE_SKIPLIST: {
+        return skiplist_index_of((cdpSkipList*) store, child);
+      }
+    }
+
+    size_t index = 0;
+    for (cdpRecord* prev = store_prev_child(store, (cdpRecord*)child);  prev;  prev = store_prev_child(store, prev))
+        index++;
+    return index;
+}
+
+
+
+
 /*
     Retrieves the first/next child record by its ID
 */
 static inline cdpRecord* store_find_next_child_by_name(const cdpStore* store, cdpDT* name, uintptr_t* childIdx) {
     assert(cdp_store_valid(store) && cdp_dt_valid(name));
 
-    if (!store->chdCount)
+    if (!STORE_CHILDREN(store))
         return NULL;
 
     if (store->indexing == CDP_INDEX_BY_NAME  ||  !childIdx) {
@@ -803,6 +1821,11 @@ static inline cdpRecord* store_find_next_child_by_name(const cdpStore* store, cd
         return store_find_child_by_name(store, name);
     }
 
+    if (store->filter  &&  !store_filter_test(store->filter, name)) {
+        *childIdx = 0;
+        return NULL;
+    }
+
     switch (store->storage) {
       case CDP_STORAGE_LINKED_LIST: {
         return list_next_by_name((cdpList*) store, name, (cdpListNode**)childIdx);
@@ -811,13 +1834,29 @@ static inline cdpRecord* store_find_next_child_by_name(const cdpStore* store, cd
         return array_next_by_name((cdpArray*) store, name, childIdx);
       }
       case CDP_STORAGE_PACKED_QUEUE: {
-        return packed_q_next_by_name((cdpPackedQ*) store, name, (cdpPackedQNode**)childIdx);
+        return packed_q_next_by_name((cdpPackedQ*) store, name, childIdx);
       }
       case CDP_STORAGE_RED_BLACK_T: {    // Unused.
         break;
       }
       case CDP_STORAGE_OCTREE: {
         //return octree_next_by_name(store, id, (cdpListNode**)childIdx);
+        break;
+      }
+      case CDP_STORAGE_HASH_TABLE: {
+        return hash_table_next_by_name((cdpHashTable*) store, name, (cdpHashNode**)childIdx);
+      }
+      case CDP_STORAGE_BTREE: {
+        return btree_next_by_name((cdpBTree*) store, name, childIdx);
+      }
+      case CDP_STORAGE_SKIPLIST: {
+        return skiplist_next_by_name((cdpSkipList*) store, name, (cdpSkipNode**)childIdx);
+      }
+      case CDP_STORAGE_ART: {      // Unused.
+        break;
+      }
+      case CDP_STORAGE_INLINE: {
+        return inline_next_by_name((cdpInline*) store, name, childIdx);
       }
     }
 
@@ -831,10 +1870,12 @@ static inline cdpRecord* store_find_next_child_by_name(const cdpStore* store, cd
 static inline bool store_traverse(cdpStore* store, cdpTraverse func, void* context, cdpEntry* entry) {
     assert(cdp_store_valid(store) && func);
 
-    size_t children = store->chdCount;
+    size_t children = STORE_CHILDREN(store);
     if (!children)
         return true;
 
+    STORE_PROFILE(store, traversals);
+
     if (!entry)
         entry = cdp_alloca(sizeof(cdpEntry));
     CDP_0(entry);
@@ -850,27 +1891,61 @@ static inline bool store_traverse(cdpStore* store, cdpTraverse func, void* conte
         return packed_q_traverse((cdpPackedQ*) store, func, context, entry);
       }
       case CDP_STORAGE_RED_BLACK_T: {
-        return rb_tree_traverse((cdpRbTree*) store, cdp_bitson(children) + 2, func, context, entry);
+        return rb_tree_traverse((cdpRbTree*) store, func, context, entry);
       }
       case CDP_STORAGE_OCTREE: {
         return octree_traverse((cdpOctree*) store, func, context, entry);
       }
+      case CDP_STORAGE_HASH_TABLE: {
+        return hash_table_traverse((cdpHashTable*) store, func, context, entry);
+      }
+      case CDP_STORAGE_BTREE: {
+        return btree_traverse((cdpBTree*) store, func, context, entry);
+      }
+      case CDP_STORAGE_SKIPLIST: {
+        return skiplist_traverse((cdpSkipList*) store, func, context, entry);
+      }
+      case CDP_STORAGE_ART: {
+        return art_traverse((cdpArt*) store, func, context, entry);
+      }
+      case CDP_STORAGE_INLINE: {
+        return inline_traverse((cdpInline*) store, func, context, entry);
+      }
     }
 
     return true;
 }
 
 
+/*
+    Rebuilds the name filter from the current children
+*/
+static void store_filter_rebuild(cdpStore* store) {
+    size_t words = cdp_max((size_t)STORE_FILTER_MIN_WORDS, (store->chdCount << 1) / STORE_FILTER_WORD_NAMES);     // Room to double.
+    words = cdp_next_pow_of_two(words);
+
+    cdp_free(store->filter);
+    store->filter = cdp_malloc0(sizeof(cdpStoreFilter) + (words * sizeof(uint64_t)));
+    store->filter->words = words;
+
+    if (!store->chdCount)
+        return;
+    for (cdpRecord* child = store_first_child(store);  child;  child = store_next_child(store, child))
+        store_filter_set(store->filter, cdp_record_get_name(child));
+}
+
+
 /*
     Converts an unsorted store into a dictionary
 */
 static inline void store_to_dictionary(cdpStore* store) {
     assert(cdp_store_valid(store));
 
-    if (store->storage == CDP_INDEX_BY_NAME)
+    if (store->indexing == CDP_INDEX_BY_NAME)
         return;
 
-    store->storage = CDP_INDEX_BY_NAME;
+    store->indexing = CDP_INDEX_BY_NAME;
+    STORE_TOUCH(store);
 
     if (store->chdCount <= 1)
         return;
@@ -895,6 +1970,23 @@ static inline void store_to_dictionary(cdpStore* store) {
         assert(store->storage != CDP_STORAGE_OCTREE);    // Unsupported.
         break;
       }
+      case CDP_STORAGE_HASH_TABLE: {
+        assert(store->storage != CDP_STORAGE_HASH_TABLE);    // Unsupported.
+        break;
+      }
+      case CDP_STORAGE_BTREE: {    // Unneeded.
+        break;
+      }
+      case CDP_STORAGE_SKIPLIST: {   // Unneeded.
+        break;
+      }
+      case CDP_STORAGE_ART: {        // Unneeded.
+        break;
+      }
+      case CDP_STORAGE_INLINE: {
+        inline_sort((cdpInline*) store, record_compare_by_name, NULL);
+        break;
+      }
     }
 }
 
@@ -902,18 +1994,24 @@ static inline void store_to_dictionary(cdpStore* store) {
 /*
     Sorts unsorted store according to a user defined function
 */
-static inline void store_sort(cdpStore* store, cdpCompare compare, void* context) {
+static inline bool store_sort(cdpStore* store, cdpCompare compare, void* context) {
     assert(cdp_store_valid(store) && compare);
 
+    if (store->storage == CDP_STORAGE_HASH_TABLE)
+        return false;   // Hash tables keep no order: the store must be converted (into a sorted storage) first.
+
+    cdpCompare previous = store->compare;
     store->compare = compare;
 
-    if (store->storage == CDP_INDEX_BY_FUNCTION)
-        return;
+    if (store->indexing == CDP_INDEX_BY_FUNCTION)
+        return true;
 
-    store->storage = CDP_INDEX_BY_FUNCTION;   // FixMe: by hash?
+    unsigned indexing = store->indexing;
+    store->indexing = CDP_INDEX_BY_FUNCTION;  // FixMe: by hash?
+    STORE_TOUCH(store);
 
     if (store->chdCount <= 1)
-        return;
+        return true;
 
     switch (store->storage) {
       case CDP_STORAGE_LINKED_LIST: {
@@ -938,7 +2036,43 @@ static inline void store_sort(cdpStore* store, cdpCompare compare, void* context
         assert(store->storage != CDP_STORAGE_OCTREE);
         break;
       }
+      case CDP_STORAGE_BTREE: {
+        if CDP_RARELY(!btree_sort((cdpBTree*) store, compare, context)) {
+            store->indexing = indexing;     // Out of memory: nothing was moved.
+            store->compare  = previous;
+            return false;
+        }
+        break;
+      }
+      case CDP_STORAGE_SKIPLIST: {
+        // Sorting a shared store in place isn't possible.
+        assert(store->storage != CDP_STORAGE_SKIPLIST);
+        break;
+      }
+      case CDP_STORAGE_ART: {
+        // Only names are indexed.
+        assert(store->storage != CDP_STORAGE_ART);
+        break;
+      }
+      case CDP_STORAGE_INLINE: {
+        inline_sort((cdpInline*) store, compare, context);
+        break;
+      }
     }
+
+    return true;
+}
+
+
+/*
+    Discounts a removed child
+*/
+static inline void store_count_removal(cdpStore* store) {
+    if (store->storage == CDP_STORAGE_SKIPLIST)
+        __atomic_sub_fetch(&store->chdCount, 1, __ATOMIC_RELAXED);     // Shared between threads.
+    else
+        store->chdCount--;
+    STORE_TOUCH(store);
 }
 
 
@@ -948,9 +2082,11 @@ static inline void store_sort(cdpStore* store, cdpCompare compare, void* context
 static inline bool store_take_record(cdpStore* store, cdpRecord* target) {
     assert(cdp_store_valid(store) && target);
 
-    if (!store->chdCount || !store->writable)
+    if (!STORE_CHILDREN(store) || !store->writable)
         return NULL;
 
+    STORE_PROFILE(store, headTail);
+
     switch (store->storage) {
       case CDP_STORAGE_LINKED_LIST: {
         list_take((cdpList*) store, target);
@@ -972,9 +2108,34 @@ static inline bool store_take_record(cdpStore* store, cdpRecord* target) {
         octree_take((cdpOctree*) store, target);
         break;
       }
+      case CDP_STORAGE_HASH_TABLE: {
+        hash_table_take((cdpHashTable*) store, target);
+        break;
+      }
+      case CDP_STORAGE_BTREE: {
+        btree_take((cdpBTree*) store, target);
+        break;
+      }
+      case CDP_STORAGE_SKIPLIST: {
+        if (!skiplist_take((cdpSkipList*) store, target))
+            return false;   // Emptied by another thread.
+        break;
+      }
+      case CDP_STORAGE_ART: {
+        art_take((cdpArt*) store, target);
+        break;
+      }
+      case CDP_STORAGE_INLINE: {
+        inline_take((cdpInline*) store, target);
+        break;
+      }
     }
 
-    store->chdCount--;
+    store_child_orphan(store, target);
+    store_count_removal(store);
+
+    if (store->filter)
+        store_filter_remove(store);
 
     return true;
 }
@@ -986,9 +2147,11 @@ static inline bool store_take_record(cdpStore* store, cdpRecord* target) {
 static inline bool store_pop_child(cdpStore* store, cdpRecord* target) {
     assert(cdp_store_valid(store) && target);
 
-    if (!store->chdCount || !store->writable)
+    if (!STORE_CHILDREN(store) || !store->writable)
         return NULL;
 
+    STORE_PROFILE(store, headTail);
+
     switch (store->storage) {
       case CDP_STORAGE_LINKED_LIST: {
         list_pop((cdpList*) store, target);
@@ -1010,9 +2173,34 @@ static inline bool store_pop_child(cdpStore* store, cdpRecord* target) {
         octree_pop((cdpOctree*) store, target);
         break;
       }
+      case CDP_STORAGE_HASH_TABLE: {
+        hash_table_pop((cdpHashTable*) store, target);
+        break;
+      }
+      case CDP_STORAGE_BTREE: {
+        btree_pop((cdpBTree*) store, target);
+        break;
+      }
+      case CDP_STORAGE_SKIPLIST: {
+        if (!skiplist_pop((cdpSkipList*) store, target))
+            return false;
+        break;
+      }
+      case CDP_STORAGE_ART: {
+        art_pop((cdpArt*) store, target);
+        break;
+      }
+      case CDP_STORAGE_INLINE: {
+        inline_pop((cdpInline*) store, target);
+        break;
+      }
     }
 
-    store->chdCount--;
+    store_child_orphan(store, target);
+    store_count_removal(store);
+
+    if (store->filter)
+        store_filter_remove(store);
 
     return true;
 }
@@ -1022,11 +2210,22 @@ static inline bool store_pop_child(cdpStore* store, cdpRecord* target) {
     Deletes a record and all its children re-organizing (sibling) storage
 */
 static inline void store_remove_child(cdpStore* store, cdpRecord* record, cdpRecord* target) {
-    assert(cdp_store_valid(store) && store->chdCount);
+    assert(cdp_store_valid(store) && STORE_CHILDREN(store));
+
+    if (store->storage == CDP_STORAGE_SKIPLIST) {
+        // Concurrent removers race for the record, and only the winner disposes of it.
+        if (skiplist_remove_record((cdpSkipList*) store, record, target)) {
+            if (target)
+                store_child_orphan(store, target);
+            store_count_removal(store);
+        }
+        return;
+    }
 
-    if (target)
+    if (target) {
         cdp_record_transfer(record, target);  // Save record.
-    else
+        store_child_orphan(store, target);
+    } else
         cdp_record_finalize(record);          // Delete record (along children, if any).
 
     // Remove this record from its parent (re-organizing siblings).
@@ -1051,9 +2250,606 @@ static inline void store_remove_child(cdpStore* store, cdpRecord* record, cdpRec
         octree_remove_record((cdpOctree*) store, record);
         break;
       }
+      case CDP_STORAGE_HASH_TABLE: {
+        hash_table_remove_record((cdpHashTable*) store, record);
+        break;
+      }
+      case CDP_STORAGE_BTREE: {
+        btree_remove_record((cdpBTree*) store, record);
+        break;
+      }
+      case CDP_STORAGE_ART: {
+        art_remove_record((cdpArt*) store, record);
+        break;
+      }
+      case CDP_STORAGE_INLINE: {
+        inline_remove_record((cdpInline*) store, record);
+        break;
+      }
     }
 
     store->chdCount--;
+    STORE_TOUCH(store);
+
+    if (store->filter)
+        store_filter_remove(store);
+}
+
+
+
+
+/*
+    Handle implementation
+*/
+#define HANDLE_MIN  64
+
+static inline void handle_lock(void) {
+    while (atomic_flag_test_and_set_explicit(&HANDLES.lock, memory_order_acquire));
+}
+#define handle_unlock()     atomic_flag_clear_explicit(&HANDLES.lock, memory_order_release)
+
+static inline cdpHandleSlot* handle_slot(uint32_t n) {
+    uint32_t high  = n / HANDLE_MIN;
+    unsigned chunk = high?  (32 - __builtin_clz(high)):  0;
+    uint32_t first = chunk?  (HANDLE_MIN << (chunk - 1)):  0;
+    return &HANDLES.chunk[chunk][n - first];
+}
+
+static inline uint32_t handle_home(const cdpRecord* record, uint32_t mask) {
+    return (uint32_t)(((uint64_t)(uintptr_t)record * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+}
+
+
+static inline void handle_index_put(uint32_t* index, uint32_t mask, uint32_t slot) {
+    uint32_t i = handle_home(handle_slot(slot)->record, mask);
+    while (index[i])
+        i = (i + 1) & mask;
+    index[i] = slot + 1;
+}
+
+
+static inline uint32_t handle_index_find(const cdpRecord* record) {
+    // Returns the index entry of a record (or the empty one ending its probe).
+    uint32_t mask = HANDLES.indexCap - 1;
+    uint32_t i = handle_home(record, mask);
+    while (HANDLES.index[i]  &&  handle_slot(HANDLES.index[i] - 1)->record != record)
+        i = (i + 1) & mask;
+    return i;
+}
+
+
+static void handle_index_remove(uint32_t i) {
+    // Shifts back the entries probed past it (so no tombstones are needed).
+    uint32_t mask = HANDLES.indexCap - 1;
+    for (uint32_t j = (i + 1) & mask;  HANDLES.index[j];  j = (j + 1) & mask) {
+        uint32_t home = handle_home(handle_slot(HANDLES.index[j] - 1)->record, mask);
+        if (((j - home) & mask)  >=  ((j - i) & mask)) {
+            HANDLES.index[i] = HANDLES.index[j];
+            i = j;
+        }
+    }
+    HANDLES.index[i] = 0;
+}
+
+
+static uint32_t handle_unkey(const cdpRecord* record) {
+    // Takes a record out of the index, returning its slot (or UINT32_MAX if it has none).
+    if (!HANDLES.indexCap)
+        return UINT32_MAX;
+    uint32_t i = handle_index_find(record);
+    uint32_t entry = HANDLES.index[i];
+    if (!entry)
+        return UINT32_MAX;
+    handle_index_remove(i);
+    return entry - 1;
+}
+
+
+static bool handle_grow(void) {
+    if (HANDLES.free)
+        return true;
+
+    // Slots are added a chunk at a time (doubling them), while the index (kept at most half full) is rebuilt.
+    unsigned chunk = HANDLES.capacity?  (32 - __builtin_clz(HANDLES.capacity / HANDLE_MIN)):  0;
+    if CDP_RARELY(chunk >= HANDLE_CHUNKS)
+        return false;
+    uint32_t capacity = HANDLES.capacity?  (HANDLES.capacity << 1):  HANDLE_MIN;
+    uint32_t* index = cdp_try_malloc0((capacity << 1) * sizeof(uint32_t));
+    if CDP_RARELY(!index)
+        return false;
+    cdpHandleSlot* slot = cdp_try_malloc0((capacity - HANDLES.capacity) * sizeof(cdpHandleSlot));
+    if CDP_RARELY(!slot) {
+        cdp_free(index);
+        return false;
+    }
+    for (uint32_t n = capacity;  n > HANDLES.capacity;  n--) {
+        slot[n - 1 - HANDLES.capacity].next = HANDLES.free;
+        HANDLES.free = n;
+    }
+    HANDLES.chunk[chunk] = slot;
+    for (uint32_t n = 0;  n < HANDLES.indexCap;  n++) {
+        if (HANDLES.index[n])
+            handle_index_put(index, (capacity << 1) - 1, HANDLES.index[n] - 1);
+    }
+    cdp_free(HANDLES.index);
+    HANDLES.index    = index;
+    HANDLES.indexCap = capacity << 1;
+    __atomic_store_n(&HANDLES.capacity, capacity, __ATOMIC_RELEASE);     // (Lock-free readers see the chunk before its slots.)
+    return true;
+}
+
+
+static inline size_t* handle_counter(cdpStore* store) {
+    // Handles are counted by the store holding their record, so moves in stores without any skip re-keying.
+    return store?  &store->handled:  &CDP_HANDLE_LOOSE;
+}
+
+static inline bool record_maybe_handled(const cdpRecord* record) {
+    return __atomic_load_n(handle_counter(record->parent), __ATOMIC_RELAXED);
+}
+
+
+static inline uint32_t handle_entry(const cdpRecord* record) {
+    // Slot of a record (plus one, 0 if it has none).
+    if (!HANDLES.indexCap)
+        return 0;
+    return HANDLES.index[handle_index_find(record)];
+}
+
+static inline cdpHandleSlot* handle_find(const cdpRecord* record) {
+    uint32_t entry = handle_entry(record);
+    return entry?  handle_slot(entry - 1):  NULL;
+}
+
+static inline cdpHandle handle_of(uint32_t entry) {
+    return ((uint64_t)handle_slot(entry - 1)->generation << 32) | entry;
+}
+
+
+static inline void handle_count_move(cdpHandleSlot* slot, cdpStore* store) {
+    __atomic_sub_fetch(handle_counter(slot->store), 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(handle_counter(store), 1, __ATOMIC_RELAXED);
+    slot->store = store;
+}
+
+
+static void store_child_adopt(cdpStore* store, cdpRecord* record) {
+    // A record (from no store) was just placed in store.
+    if CDP_RARELY(__atomic_load_n(&CDP_HANDLE_LOOSE, __ATOMIC_RELAXED)) {
+        handle_lock();
+        cdpHandleSlot* slot = handle_find(record);
+        if (slot)
+            handle_count_move(slot, store);
+        handle_unlock();
+    }
+    record->parent = store;
+}
+
+
+static void store_child_orphan(cdpStore* store, cdpRecord* record) {
+    // A record was just taken out of store (into no store).
+    if CDP_RARELY(__atomic_load_n(&store->handled, __ATOMIC_RELAXED)) {
+        handle_lock();
+        cdpHandleSlot* slot = handle_find(record);
+        if (slot)
+            handle_count_move(slot, NULL);
+        handle_unlock();
+    }
+    record->parent = NULL;
+}
+
+
+static void record_handle_release(cdpRecord* record) {
+    uint32_t n = handle_unkey(record);
+    if (n == UINT32_MAX)
+        return;
+    cdpHandleSlot* slot = handle_slot(n);
+    __atomic_sub_fetch(handle_counter(slot->store), 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->generation, slot->generation + 1, __ATOMIC_RELEASE);    // (Before the record, see handle_resolve().)
+    __atomic_store_n(&slot->record, NULL, __ATOMIC_RELEASE);
+    __atomic_store_n(&slot->resolved, 0, __ATOMIC_RELAXED);
+    slot->store = NULL;
+    slot->next = HANDLES.free;
+    HANDLES.free = n + 1;
+    __atomic_sub_fetch(&CDP_HANDLE_COUNT, 1, __ATOMIC_RELAXED);
+}
+
+
+static cdpHandle record_handle_assign(cdpRecord* record) {
+    // Same as cdp_record_handle(), with the table already locked.
+    uint32_t entry = handle_entry(record);
+    if (entry)
+        return handle_of(entry);
+
+    if CDP_RARELY(!handle_grow())
+        return 0;
+    uint32_t n = HANDLES.free - 1;
+    cdpHandleSlot* slot = handle_slot(n);
+    HANDLES.free = slot->next;
+    __atomic_store_n(&slot->record, record, __ATOMIC_RELEASE);
+    slot->store  = record->parent;
+    slot->next   = 0;       // (No shadows either.)
+    handle_index_put(HANDLES.index, HANDLES.indexCap - 1, n);
+    __atomic_add_fetch(handle_counter(slot->store), 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&CDP_HANDLE_COUNT, 1, __ATOMIC_RELAXED);
+    return ((uint64_t)slot->generation << 32) | (n + 1);
+}
+
+
+static cdpRecord* handle_resolve(cdpHandle handle) {
+    // Needs no lock: chunks never move and the capacity is published after them. The
+    // generation is checked again after loading the record, so a slot given back (and
+    // maybe reused) meanwhile isn't mistaken for the handled record.
+    uint32_t n = (uint32_t) handle;
+    if CDP_RARELY(!n  ||  n > __atomic_load_n(&HANDLES.capacity, __ATOMIC_ACQUIRE))
+        return NULL;
+    cdpHandleSlot* slot = handle_slot(n - 1);
+    uint32_t generation = (uint32_t)(handle >> 32);
+    if (__atomic_load_n(&slot->generation, __ATOMIC_ACQUIRE) != generation)
+        return NULL;
+    cdpRecord* record = __atomic_load_n(&slot->record, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return (__atomic_load_n(&slot->generation, __ATOMIC_RELAXED) == generation)?  record:  NULL;
+}
+
+
+/*
+    Gets the handle of a record, assigning one the first time. The handle
+    resolves to the record until it is finalized, even after the record is
+    moved (by its siblings or by sorting, growing or switching storages).
+*/
+cdpHandle cdp_record_handle(cdpRecord* record) {
+    assert(!cdp_record_is_void(record));
+    handle_lock();
+    cdpHandle handle = record_handle_assign(record);
+    handle_unlock();
+    return handle;
+}
+
+
+cdpRecord* cdp_handle_resolve(cdpHandle handle) {
+    return handle_resolve(handle);     // (Lock free.)
+}
+
+
+size_t cdp_handle_count(void) {
+    return __atomic_load_n(&CDP_HANDLE_COUNT, __ATOMIC_RELAXED);
+}
+
+
+bool cdp_record_is_handled(const cdpRecord* record) {
+    assert(!cdp_record_is_void(record));
+    if CDP_EXPECT(!record_maybe_handled(record))
+        return false;
+    handle_lock();
+    bool handled = handle_find(record);
+    handle_unlock();
+    return handled;
+}
+
+
+/*
+    Re-keys the handles of records moved from 'src' to 'dst'
+*/
+void cdp_record_handles_moved(cdpRecord* dst, const cdpRecord* src, size_t count) {
+    // Overlapping blocks are walked so no record lands where another one isn't re-keyed yet.
+    bool backwards = (dst > src);
+    handle_lock();
+    for (size_t n = 0;  n < count;  n++) {
+        size_t i = backwards?  (count - 1 - n):  n;
+        uint32_t slot = handle_unkey(&src[i]);
+        if (slot == UINT32_MAX)
+            continue;
+        __atomic_store_n(&handle_slot(slot)->record, &dst[i], __ATOMIC_RELEASE);
+        handle_index_put(HANDLES.index, HANDLES.indexCap - 1, slot);
+    }
+    handle_unlock();
+}
+
+
+static inline void record_swap(cdpRecord* a, cdpRecord* b, bool handled) {
+    cdpRecord swap = *a;
+    *a = *b;
+    *b = swap;
+    if CDP_RARELY(handled) {
+        // Handles follow their records (both are taken out of the index first, so keys never collide).
+        handle_lock();
+        uint32_t slotA = handle_unkey(a);
+        uint32_t slotB = handle_unkey(b);
+        if (slotA != UINT32_MAX) {
+            __atomic_store_n(&handle_slot(slotA)->record, b, __ATOMIC_RELEASE);
+            handle_index_put(HANDLES.index, HANDLES.indexCap - 1, slotA);
+        }
+        if (slotB != UINT32_MAX) {
+            __atomic_store_n(&handle_slot(slotB)->record, a, __ATOMIC_RELEASE);
+            handle_index_put(HANDLES.index, HANDLES.indexCap - 1, slotB);
+        }
+        handle_unlock();
+    }
+}
+
+static void record_sift_down(cdpRecord* record, size_t root, size_t count, cdpCompare compare, void* context, bool handled) {
+    for (size_t child;  (child = (root << 1) + 1) < count;  root = child) {
+        if (child + 1 < count  &&  compare(&record[child], &record[child + 1], context) < 0)
+            child++;
+        if (compare(&record[root], &record[child], context) >= 0)
+            return;
+        record_swap(&record[root], &record[child], handled);
+    }
+}
+
+static void record_sort(cdpRecord* record, size_t count, cdpCompare compare, void* context) {
+    // Heap sort in place: nothing is allocated (so it can't fail), and handled records are re-keyed as they are swapped.
+    // The handle lock is only held while swapping, so compare functions may follow links.
+    bool handled = count  &&  record_maybe_handled(record);
+    for (size_t n = count >> 1;  n--; )
+        record_sift_down(record, n, count, compare, context, handled);
+    for (size_t n = count;  n-- > 1; ) {
+        record_swap(&record[0], &record[n], handled);
+        record_sift_down(record, 0, n, compare, context, handled);
+    }
+}
+
+
+
+
+/*
+    Shadow implementation
+*/
+#define SHADOW_MIN  4
+
+static inline cdpHandle record_handle_of(const cdpRecord* record) {
+    // Handle of a record (0 if it has none), without assigning one.
+    uint32_t entry = handle_entry(record);
+    return entry?  handle_of(entry):  0;
+}
+
+
+static bool shadow_add(cdpRecord* target, cdpHandle link) {
+    if CDP_RARELY(!record_handle_assign(target))
+        return false;
+    cdpHandleSlot* slot = handle_find(target);
+
+    switch (slot->shadowing) {
+      case CDP_SHADOW_NONE: {
+        slot->linked    = link;
+        slot->shadowing = CDP_SHADOW_SINGLE;
+        return true;
+      }
+      case CDP_SHADOW_SINGLE: {
+        cdpShadow* shadow = cdp_try_malloc(sizeof(cdpShadow) + SHADOW_MIN * sizeof(cdpHandle));
+        if CDP_RARELY(!shadow)
+            return false;
+        shadow->capacity = SHADOW_MIN;
+        shadow->count    = 2;
+        shadow->link[0]  = slot->linked;
+        shadow->link[1]  = link;
+        slot->shadow    = shadow;
+        slot->shadowing = CDP_SHADOW_MULTIPLE;
+        return true;
+      }
+    }
+
+    cdpShadow* shadow = slot->shadow;
+    if (shadow->count == shadow->capacity) {
+        unsigned capacity = shadow->capacity << 1;
+        shadow = cdp_try_realloc(shadow, sizeof(cdpShadow) + capacity * sizeof(cdpHandle));
+        if CDP_RARELY(!shadow)
+            return false;
+        shadow->capacity = capacity;
+        slot->shadow = shadow;
+    }
+    shadow->link[shadow->count++] = link;
+    return true;
+}
+
+
+static void shadow_remove(cdpRecord* target, cdpHandle link) {
+    cdpHandleSlot* slot = handle_find(target);
+    if (!slot)
+        return;
+
+    switch (slot->shadowing) {
+      case CDP_SHADOW_SINGLE: {
+        if (slot->linked == link) {
+            slot->linked    = 0;
+            slot->shadowing = CDP_SHADOW_NONE;
+        }
+        return;
+      }
+      case CDP_SHADOW_MULTIPLE: {
+        cdpShadow* shadow = slot->shadow;
+        for (unsigned n = 0;  n < shadow->count;  n++) {
+            if (shadow->link[n] == link) {
+                shadow->link[n] = shadow->link[--shadow->count];
+                break;
+            }
+        }
+        if (shadow->count == 1) {
+            slot->linked    = shadow->link[0];
+            slot->shadowing = CDP_SHADOW_SINGLE;
+            cdp_free(shadow);
+        }
+        return;
+      }
+    }
+}
+
+
+static void link_uncache(cdpRecord* link) {
+    // Drops the cached target of a link and of every link leading to it.
+    cdpHandleSlot* slot = handle_find(link);
+    if (!slot  ||  !slot->resolved)
+        return;         // Links leading here can't have one either (they were cached through this one).
+    __atomic_store_n(&slot->resolved, 0, __ATOMIC_RELEASE);
+
+    switch (slot->shadowing) {
+      case CDP_SHADOW_SINGLE: {
+        cdpRecord* shadow = handle_resolve(slot->linked);
+        if (shadow)
+            link_uncache(shadow);
+        break;
+      }
+      case CDP_SHADOW_MULTIPLE: {
+        cdpShadow* shadow = slot->shadow;
+        for (unsigned n = 0;  n < shadow->count;  n++) {
+            cdpRecord* upper = handle_resolve(shadow->link[n]);
+            if (upper)
+                link_uncache(upper);
+        }
+        break;
+      }
+    }
+}
+
+
+static void shadow_clear(cdpRecord* record, cdpRecord* newTarget) {
+    // Points every link shadowing record to newTarget (or to nothing).
+    cdpHandleSlot* slot = handle_find(record);
+    if (!slot  ||  !slot->shadowing)
+        return;
+
+    cdpShadow* shadow = (slot->shadowing == CDP_SHADOW_MULTIPLE)?  slot->shadow:  NULL;
+    unsigned   count  = shadow?  shadow->count:  1;
+    cdpHandle  single = slot->linked;
+    slot->linked    = 0;
+    slot->shadowing = CDP_SHADOW_NONE;
+
+    cdpHandle target = newTarget?  record_handle_assign(newTarget):  0;
+    for (unsigned n = 0;  n < count;  n++) {
+        cdpHandle  handle = shadow?  shadow->link[n]:  single;
+        cdpRecord* link   = handle_resolve(handle);
+        if (!link  ||  !cdp_record_is_link(link))
+            continue;
+        link_uncache(link);
+        __atomic_store_n(&link->link, target, __ATOMIC_RELEASE);
+        if (target  &&  !shadow_add(newTarget, handle))
+            LINK_UNTRACKED = true;  // Out of memory: the link still works, only it won't be nulled when newTarget goes.
+    }
+    cdp_free(shadow);
+}
+
+
+static void link_attach(cdpRecord* link, cdpRecord* target) {
+    cdpHandle handle = record_handle_assign(target);
+    __atomic_store_n(&link->link, handle, __ATOMIC_RELEASE);
+    cdpHandle self = record_handle_assign(link);
+    if (!handle  ||  !self  ||  !shadow_add(target, self))
+        LINK_UNTRACKED = true;      // The handle generation still tells when target is gone.
+}
+
+
+static void link_detach(cdpRecord* link) {
+    cdpRecord* target = handle_resolve(link->link);
+    if (target)
+        shadow_remove(target, record_handle_of(link));
+    link_uncache(link);
+    __atomic_store_n(&link->link, 0, __ATOMIC_RELEASE);
+}
+
+
+void cdp_link_set(cdpRecord* link, cdpRecord* target) {
+    assert(link && cdp_record_is_link(link));
+    assert(target && !cdp_record_is_void(target) && cdp_record_parent(target));     // Links to "root" aren't allowed for now.
+    handle_lock();
+    link_detach(link);
+    link_attach(link, target);
+    handle_unlock();
+}
+
+
+/*
+    Redirects all links pointing to target (in as many steps as links)
+*/
+void cdp_link_redirect(cdpRecord* target, cdpRecord* newTarget) {
+    assert(!cdp_record_is_void(target) && !cdp_record_is_void(newTarget));
+    if (target == newTarget  ||  !record_maybe_handled(target))
+        return;
+    handle_lock();
+    shadow_clear(target, newTarget);
+    handle_unlock();
+}
+
+
+bool cdp_record_is_shadowed(const cdpRecord* record) {
+    assert(!cdp_record_is_void(record));
+    if CDP_EXPECT(!record_maybe_handled(record))
+        return false;
+    handle_lock();
+    cdpHandleSlot* slot = handle_find(record);
+    bool shadowed = slot  &&  slot->shadowing;
+    handle_unlock();
+    return shadowed;
+}
+
+
+size_t cdp_record_shadows(const cdpRecord* record, cdpRecord** link, size_t max) {
+    assert(!cdp_record_is_void(record) && (link || !max));
+    size_t count = 0;
+    handle_lock();
+    cdpHandleSlot* slot = handle_find(record);
+    if (slot  &&  slot->shadowing == CDP_SHADOW_SINGLE) {
+        if (max)
+            link[0] = handle_resolve(slot->linked);
+        count = 1;
+    } else if (slot  &&  slot->shadowing == CDP_SHADOW_MULTIPLE) {
+        cdpShadow* shadow = slot->shadow;
+        for (unsigned n = 0;  n < shadow->count  &&  n < max;  n++)
+            link[n] = handle_resolve(shadow->link[n]);
+        count = shadow->count;
+    }
+    handle_unlock();
+    return count;
+}
+
+
+static inline cdpHandle handle_cached(cdpHandle handle) {
+    // The final record cached in the slot of a (handled) link, if the slot still belongs to it.
+    cdpHandleSlot* slot = handle_slot((uint32_t)handle - 1);
+    cdpHandle resolved = __atomic_load_n(&slot->resolved, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return (__atomic_load_n(&slot->generation, __ATOMIC_RELAXED) == (uint32_t)(handle >> 32))?  resolved:  0;
+}
+
+
+/*
+    Finds the record at the end of a chain of links (links to links), then
+    compresses the path: every link in the chain caches the final record
+    (as a handle, in its own handle slot) so the next pull goes straight
+    to it. Caches are dropped
+    (through the shadows) when a link along the way is re-pointed or gone,
+    while the handle generation tells if the final record itself is gone.
+    Once cached, pulls take no lock: the first hop is resolved as a
+    handle, and the cache is read from the slot that handle names.
+*/
+cdpRecord* cdp_link_resolve(cdpRecord* link) {
+    assert(link && cdp_record_is_link(link));
+    cdpHandle  handle = __atomic_load_n(&link->link, __ATOMIC_ACQUIRE);
+    cdpRecord* target = handle_resolve(handle);
+    if CDP_EXPECT(!target  ||  !cdp_record_is_link(target))
+        return target;      // Plain links are a single handle lookup.
+    cdpHandle resolved = handle_cached(handle);
+    target = resolved?  handle_resolve(resolved):  NULL;
+    if CDP_EXPECT(target)
+        return target;      // Chains of any length cost two lookups once resolved.
+
+    // Slow path: walk the chain (with the table locked, so it isn't re-pointed meanwhile) and cache it.
+    handle_lock();
+    handle = link->link;
+    target = handle_resolve(handle);
+    while (target  &&  cdp_record_is_link(target)) {
+        handle = target->link;
+        target = handle_resolve(handle);
+    }
+    if (target  &&  !LINK_UNTRACKED) {
+        for (cdpRecord* next = link;  cdp_record_is_link(next);  next = handle_resolve(next->link)) {
+            cdpHandleSlot* slot = handle_find(next);
+            if (slot)
+                __atomic_store_n(&slot->resolved, handle, __ATOMIC_RELEASE);
+        }
+    }
+    handle_unlock();
+    return target;
 }
 
 
@@ -1069,13 +2865,22 @@ void cdp_record_initialize(cdpRecord* record, unsigned type, cdpDT* name, cdpDat
 
     //CDP_0(record);
 
-    record->metarecord.domain = name->domain;
-    record->metarecord.tag    = name->tag;
-    record->metarecord.type   = type;
-    record->data  = data;
-    record->store = store;
-    if (!isLink && store)
+    record->metarecord.domain  = name->domain;
+    record->metarecord.tag     = name->tag;
+    record->metarecord.type    = type;
+    record->parent = NULL;      // (Stores set it once added.)
+    record->data   = data;
+    record->store  = store;
+    if (isLink) {
+        record->link = 0;
+        if (data) {
+            handle_lock();
+            link_attach(record, (cdpRecord*)data);
+            handle_unlock();
+        }
+    } else if (store) {
         store->owner = record;
+    }
 }
 
 
@@ -1100,15 +2905,13 @@ void cdp_record_initialize_clone(cdpRecord* clone, cdpDT* name, cdpRecord* recor
     De-initiates a record
 */
 void cdp_record_finalize(cdpRecord* record) {
-    assert(!cdp_record_is_void(record) && !cdp_record_is_shadowed(record));
+    assert(!cdp_record_is_void(record));
 
     switch (record->metarecord.type) {
       case CDP_TYPE_NORMAL: {
         // Delete storage (and children)
         cdpStore* store = record->store;
         if (store) {
-            // ToDo: clean shadow.
-
             cdp_store_del(store);
         }
 
@@ -1126,11 +2929,20 @@ void cdp_record_finalize(cdpRecord* record) {
       }
 
       case CDP_TYPE_LINK: {
-        // ToDo: deal with linkage here.
+        handle_lock();
+        link_detach(record);
+        handle_unlock();
         break;
       }
     }
 
+    if (record_maybe_handled(record)) {
+        handle_lock();
+        shadow_clear(record, NULL);     // Links pointing here are nulled.
+        record_handle_release(record);
+        handle_unlock();
+    }
+
     // ToDo: unlink from 'self' list.
 }
 
@@ -1140,7 +2952,7 @@ void cdp_record_finalize(cdpRecord* record) {
 #define RECORD_FOLLOW_LINK_TO_STORE(record, store, ...)                        \
     assert(!cdp_record_is_void(record));                                       \
     record = cdp_link_pull(CDP_P(record));                                     \
-    cdpStore* store = record->store;                                           \
+    cdpStore* store = record?  record->store:  NULL;                           \
     if (!store)                                                                \
         return __VA_ARGS__
 
@@ -1172,6 +2984,8 @@ void* cdp_record_data(const cdpRecord* record) {
     assert(!cdp_record_is_void(record));
 
     record = cdp_link_pull(CDP_P(record));
+    if (!record)
+        return NULL;
 
     cdpData* data = record->data;
     if (!data)
@@ -1188,11 +3002,23 @@ void* cdp_record_update(cdpRecord* record, size_t size, size_t capacity, void* v
     assert(!cdp_record_is_void(record) && size && capacity);
 
     record = cdp_link_pull(record);
+    if (!record)
+        return NULL;
 
     cdpData* data = record->data;
     if CDP_NOT_ASSERT(data)
         return NULL;
 
+    if (cdp_data_is_shared(data)) {
+        // Copy on write.
+        if (!data->writable || data->datatype > CDP_DATATYPE_DATA)
+            return NULL;
+        data = data_unshare(data, capacity, swap);
+        if CDP_RARELY(!data)
+            return NULL;
+        record->data = data;
+    }
+
     return cdp_data_update(data, size, capacity, value, swap);
 }
 
@@ -1292,6 +3118,15 @@ cdpRecord* cdp_record_find_by_position(const cdpRecord* record, size_t position)
 }
 
 
+/*
+    Gets the position of record among its siblings
+*/
+size_t cdp_record_index_of(const cdpRecord* record) {
+    assert(!cdp_record_is_void(record) && record->parent);
+    return store_index_of_child(record->parent, record);
+}
+
+
 /*
     Gets the record by its path from start record
 */
@@ -1311,6 +3146,70 @@ cdpRecord* cdp_record_find_by_path(const cdpRecord* start, const cdpPath* path)
 }
 
 
+/*
+    Compiles a path (from start) so it can be resolved again cheaply
+*/
+cdpCompiledPath* cdp_compiled_path_new(const cdpRecord* start, const cdpPath* path) {
+    assert(!cdp_record_is_void(start) && path && path->length);
+
+    cdpCompiledPath* compiled = cdp_malloc(sizeof(cdpCompiledPath) + (path->length * sizeof(cdpPathStep)));
+    compiled->start  = start;
+    compiled->length = path->length;
+    compiled->walks  = 0;
+    for (unsigned depth = 0;  depth < path->length;  depth++) {
+        cdpPathStep* step = &compiled->step[depth];
+        step->name   = path->dt[depth];
+        step->store  = NULL;
+        step->record = NULL;
+    }
+    return compiled;
+}
+
+
+void cdp_compiled_path_del(cdpCompiledPath* compiled) {
+    cdp_free(compiled);
+}
+
+
+/*
+    Finds the record a compiled path leads to. Each level is taken from
+    cache if its store is the same one (and with the same generation) as
+    when it was last resolved, otherwise it is searched (and cached) again.
+*/
+cdpRecord* cdp_record_find_by_compiled_path(cdpCompiledPath* compiled) {
+    assert(compiled);
+    cdpRecord* record = CDP_P(compiled->start);
+
+    for (unsigned depth = 0;  depth < compiled->length;  depth++) {
+        cdpPathStep* step = &compiled->step[depth];
+        record = cdp_link_pull(record);
+        cdpStore* store = record?  record->store:  NULL;
+        if (!store) {
+            step->store = NULL;
+            return NULL;
+        }
+
+        uint64_t generation = STORE_GENERATION_OF(store);
+        if CDP_EXPECT(store == step->store  &&  generation == step->generation) {
+            record = step->record;
+            continue;
+        }
+
+        compiled->walks++;
+        record = STORE_CHILDREN(store)?  store_find_child_by_name(store, &step->name):  NULL;
+        if (!record) {
+            step->store = NULL;
+            return NULL;
+        }
+        step->store      = store;
+        step->generation = generation;
+        step->record     = record;
+    }
+
+    return record;
+}
+
+
 
 
 /*
@@ -1366,6 +3265,131 @@ cdpRecord* cdp_record_find_next_by_path(const cdpRecord* start, cdpPath* path, u
 }
 
 
+/*
+    Cursor implementation
+*/
+static inline cdpRecord* store_run_last(const cdpStore* store, cdpRecord* child) {
+    // Last record stored right after 'child' (with no gaps) in memory.
+    switch (store->storage) {
+      case CDP_STORAGE_ARRAY: {
+        return array_last((cdpArray*) store);
+      }
+      case CDP_STORAGE_INLINE: {
+        return inline_last((cdpInline*) store);
+      }
+      case CDP_STORAGE_PACKED_QUEUE: {
+        return packed_q_node_from_record((cdpPackedQ*) store, child)->last;
+      }
+      default: {
+        return child;
+      }
+    }
+}
+
+#define CURSOR_UNPLACED     SIZE_MAX    // Position not worked out yet (it may cost a walk over the siblings).
+
+static inline cdpRecord* cursor_set(cdpCursor* cursor, cdpRecord* child) {
+    cursor->record   = child;
+    cursor->position = child?  CURSOR_UNPLACED:  STORE_CHILDREN(cursor->store);
+    return child;
+}
+
+static inline void cursor_advance(cdpCursor* cursor, size_t steps) {
+    if (!cursor->record)
+        cursor->position = STORE_CHILDREN(cursor->store);
+    else if (cursor->position != CURSOR_UNPLACED)
+        cursor->position += steps;
+}
+
+
+cdpRecord* cdp_cursor_first(cdpCursor* cursor, const cdpRecord* record) {
+    assert(cursor);
+    CDP_0(cursor);
+    RECORD_FOLLOW_LINK_TO_STORE(record, store, NULL);
+    cursor->store  = store;
+    cursor->record = store_first_child(store);
+    return cursor->record;
+}
+
+
+cdpRecord* cdp_cursor_next(cdpCursor* cursor) {
+    assert(cursor);
+    if (!cursor->record)
+        return NULL;
+    cursor->record = store_next_child(cursor->store, cursor->record);
+    cursor_advance(cursor, 1);
+    return cursor->record;
+}
+
+
+cdpRecord* cdp_cursor_seek(cdpCursor* cursor, const cdpDT* name) {
+    assert(cursor && cursor->store);
+    return cursor_set(cursor, store_find_child_by_name(cursor->store, name));
+}
+
+
+cdpRecord* cdp_cursor_seek_key(cdpCursor* cursor, cdpRecord* key, cdpCompare compare, void* context) {
+    assert(cursor && cursor->store);
+    return cursor_set(cursor, store_find_child_by_key(cursor->store, key, compare, context));
+}
+
+
+cdpRecord* cdp_cursor_seek_position(cdpCursor* cursor, size_t position) {
+    assert(cursor && cursor->store);
+    cursor->record   = store_find_child_by_position(cursor->store, position);
+    cursor->position = cursor->record?  position:  STORE_CHILDREN(cursor->store);
+    return cursor->record;
+}
+
+
+/*
+    Gets the position of the cursor child (seeking by name or key leaves it
+    to be found here, only if asked for)
+*/
+size_t cdp_cursor_position(cdpCursor* cursor) {
+    assert(cursor && cursor->store);
+    if (cursor->position == CURSOR_UNPLACED)
+        cursor->position = store_index_of_child(cursor->store, cursor->record);
+    return cursor->position;
+}
+
+
+size_t cdp_cursor_batch(cdpCursor* cursor, cdpRecord** batch, size_t max) {
+    assert(cursor && batch && max);
+    size_t n = 0;
+    for (cdpRecord* child = cursor->record;  child  &&  n < max;  child = cdp_cursor_next(cursor)) {
+        if (n  &&  child == batch[n - 1] + 1) {
+            // Contiguous storage: take the rest of the run at once.
+            cdpRecord* last = store_run_last(cursor->store, child);
+            size_t     take = cdp_min((size_t)(last - child) + 1, max - n);
+            for (size_t i = 0;  i < take;  i++)
+                batch[n++] = child + i;
+            cursor->record = child + (take - 1);
+            cursor_advance(cursor, take - 1);
+            continue;
+        }
+        batch[n++] = child;
+    }
+    return n;
+}
+
+
+size_t cdp_cursor_span(cdpCursor* cursor, cdpRecord** span) {
+    assert(cursor && span);
+    cdpRecord* child = cursor->record;
+    if (!child) {
+        *span = NULL;
+        return 0;
+    }
+    cdpRecord* last = store_run_last(cursor->store, child);
+    size_t     size = (size_t)(last - child) + 1;
+    cursor->record = store_next_child(cursor->store, last);
+    cursor_advance(cursor, size);
+    *span = child;
+    return size;
+}
+
+
 /*
     Traverses the children of a record, applying a function to each one
 */
@@ -1375,6 +3399,55 @@ bool cdp_record_traverse(cdpRecord* record, cdpTraverse func, void* context, cdp
 }
 
 
+/*
+    Traverses the children named in a domain, applying a function to each one
+*/
+static inline cdpRecord* store_next_in_domain(const cdpStore* store, cdpRecord* child, cdpID domain) {
+    for (;  child;  child = store_next_child(store, child)) {
+        if (child->metarecord.domain == domain)
+            return child;
+        if (cdp_store_is_dictionary((cdpStore*)store)  &&  store->storage != CDP_STORAGE_HASH_TABLE  &&  child->metarecord.domain > domain)
+            return NULL;    // Sorted by name: the domain is over (hash tables go by insertion instead).
+    }
+    return NULL;
+}
+
+bool cdp_record_traverse_domain(cdpRecord* record, cdpID domain, cdpTraverse func, void* context, cdpEntry* entry) {
+    assert(func);
+    RECORD_FOLLOW_LINK_TO_STORE(record, store, true);
+
+    if (!STORE_CHILDREN(store))
+        return true;
+
+    STORE_PROFILE(store, traversals);
+
+    cdpRecord* child;
+    if (store->storage == CDP_STORAGE_ART)
+        child = art_first_in_domain((cdpArt*) store, domain);
+    else
+        child = store_next_in_domain(store, store_first_child(store), domain);
+    if (!child)
+        return true;
+
+    if (!entry)
+        entry = cdp_alloca(sizeof(cdpEntry));
+    CDP_0(entry);
+    entry->parent = store->owner;
+
+    do {
+        entry->record = child;
+        entry->next = store_next_in_domain(store, store_next_child(store, child), domain);
+        if (!func(entry, context))
+            return false;
+        entry->position++;
+        entry->prev = entry->record;
+        child = entry->next;
+    } while (child);
+
+    return true;
+}
+
+
 /*
     Traverses each child branch and *sub-branch* of a record, applying a function to each one
 */
@@ -1439,6 +3512,26 @@ bool cdp_record_deep_traverse(cdpRecord* record, cdpTraverse func, cdpTraverse e
             entry->next = octree_next(entry->record);
             break;
           }
+          case CDP_STORAGE_HASH_TABLE: {
+            entry->next = hash_table_next(entry->record);
+            break;
+          }
+          case CDP_STORAGE_BTREE: {
+            entry->next = btree_next(entry->record);
+            break;
+          }
+          case CDP_STORAGE_SKIPLIST: {
+            entry->next = skiplist_next(entry->record);
+            break;
+          }
+          case CDP_STORAGE_ART: {
+            entry->next = art_next(entry->record);
+            break;
+          }
+          case CDP_STORAGE_INLINE: {
+            entry->next = inline_next((cdpInline*) entry->parent->store, entry->record);
+            break;
+          }
         }
 
         if (func) {
@@ -1475,6 +3568,257 @@ bool cdp_record_deep_traverse(cdpRecord* record, cdpTraverse func, cdpTraverse e
 }
 
 
+/*
+    Parallel deep traversal implementation
+*/
+
+typedef struct {
+    cdpRecord*      parent;     // Record whose children are visited.
+    unsigned        depth;
+} cdpTraverseTask;
+
+typedef struct {
+    atomic_flag     lock;
+    cdpTraverseTask* task;      // Owner works on the bottom, thieves take from the top (bigger subtrees).
+    size_t          top;
+    size_t          bottom;
+    size_t          capacity;
+} cdpTraverseDeque;
+
+typedef struct {
+    cdpTraverse         func;
+    unsigned            workers;
+    char*               contexts;
+    size_t              contextSize;
+    cdpTraverseDeque*   deque;
+    size_t              pending;    // Tasks not finished yet.
+    bool                stop;
+    bool                failed;     // Out of memory.
+} cdpParallelTraverse;
+
+typedef struct {
+    cdpParallelTraverse* shared;
+    unsigned            index;
+} cdpTraverseWorker;
+
+
+static inline void traverse_deque_lock(cdpTraverseDeque* deque) {
+    while (atomic_flag_test_and_set_explicit(&deque->lock, memory_order_acquire))
+        sched_yield();
+}
+#define traverse_deque_unlock(deque)    atomic_flag_clear_explicit(&(deque)->lock, memory_order_release)
+
+
+static bool traverse_push(cdpParallelTraverse* shared, cdpTraverseDeque* deque, cdpRecord* parent, unsigned depth) {
+    traverse_deque_lock(deque);
+    if (deque->bottom == deque->capacity) {
+        if (deque->top) {
+            // Slide down what's left.
+            deque->bottom -= deque->top;
+            memmove(deque->task, &deque->task[deque->top], deque->bottom * sizeof(cdpTraverseTask));
+            deque->top = 0;
+        }
+        if (deque->bottom == deque->capacity) {
+            size_t capacity = deque->capacity?  (deque->capacity << 1):  64;
+            cdpTraverseTask* task = cdp_try_realloc(deque->task, capacity * sizeof(cdpTraverseTask));
+            if CDP_RARELY(!task) {
+                traverse_deque_unlock(deque);
+                return false;
+            }
+            deque->task     = task;
+            deque->capacity = capacity;
+        }
+    }
+    __atomic_add_fetch(&shared->pending, 1, __ATOMIC_RELAXED);
+    deque->task[deque->bottom++] = (cdpTraverseTask){parent, depth};
+    traverse_deque_unlock(deque);
+    return true;
+}
+
+
+static bool traverse_take(cdpTraverseDeque* deque, bool steal, cdpTraverseTask* task) {
+    traverse_deque_lock(deque);
+    bool found = (deque->top < deque->bottom);
+    if (found) {
+        *task = steal?  deque->task[deque->top++]:  deque->task[--deque->bottom];
+        if (deque->top == deque->bottom)
+            deque->top = deque->bottom = 0;
+    }
+    traverse_deque_unlock(deque);
+    return found;
+}
+
+
+static void traverse_task_run(cdpParallelTraverse* shared, unsigned index, cdpTraverseTask* task) {
+    void* context = shared->contexts + (index * shared->contextSize);
+    cdpStore* store = task->parent->store;
+    cdpEntry entry = {.parent = task->parent, .depth = task->depth};
+
+    for (entry.record = store_peek_first(store);  entry.record;  entry.position++) {     // (Worker threads don't touch profiles.)
+        if (__atomic_load_n(&shared->stop, __ATOMIC_RELAXED))
+            return;
+        entry.next = store_next_child(store, entry.record);
+
+        if (!shared->func(&entry, context)) {
+            __atomic_store_n(&shared->stop, true, __ATOMIC_RELAXED);
+            return;
+        }
+
+        // Subtrees become tasks (so idle workers may steal them).
+        cdpRecord* child = entry.record;
+        if (cdp_record_is_normal(child)  &&  child->store  &&  STORE_CHILDREN(child->store)) {
+            assert(task->depth + 1 < MAX_DEPTH);
+            if CDP_RARELY(!traverse_push(shared, &shared->deque[index], child, task->depth + 1)) {
+                __atomic_store_n(&shared->failed, true, __ATOMIC_RELAXED);
+                __atomic_store_n(&shared->stop, true, __ATOMIC_RELAXED);
+                return;
+            }
+        }
+
+        entry.prev   = entry.record;
+        entry.record = entry.next;
+    }
+}
+
+
+static void* traverse_worker(void* arg) {
+    cdpTraverseWorker* worker = arg;
+    cdpParallelTraverse* shared = worker->shared;
+    unsigned index = worker->index;
+    uint32_t seed = index * 0x9E3779B9u + 1;
+    cdpTraverseTask task;
+
+    while (__atomic_load_n(&shared->pending, __ATOMIC_ACQUIRE)) {
+        bool found = traverse_take(&shared->deque[index], false, &task);
+        for (unsigned tries = 0;  !found  &&  tries < shared->workers;  tries++) {
+            seed ^= seed << 13;  seed ^= seed >> 17;  seed ^= seed << 5;
+            unsigned victim = seed % shared->workers;
+            if (victim != index)
+                found = traverse_take(&shared->deque[victim], true, &task);
+        }
+        if (!found) {
+            sched_yield();
+            continue;
+        }
+
+        if (!__atomic_load_n(&shared->stop, __ATOMIC_RELAXED))
+            traverse_task_run(shared, index, &task);
+        __atomic_sub_fetch(&shared->pending, 1, __ATOMIC_RELEASE);
+    }
+    if (index)
+        slab_thread_flush();    // Items cached by a finishing thread would be lost otherwise.
+    return NULL;
+}
+
+
+/*
+    Traverses all records below 'record' using several threads
+*/
+bool cdp_record_parallel_traverse(cdpRecord* record, cdpTraverse func, unsigned workers, void* contexts, size_t contextSize, cdpReduce reduce, void* result) {
+    assert(!cdp_record_is_void(record) && func && workers && (contexts || !contextSize));
+    if CDP_NOT_ASSERT(cdp_record_is_normal(record))
+        return false;       // Links aren't followed (their target may be walked instead).
+
+    bool ok = true;
+    if (cdp_record_children(record)) {
+        STORE_PROFILE(record->store, traversals);     // (Only the calling thread profiles.)
+        cdpParallelTraverse shared = {
+            .func        = func,
+            .workers     = workers,
+            .contexts    = contexts,
+            .contextSize = contextSize,
+            .deque       = cdp_try_malloc0(workers * sizeof(cdpTraverseDeque)),
+        };
+        cdpTraverseWorker* worker = cdp_try_malloc(workers * sizeof(cdpTraverseWorker));
+        pthread_t* thread = cdp_alloca(workers * sizeof(pthread_t));
+        bool* started = cdp_alloca(workers * sizeof(bool));
+
+        if (shared.deque  &&  worker  &&  traverse_push(&shared, &shared.deque[0], record, 0)) {
+            for (unsigned n = 0;  n < workers;  n++) {
+                worker[n] = (cdpTraverseWorker){&shared, n};
+                started[n] = n  &&  !pthread_create(&thread[n], NULL, traverse_worker, &worker[n]);    // Fewer threads just mean more work for the rest.
+            }
+            traverse_worker(&worker[0]);
+            for (unsigned n = 1;  n < workers;  n++) {
+                if (started[n])
+                    pthread_join(thread[n], NULL);
+            }
+        } else {
+            shared.failed = true;
+        }
+
+        for (unsigned n = 0;  shared.deque  &&  n < workers;  n++)
+            cdp_free(shared.deque[n].task);
+        cdp_free(shared.deque);
+        cdp_free(worker);
+
+        ok = !shared.stop  &&  !shared.failed;     // Out of memory leaves the traversal incomplete.
+    }
+
+    if (reduce) {
+        for (unsigned n = 0;  n < workers;  n++)
+            reduce(result, (char*)contexts + (n * contextSize));
+    }
+    return ok;
+}
+
+
+/*
+    Finds spatial children intersecting an axis-aligned box
+*/
+bool cdp_record_spatial_box(const cdpRecord* record, const float min[3], const float max[3], cdpSpatialLocate locate, cdpSpatialFunc func, void* context) {
+    assert(min && max && locate && func);
+    RECORD_FOLLOW_LINK_TO_STORE(record, store, true);
+    assert(store->storage == CDP_STORAGE_OCTREE);
+    if (!store->chdCount)
+        return true;
+    STORE_PROFILE(store, lookups);
+    return octree_query_box((cdpOctree*) store, min, max, locate, func, context);
+}
+
+
+/*
+    Finds spatial children within a radius of a point
+*/
+bool cdp_record_spatial_sphere(const cdpRecord* record, const float center[3], float radius, cdpSpatialLocate locate, cdpSpatialFunc func, void* context) {
+    assert(center && radius >= 0.0f && locate && func);
+    RECORD_FOLLOW_LINK_TO_STORE(record, store, true);
+    assert(store->storage == CDP_STORAGE_OCTREE);
+    if (!store->chdCount)
+        return true;
+    STORE_PROFILE(store, lookups);
+    return octree_query_sphere((cdpOctree*) store, center, radius, locate, func, context);
+}
+
+
+/*
+    Finds spatial children crossed by a ray (up to 'length' times its direction)
+*/
+bool cdp_record_spatial_ray(const cdpRecord* record, const float origin[3], const float direction[3], float length, cdpSpatialLocate locate, cdpSpatialFunc func, void* context) {
+    assert(origin && direction && length >= 0.0f && locate && func);
+    RECORD_FOLLOW_LINK_TO_STORE(record, store, true);
+    assert(store->storage == CDP_STORAGE_OCTREE);
+    if (!store->chdCount)
+        return true;
+    STORE_PROFILE(store, lookups);
+    return octree_query_ray((cdpOctree*) store, origin, direction, length, locate, func, context);
+}
+
+
+/*
+    Gets the (up to) k spatial children nearest to a point, closest first
+*/
+size_t cdp_record_spatial_nearest(const cdpRecord* record, const float point[3], size_t k, cdpSpatialLocate locate, void* context, cdpRecord** nearest, float* distance) {
+    assert(point && k && locate && nearest && distance);
+    RECORD_FOLLOW_LINK_TO_STORE(record, store, 0);
+    assert(store->storage == CDP_STORAGE_OCTREE);
+    if (!store->chdCount)
+        return 0;
+    STORE_PROFILE(store, lookups);
+    return octree_query_nearest((cdpOctree*) store, point, k, locate, context, nearest, distance);
+}
+
+
 
 
 /*
@@ -1489,9 +3833,140 @@ void cdp_record_to_dictionary(cdpRecord* record) {
 /*
     Sorts unsorted records according to user defined function
 */
-void cdp_record_sort(cdpRecord* record, cdpCompare compare, void* context) {
-    RECORD_FOLLOW_LINK_TO_STORE(record, store);
-    store_sort(store, compare, context);
+bool cdp_record_sort(cdpRecord* record, cdpCompare compare, void* context) {
+    RECORD_FOLLOW_LINK_TO_STORE(record, store, false);
+    return store_sort(store, compare, context);
+}
+
+
+
+
+static inline bool store_move_child(cdpStore* store, cdpRecord* child, bool prepend) {
+    if (store->indexing == CDP_INDEX_BY_INSERTION)
+        return cdp_store_append_child(store, prepend, child);
+    return cdp_store_add_child(store, 0, child);
+}
+
+
+/*
+    Moves all children of record into a new storage (of the same indexing)
+*/
+bool cdp_record_convert_storage(cdpRecord* record, unsigned storage) {
+    assert(storage < CDP_STORAGE_COUNT);
+    RECORD_FOLLOW_LINK_TO_STORE(record, store, false);
+
+    if (store->storage == storage)
+        return true;
+    if (!store->writable)
+        return false;
+
+    cdpStore* newStore;
+    switch (storage) {
+      case CDP_STORAGE_LINKED_LIST: {
+        newStore = cdp_store_new(&store->_dt, storage, store->indexing, store->compare);
+        break;
+      }
+      case CDP_STORAGE_ARRAY: {
+        size_t capacity = cdp_max(store->chdCount, (size_t)8);
+        newStore = cdp_store_new(&store->_dt, storage, store->indexing, capacity, store->compare);
+        break;
+      }
+      case CDP_STORAGE_PACKED_QUEUE: {
+        if (store->indexing != CDP_INDEX_BY_INSERTION)
+            return false;
+        newStore = cdp_store_new(&store->_dt, storage, store->indexing, (size_t)16);
+        break;
+      }
+      case CDP_STORAGE_RED_BLACK_T: {
+        if (store->indexing == CDP_INDEX_BY_INSERTION)
+            return false;
+        newStore = cdp_store_new(&store->_dt, storage, store->indexing, store->compare);
+        break;
+      }
+      case CDP_STORAGE_ART: {
+        if (store->indexing != CDP_INDEX_BY_NAME)
+            return false;
+        newStore = cdp_store_new(&store->_dt, storage, store->indexing);
+        break;
+      }
+      case CDP_STORAGE_INLINE: {
+        if (store->chdCount > INLINE_MAX_CAPACITY)
+            return false;
+        size_t capacity = cdp_min(store->chdCount + 1, (size_t)INLINE_MAX_CAPACITY);
+        newStore = cdp_store_new(&store->_dt, storage, store->indexing, capacity, store->compare);
+        break;
+      }
+      default: {
+        return false;   // Storages needing extra parameters aren't switched to.
+      }
+    }
+    if CDP_RARELY(!newStore)
+        return false;
+
+    // Children are moved in order (and re-linked to their new siblings).
+    cdpStoreFilter* filter = store->filter;     // Same names (kept as is while moving).
+    store->filter = NULL;
+    cdpRecord child;
+    while (store_pop_child(store, &child)) {
+        if CDP_EXPECT(store_move_child(newStore, &child, false))
+            continue;
+
+        // Out of memory: children moved so far go back (last first) and nothing changes.
+        bool given = store_move_child(store, &child, true);
+        while (given  &&  store_take_record(newStore, &child))
+            given = store_move_child(store, &child, true);
+        if CDP_RARELY(!given) {
+            // Only stores releasing memory per child may fail taking it back.
+            assert(given);
+            cdp_record_finalize(&child);
+        }
+        store->filter = filter;
+        cdp_store_del(newStore);
+        return false;
+    }
+
+    newStore->attribute = store->attribute;
+    newStore->linked    = store->linked;
+    newStore->next      = store->next;
+    newStore->lock      = store->lock;
+    newStore->autoid    = store->autoid;
+    newStore->profile   = store->profile;
+    if (newStore->profile)
+        CDP_0(newStore->profile);
+    newStore->filter    = filter;
+    newStore->arena     = store->arena;
+    store->linked  = NULL;
+    store->next    = NULL;
+    store->profile = NULL;
+    store->arena   = NULL;
+    cdp_store_del(store);
+
+    newStore->owner = record;
+    record->store   = newStore;
+
+    return true;
+}
+
+
+/*
+    Switches record children to the storage advised by profiling
+*/
+bool cdp_record_adapt_storage(cdpRecord* record, const cdpStoreTuning* tuning) {
+    RECORD_FOLLOW_LINK_TO_STORE(record, store, false);
+
+    unsigned storage = cdp_store_advise(store, tuning);
+    if (storage != store->storage)
+        return cdp_record_convert_storage(record, storage);
+
+    cdpStoreTuning defaults = CDP_STORE_TUNING_DEFAULT;
+    cdpStoreProfile counted;
+    if (store->profile) {
+        store_profile_read(store->profile, &counted);
+        if (store_profile_total(&counted) >= (tuning? tuning: &defaults)->minOps)
+            store_profile_clear(store->profile);    // Start a new observation window.
+    }
+
+    return false;
 }
 
 
@@ -82,8 +82,9 @@
 
       Array: Offers fast access and efficient cache utilization for
       densely packed records. Ideal for situations where the number of
-      children is relatively static and operations are predominantly at
-      the tail end.
+      children is relatively static. A free gap is kept on both ends of
+      the children block, so it also works as a deque with cheap
+      operations at the head and the tail.
 
       Packed Queue: Strikes a balance between the cache efficiency of
       arrays and the flexibility of linked lists. It's optimized for
@@ -96,12 +97,40 @@
 
       Octree: Used for (3D) spatial indexing according to contained data.
       It only needs a comparation function able to determine if the record
-      fully fits inside a quadrant or not.
+      fully fits inside a quadrant or not. Box, sphere, nearest-neighbour
+      and ray queries skip whole quadrants outside the searched volume.
+      Leaves bucket a few records before splitting (up to a maximum
+      depth) and merge back as records leave.
+
+      Hash Table: Open addressing table keyed on the record name (or on its
+      data hash), giving constant time lookups in large dictionaries. It
+      doesn't sort children: they are kept in insertion order.
+
+      B+Tree: Wide nodes with packed keys and leaves linked in order,
+      so large sorted dictionaries and catalogs take fewer cache misses
+      per lookup than a red-black tree and scan sequentially.
+
+      Skip List: Sorted dictionary (or catalog) that several threads may
+      insert into, look up, iterate and remove from at once, without
+      locks. Threads sharing it must go online and report quiescent
+      states so removed children can be safely reclaimed.
+
+      Adaptive Radix Tree: Dictionary keyed on the name bytes, with
+      nodes growing from 4 to 256 branches as needed. Lookups touch
+      a few nodes whatever the number of children, making it a compact
+      sorted index for very large registries. Children sharing a
+      domain are contiguous, so they can be walked as a group.
+
+      Inline: A handful of children (up to 16) kept in the same block
+      as the store, so small records cost a single allocation. Once
+      full it turns itself into a regular array.
 */
 
 
 typedef struct _cdpData       cdpData;
 typedef struct _cdpStore      cdpStore;
+typedef struct _cdpStoreFilter cdpStoreFilter;
+typedef struct _cdpArena      cdpArena;
 typedef struct _cdpRecord     cdpRecord;
 
 typedef int (*cdpCompare)(const cdpRecord* restrict, const cdpRecord* restrict, void*);
@@ -149,6 +178,18 @@ static inline int cdp_dt_compare(const cdpDT* restrict key, const cdpDT* restric
     return 0;
 }
 
+static inline uint64_t cdp_dt_hash(const cdpDT* dt)
+{
+    // Mixes both name parts (system bits excluded) with a 64-bit finalizer.
+    uint64_t h = ((uint64_t)dt->domain * 0x9E3779B97F4A7C15ULL) ^ (uint64_t)dt->tag;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
 
 /*
  *  Record Meta
@@ -162,8 +203,7 @@ typedef struct {
       struct {
         cdpID   type:       2,    // Type of record (dictionary, link, etc).
                 hidden:     1,    // Record won't appear on listings (it can only be accessed directly).
-                shadowing:  2,    // If record has shadowing records (links pointing to it).
-                _unused:    1,
+                _unused:    3,    // (Handles and shadows are kept in the handle table: readers compare this word without locks.)
 
                 domain:     CDP_NAME_BITS;
       };
@@ -395,7 +435,8 @@ struct _cdpData {
       struct {
         struct {
           cdpID         datatype:   2,  // Type of data (see _cdpDataType).
-                        _unused:    4,
+                        interned:   1,  // Data is in the interning table (and read-only).
+                        _unused:    3,
 
                         domain:     CDP_NAME_BITS;
         };
@@ -416,8 +457,9 @@ struct _cdpData {
     size_t              capacity;       // Buffer capacity in bytes.
 
     cdpData*            next;           // Pointer to next data representation (if available).
+    uint32_t            refs;           // Records sharing this data (content is read-only while above one).
 
-    uint64_t            hash;           // Hash value of content.
+    uint64_t            hash;           // Hash value of content (0 until it is needed).
     union {
         struct {
             void*       data;           // Points to container of data value.
@@ -449,8 +491,15 @@ cdpData* cdp_data_new(  cdpDT* dt, cdpID encoding, cdpID attribute,
                         void** dataloc, void* value, ...  );
 void     cdp_data_del(cdpData* data);
 void*    cdp_data(const cdpData* data);
+cdpData* cdp_data_share(cdpData* data);
+uint64_t cdp_data_hash(cdpData* data);
+cdpData* cdp_data_intern(cdpData* data);
+size_t   cdp_data_interned_count(void);
 #define  cdp_data_valid(d)                                      ((d) && (d)->capacity && cdp_dt_valid(&(d)->_dt))
+#define  cdp_data_is_shared(d)                                  (__atomic_load_n(&(d)->refs, __ATOMIC_ACQUIRE) > 1)
+#define  cdp_data_hash_reset(d)                                 __atomic_store_n(&(d)->hash, 0, __ATOMIC_RELAXED)     /* Needed if content is changed without cdp_record_update(). */
 #define  cdp_data_new_value(dt, e, a, value, z)                 ({size_t _z = z;  cdp_data_new(dt, e, CDP_ID(a), CDP_DATATYPE_VALUE, true, NULL, value, _z, _z);})
+#define  cdp_data_new_interned(dt, e, a, value, z)              cdp_data_intern(cdp_data_new_value(dt, e, a, value, z))
 
 
 /*
@@ -458,21 +507,28 @@ void*    cdp_data(const cdpData* data);
 */
 
 typedef struct {
-    unsigned        count;      // Number of record pointers.
+    unsigned        count;      // Number of links.
     unsigned        capacity;   // Capacity of array.
-    cdpRecord*      record[];   // Array of records shadowing this one.
+    uint64_t        link[];     // Handles of the links shadowing a record (links move along with their siblings).
 } cdpShadow;
 
 
+typedef struct {
+    size_t      inserts;        // Children added anywhere but the head or tail.
+    size_t      headTail;       // Operations at the head or tail (first/last, append/prepend, pop/take).
+    size_t      lookups;        // Lookups by name (or by key).
+    size_t      positional;     // Access by position (or position queries).
+    size_t      traversals;     // Full traversals of children.
+} cdpStoreProfile;
+
 struct _cdpStore {
     union {
       cdpDT         _dt;
       
       struct {
         struct {
-        cdpID       storage:    3,              // Data structure for children storage (array, linked-list, etc).
+        cdpID       storage:    4,              // Data structure for children storage (array, linked-list, etc).
                     indexing:   2,              // Indexing (sorting) criteria for children.
-                    _unused:    1,
 
                     domain:     CDP_NAME_BITS;
         };
@@ -499,6 +555,11 @@ struct _cdpStore {
     size_t          chdCount;   // Number of child records.
     cdpCompare      compare;    // Compare function for indexing children.
     cdpID           autoid;     // Auto-increment ID for inserting new child records.
+    cdpStoreProfile* profile;   // Access counters (only when being profiled).
+    cdpStoreFilter* filter;     // Children name membership filter (only when enabled).
+    cdpArena*       arena;      // Arena released (in bulk) along with this store.
+    uint64_t        generation; // Bumped whenever children are added, removed or moved (never repeated at the same address).
+    size_t          handled;    // Children holding a handle (moves only re-key handles if there are any).
 
     // The specific storage structure will follow after this...
 };
@@ -509,6 +570,11 @@ enum _cdpRecordStorage {
     CDP_STORAGE_PACKED_QUEUE,   // Children stored in a packed queue.
     CDP_STORAGE_RED_BLACK_T,    // Children stored in a red-black tree.
     CDP_STORAGE_OCTREE,         // Children stored in an octree spatial index.
+    CDP_STORAGE_HASH_TABLE,     // Children stored in a hash table (unordered dictionary).
+    CDP_STORAGE_BTREE,          // Children stored in a B+tree (large sorted dictionaries).
+    CDP_STORAGE_SKIPLIST,       // Children stored in a lock-free skip list (shared between threads).
+    CDP_STORAGE_ART,            // Children stored in an adaptive radix tree (over their names).
+    CDP_STORAGE_INLINE,         // Children stored right after the store header (a few of them).
     //
     CDP_STORAGE_COUNT
 };
@@ -538,6 +604,57 @@ cdpRecord* cdp_store_add_child(cdpStore* store, uintptr_t context, cdpRecord* ch
 cdpRecord* cdp_store_append_child(cdpStore* store, bool prepend, cdpRecord* child);
 
 
+// Packed queue chunk (node) recycling
+typedef struct {
+    size_t      allocated;      // Chunks taken from the heap.
+    size_t      recycled;       // Chunks re-used from spares (or from the shared pool).
+    size_t      released;       // Chunks given back to the heap.
+    size_t      spare;          // Chunks currently kept for re-use.
+} cdpChunkStats;
+
+void cdp_store_share_chunks(cdpStore* store, bool shared);          // Lets a packed queue exchange spare chunks with others of the same chunk size.
+void cdp_store_chunk_stats(const cdpStore* store, cdpChunkStats* stats);     // A NULL store gets the totals of all queues.
+void cdp_store_chunk_pool_flush(void);
+
+void cdp_store_octree_limits(cdpStore* store, unsigned leafCapacity, unsigned maxDepth);     // Records per octree leaf before splitting, and deepest level allowed.
+
+// Threads sharing skip list stores (children they got stay valid until their next quiescent state)
+void cdp_store_thread_online(void);
+void cdp_store_thread_offline(void);
+void cdp_store_quiescent(void);
+
+
+// Slab allocation of stores, storage nodes and data
+typedef struct {
+    size_t      slabs;          // Slabs shared by all threads.
+    size_t      arenaSlabs;     // Slabs held by arenas.
+} cdpSlabStats;
+
+cdpArena* cdp_arena_new(void);
+void      cdp_arena_del(cdpArena* arena);
+cdpArena* cdp_arena_use(cdpArena* arena);                   // Calling thread allocates from arena (NULL goes back to shared slabs). Returns the one used before.
+void      cdp_store_arena(cdpStore* store, cdpArena* arena);    // Store deletes arena along with it (the branch root must not come from the arena, nor anything in it outlive the store).
+void      cdp_slab_stats(cdpSlabStats* stats);
+void      cdp_slab_flush(void);                             // Gives back the free items cached by the calling thread.
+
+
+// Storage profiling and switching
+typedef struct {
+    size_t      minOps;         // Operations observed before any switch is considered.
+    unsigned    positional;     // Percent of positional accesses that calls for an array.
+    unsigned    headTail;       // Percent of head/tail operations that calls for a packed queue (lists only).
+    size_t      treeChildren;   // Children count above which a sorted store becomes a red-black tree.
+} cdpStoreTuning;
+
+#define CDP_STORE_TUNING_DEFAULT    ((cdpStoreTuning){.minOps = 256, .positional = 50, .headTail = 90, .treeChildren = 64})
+
+void     cdp_store_profile(cdpStore* store, bool enable);
+
+// Lookups of names missing from an unsorted store are answered without a scan
+void     cdp_store_filter(cdpStore* store, bool enable);     // Renaming children of a filtered store isn't supported.
+unsigned cdp_store_advise(const cdpStore* store, const cdpStoreTuning* tuning);
+
+
 /*
     Record
 */
@@ -548,6 +665,28 @@ typedef struct {
     cdpDT           dt[];
 } cdpPath;
 
+typedef struct {
+    cdpDT           name;       // Child name at this level.
+    cdpStore*       store;      // Store it was last found in (NULL if not resolved).
+    uint64_t        generation; // Store generation back then.
+    cdpRecord*      record;     // Child found.
+} cdpPathStep;
+
+typedef struct {
+    const cdpRecord* start;     // Record the path starts from (it must outlive the compiled path).
+    unsigned        length;
+    size_t          walks;      // Levels that had to be searched (instead of taken from cache).
+    cdpPathStep     step[];
+} cdpCompiledPath;
+
+typedef struct {
+    cdpStore*       store;      // Store being walked.
+    cdpRecord*      record;     // Current child (NULL when past the end).
+    size_t          position;   // Position of the current child (SIZE_MAX after seeking by name or key, see cdp_cursor_position()).
+} cdpCursor;
+
+
+typedef uint64_t  cdpHandle;     // Stable record reference: slot (plus one) in the low half, slot generation in the high half.
 
 struct _cdpRecord {
     cdpMetarecord   metarecord; // Meta about this record entry (including name (DT), system bits, etc).
@@ -556,7 +695,7 @@ struct _cdpRecord {
     union {
         cdpData*    data;       // Address of cdpData structure.
 
-        cdpRecord*  link;       // Link to another record.
+        cdpHandle   link;       // Link to another record (as a handle, so it survives moves).
     };
 
     union {
@@ -581,6 +720,14 @@ typedef struct {
 
 typedef bool (*cdpTraverse)(cdpEntry*, void*);
 
+typedef struct {
+    float           subwide;        // Half the width/height/depth of the bounding space.
+    float           center[3];      // Center of the bounding space (XYZ coords).
+} cdpOctreeBound;                   // Given to spatial compare functions to test if a record fits.
+
+typedef void (*cdpSpatialLocate)(const cdpRecord* record, void* context, float center[3], float* radius);   // Gets the bounding sphere of a spatial child.
+typedef bool (*cdpSpatialFunc)(cdpRecord* record, float distance, void* context);                           // Receives each query hit (return false to stop).
+
 
 /*
  * Record Operations
@@ -610,7 +757,7 @@ static inline void  cdp_record_set_name(cdpRecord* record, cdpDT* name)     {ass
 #define cdp_record_is_flex(r)       ((r)->metarecord.type == CDP_TYPE_FLEX)
 #define cdp_record_is_link(r)       ((r)->metarecord.type == CDP_TYPE_LINK)
 
-#define cdp_record_is_shadowed(r)   ((r)->metarecord.shadowing)
+bool cdp_record_is_shadowed(const cdpRecord* record);     // If links point to record.
 #define cdp_record_is_private(r)    ((r)->metarecord.priv)
 #define cdp_record_is_system(r)     ((r)->metarecord.system)
 
@@ -618,11 +765,12 @@ static inline bool cdp_record_has_data(const cdpRecord* record)     {assert(cdp_
 static inline bool cdp_record_has_store(const cdpRecord* record)    {assert(cdp_record_is_normal(record));  return record->store;}
 
 static inline void cdp_record_set_data(cdpRecord* record, cdpData* data)      {assert(!cdp_record_has_data(record) && cdp_data_valid(data));   record->data = data;}
+static inline cdpData* cdp_record_share_data(cdpRecord* record)               {assert(cdp_record_has_data(record));  return cdp_data_share(record->data);}
 static inline void cdp_record_set_store(cdpRecord* record, cdpStore* store)   {assert(!cdp_record_has_store(record) && cdp_store_valid(store));  store->owner = record; record->store = store;}
 
 static inline cdpRecord* cdp_record_parent  (const cdpRecord* record)   {assert(record);  return CDP_EXPECT_PTR(record->parent)? record->parent->owner: NULL;}
 static inline size_t     cdp_record_siblings(const cdpRecord* record)   {assert(record);  return CDP_EXPECT_PTR(record->parent)? record->parent->chdCount: 0;}
-static inline size_t     cdp_record_children(const cdpRecord* record)   {assert(record);  return cdp_record_has_store(record)? record->store->chdCount: 0;}
+static inline size_t     cdp_record_children(const cdpRecord* record)   {assert(record);  return (!cdp_record_is_link(record) && record->store)? __atomic_load_n(&record->store->chdCount, __ATOMIC_RELAXED): 0;}     // Links have none (they aren't followed).
 
 #define cdp_record_id_is_pending(r)   cdp_id_is_auto((r)->metarecord.tag)
 static inline void  cdp_record_set_autoid(const cdpRecord* record, cdpID id)  {assert(cdp_record_has_store(record) && (record->store->autoid < id)  &&  (id <= CDP_AUTOID_MAX)); record->store->autoid = id;}
@@ -634,10 +782,31 @@ static inline cdpID cdp_record_get_autoid(const cdpRecord* record)            {a
 
 static inline void cdp_record_relink_storage(cdpRecord* record)     {assert(cdp_record_has_store(record));  record->store->owner = record;}     // Re-links record with its own children storage.
 
+
+// Generational handles: a record keeps its handle wherever it is moved, until it is finalized (then the handle resolves to NULL).
+// The handle table (and the link shadows kept in it) is locked for writers, so records of shared stores may be handled and linked from any thread; resolving (and pulling cached links) takes no lock.
+cdpHandle  cdp_record_handle(cdpRecord* record);      // Gets (or assigns) the handle of a record.
+cdpRecord* cdp_handle_resolve(cdpHandle handle);
+size_t     cdp_handle_count(void);
+bool       cdp_record_is_handled(const cdpRecord* record);
+
+void cdp_record_handles_moved(cdpRecord* dst, const cdpRecord* src, size_t count);
+
+static inline void cdp_record_moved(cdpRecord* dst, const cdpRecord* src, size_t count) {
+    // Storages call this once 'count' records were moved (memmove) from 'src' to 'dst'.
+    extern size_t CDP_HANDLE_LOOSE;
+    if (!count)
+        return;
+    const size_t* handled = dst->parent?  &dst->parent->handled:  &CDP_HANDLE_LOOSE;  // Records moved together share their parent.
+    if CDP_RARELY(__atomic_load_n(handled, __ATOMIC_RELAXED))
+        cdp_record_handles_moved(dst, src, count);
+}
+
 static inline void cdp_record_transfer(cdpRecord* src, cdpRecord* dst) {
     assert(!cdp_record_is_void(src) && dst);
 
     *dst = *src;
+    cdp_record_moved(dst, src, 1);
 
     if (!cdp_record_is_link(dst) && dst->store) {
         dst->store->owner = dst;
@@ -659,13 +828,11 @@ static inline void cdp_record_replace(cdpRecord* oldr, cdpRecord* newr) {
 static inline cdpRecord* cdp_root(void)  {extern cdpRecord CDP_ROOT; assert(!cdp_record_is_void(&CDP_ROOT));  return &CDP_ROOT;}
 
 
-// Links
-static inline void cdp_link_set(cdpRecord* link, cdpRecord* target) {
-    assert(link && cdp_record_is_link(link));
-    assert(target && !cdp_record_is_void(target) && cdp_record_parent(target));     // Links to "root" aren't allowed for now.
-    link->link = target;
-    // ToDo: remove link from target's shadows.
-}
+// Links (targets keep track of the links pointing to them, so deleting a target nulls its links at once)
+void   cdp_link_set(cdpRecord* link, cdpRecord* target);
+void   cdp_link_redirect(cdpRecord* target, cdpRecord* newTarget);              // Moves all links from target to newTarget.
+size_t cdp_record_shadows(const cdpRecord* record, cdpRecord** link, size_t max);  // Gets up to 'max' links pointing to record, returning how many there are.
+cdpRecord* cdp_link_resolve(cdpRecord* link);                                     // Follows a chain of links, caching its final record on each of them.
 
 static inline void cdp_link_initialize(cdpRecord* link, cdpDT* name, cdpRecord* target) {
     assert(link);
@@ -676,10 +843,9 @@ static inline void cdp_link_initialize(cdpRecord* link, cdpDT* name, cdpRecord*
 
 static inline cdpRecord* cdp_link_pull(cdpRecord* link) {
     assert(link);
-    while (cdp_record_is_link(link)) {
-        link = link->link;
-    }
-    return link;
+    if (!cdp_record_is_link(link))
+        return link;
+    return cdp_link_resolve(link);  // NULL if the linked record is gone.
 }
 
 static inline bool cdp_record_is_insertable(cdpRecord* record)  {assert(cdp_record_has_store(record));  return record->store? cdp_store_is_insertable(record->store): false;}
@@ -693,21 +859,30 @@ static inline bool cdp_record_is_root(cdpRecord* record)        {assert(record);
 static inline bool cdp_record_is_floating(cdpRecord* record)    {assert(record);  return (cdp_record_is_void(record)  ||  (!cdp_record_parent(record) && !cdp_record_is_root(record)));}
 
 
-// Appends/prepends or inserts a (copy of) record into another record
+// Appends/prepends or inserts a (copy of) record into another record (NULL if it can't, as when out of memory)
 cdpRecord* cdp_record_add(cdpRecord* record, uintptr_t context, cdpRecord* child);
 cdpRecord* cdp_record_append(cdpRecord* record, bool prepend, cdpRecord* child);
 
+#define cdp_record_child_discard(added, child)                                  \
+    ({if (!(added) && !cdp_record_is_void(child)) cdp_record_finalize(child); (added);})
+
 #define cdp_record_add_child(record, type, name, context, data, store)         \
-    ({cdpRecord child__={0}; cdp_record_initialize(&child__, type, name, data, store); cdp_record_add(record, context, &child__);})
+    ({cdpRecord child__={0}; cdp_record_initialize(&child__, type, name, data, store); cdpRecord* added__ = cdp_record_add(record, context, &child__); cdp_record_child_discard(added__, &child__);})
+
+#define cdp_record_add_new_data(record, name, context, data)                   \
+    ({cdpData*  data__ = (data);   data__?  cdp_record_add_child(record, CDP_TYPE_NORMAL, name, context, data__, NULL):  NULL;})
+#define cdp_record_add_new_store(record, name, context, store)                 \
+    ({cdpStore* store__ = (store); store__? cdp_record_add_child(record, CDP_TYPE_NORMAL, name, context, NULL, store__): NULL;})
 
 #define cdp_record_add_empty(record, name, context)                                                             cdp_record_add_child(record, CDP_TYPE_NORMAL, name, (uintptr_t)(context), NULL, NULL)
-#define cdp_record_add_value(record, name, context, dt, encoding, attrib, value, size, capacity)                cdp_record_add_child(record, CDP_TYPE_NORMAL, name, (uintptr_t)(context), cdp_data_new(dt, encoding, attrib, CDP_DATATYPE_VALUE, true, NULL, value, size, capacity), NULL)
-#define cdp_record_add_data(record, name, context, dt, encoding, attrib, value, size, capacity, destructor)     cdp_record_add_child(record, CDP_TYPE_NORMAL, name, (uintptr_t)(context), cdp_data_new(dt, encoding, attrib, CDP_DATATYPE_DATA,  true, NULL, value, size, capacity, destructor), NULL)
+#define cdp_record_add_value(record, name, context, dt, encoding, attrib, value, size, capacity)                cdp_record_add_new_data(record, name, (uintptr_t)(context), cdp_data_new(dt, encoding, attrib, CDP_DATATYPE_VALUE, true, NULL, value, size, capacity))
+#define cdp_record_add_data(record, name, context, dt, encoding, attrib, value, size, capacity, destructor)     cdp_record_add_new_data(record, name, (uintptr_t)(context), cdp_data_new(dt, encoding, attrib, CDP_DATATYPE_DATA,  true, NULL, value, size, capacity, destructor))
 
-#define cdp_record_add_list(record, name, context, dt, storage, ...)                                        cdp_record_add_child(record, CDP_TYPE_NORMAL, name, (uintptr_t)(context), NULL, cdp_store_new(dt, storage, CDP_INDEX_BY_INSERTION, ##__VA_ARGS__))
-#define cdp_record_add_dictionary(record, name, context, dt, storage, ...)                                  cdp_record_add_child(record, CDP_TYPE_NORMAL, name, (uintptr_t)(context), NULL, cdp_store_new(dt, storage, CDP_INDEX_BY_NAME, ##__VA_ARGS__))
-#define cdp_record_add_catalog(record, name, context, dt, storage, ...)                                     cdp_record_add_child(record, CDP_TYPE_NORMAL, name, (uintptr_t)(context), NULL, cdp_store_new(dt, storage, CDP_INDEX_BY_FUNCTION, ##__VA_ARGS__))
+#define cdp_record_add_list(record, name, context, dt, storage, ...)                                        cdp_record_add_new_store(record, name, (uintptr_t)(context), cdp_store_new(dt, storage, CDP_INDEX_BY_INSERTION, ##__VA_ARGS__))
+#define cdp_record_add_dictionary(record, name, context, dt, storage, ...)                                  cdp_record_add_new_store(record, name, (uintptr_t)(context), cdp_store_new(dt, storage, CDP_INDEX_BY_NAME, ##__VA_ARGS__))
+#define cdp_record_add_catalog(record, name, context, dt, storage, ...)                                     cdp_record_add_new_store(record, name, (uintptr_t)(context), cdp_store_new(dt, storage, CDP_INDEX_BY_FUNCTION, ##__VA_ARGS__))
 
+#define cdp_record_add_shared(record, name, context, source)                                                cdp_record_add_new_data(record, name, (uintptr_t)(context), cdp_record_share_data(source))
 #define cdp_record_add_link(record, name, context, source)                                                  cdp_record_add_child(record, CDP_TYPE_LINK, name, (uintptr_t)(context), CDP_P(source), NULL)
 
 #define cdp_dict_add(record, child)                                                                         cdp_record_add(record, 0, child)
@@ -717,29 +892,37 @@ cdpRecord* cdp_record_append(cdpRecord* record, bool prepend, cdpRecord* child);
 #define cdp_dict_add_list(record, name, dt, storage, ...)                                                   cdp_record_add_list(record, name, 0, dt, storage, ##__VA_ARGS__)
 #define cdp_dict_add_dictionary(record, name, dt, storage, ...)                                             cdp_record_add_dictionary(record, name, 0, dt, storage, ##__VA_ARGS__)
 #define cdp_dict_add_catalog(record, name, dt, storage, ...)                                                cdp_record_add_catalog(record, name, 0, dt, storage, ##__VA_ARGS__)
+#define cdp_dict_add_shared(record, name, source)                                                           cdp_record_add_shared(record, name, 0, source)
 #define cdp_dict_add_link(record, name, source)                                                             cdp_record_add_link(record, name, 0, source)
 
 #define cdp_record_append_child(record, type, name, prepend, data, store)      \
-    ({cdpRecord child__={0}; cdp_record_initialize(&child__, type, name, data, store); cdp_record_append(record, prepend, &child__);})
+    ({cdpRecord child__={0}; cdp_record_initialize(&child__, type, name, data, store); cdpRecord* added__ = cdp_record_append(record, prepend, &child__); cdp_record_child_discard(added__, &child__);})
+
+#define cdp_record_append_new_data(record, name, prepend, data)                \
+    ({cdpData*  data__ = (data);   data__?  cdp_record_append_child(record, CDP_TYPE_NORMAL, name, prepend, data__, NULL):  NULL;})
+#define cdp_record_append_new_store(record, name, prepend, store)              \
+    ({cdpStore* store__ = (store); store__? cdp_record_append_child(record, CDP_TYPE_NORMAL, name, prepend, NULL, store__): NULL;})
 
 #define cdp_record_append_empty(record, name)                                                               cdp_record_append_child(record, CDP_TYPE_NORMAL, name, false, NULL, NULL)
-#define cdp_record_append_value(record, name, dt, encoding, attrib, value, size, capacity)                  cdp_record_append_child(record, CDP_TYPE_NORMAL, name, false, cdp_data_new(dt, encoding, attrib, CDP_DATATYPE_VALUE, true, NULL, value, size, capacity), NULL)
-#define cdp_record_append_data(record, name, dt, encoding, attrib, value, size, capacity, destructor)       cdp_record_append_child(record, CDP_TYPE_NORMAL, name, false, cdp_data_new(dt, encoding, attrib, CDP_DATATYPE_DATA,  true, NULL, value, size, capacity, destructor), NULL)
+#define cdp_record_append_value(record, name, dt, encoding, attrib, value, size, capacity)                  cdp_record_append_new_data(record, name, false, cdp_data_new(dt, encoding, attrib, CDP_DATATYPE_VALUE, true, NULL, value, size, capacity))
+#define cdp_record_append_data(record, name, dt, encoding, attrib, value, size, capacity, destructor)       cdp_record_append_new_data(record, name, false, cdp_data_new(dt, encoding, attrib, CDP_DATATYPE_DATA,  true, NULL, value, size, capacity, destructor))
 
-#define cdp_record_append_list(record, name, dt, storage, ...)                                              cdp_record_append_child(record, CDP_TYPE_NORMAL, name, false, NULL, cdp_store_new(dt, storage, CDP_INDEX_BY_INSERTION, ##__VA_ARGS__))
-#define cdp_record_append_dictionary(record, name, dt, storage, ...)                                        cdp_record_append_child(record, CDP_TYPE_NORMAL, name, false, NULL, cdp_store_new(dt, storage, CDP_INDEX_BY_NAME, ##__VA_ARGS__))
-#define cdp_record_append_catalog(record, name, dt, storage, ...)                                           cdp_record_append_child(record, CDP_TYPE_NORMAL, name, false, NULL, cdp_store_new(dt, storage, CDP_INDEX_BY_FUNCTION, ##__VA_ARGS__))
+#define cdp_record_append_list(record, name, dt, storage, ...)                                              cdp_record_append_new_store(record, name, false, cdp_store_new(dt, storage, CDP_INDEX_BY_INSERTION, ##__VA_ARGS__))
+#define cdp_record_append_dictionary(record, name, dt, storage, ...)                                        cdp_record_append_new_store(record, name, false, cdp_store_new(dt, storage, CDP_INDEX_BY_NAME, ##__VA_ARGS__))
+#define cdp_record_append_catalog(record, name, dt, storage, ...)                                           cdp_record_append_new_store(record, name, false, cdp_store_new(dt, storage, CDP_INDEX_BY_FUNCTION, ##__VA_ARGS__))
 
+#define cdp_record_append_shared(record, name, source)                                                      cdp_record_append_new_data(record, name, false, cdp_record_share_data(source))
 #define cdp_record_append_link(record, name, source)                                                        cdp_record_append_child(record, CDP_TYPE_LINK, name, false, CDP_P(source), NULL)
 
 #define cdp_record_prepend_empty(record, name)                                                              cdp_record_append_child(record, CDP_TYPE_NORMAL, name, true, NULL, NULL)
-#define cdp_record_prepend_value(record, name, dt, encoding, attrib, value, size, capacity)                 cdp_record_append_child(record, CDP_TYPE_NORMAL, name, true, cdp_data_new(dt, encoding, attrib, CDP_DATATYPE_VALUE, true, NULL, value, size, capacity), NULL)
-#define cdp_record_prepend_data(record, name, dt, encoding, attrib, value, size, capacity, destructor)      cdp_record_append_child(record, CDP_TYPE_NORMAL, name, true, cdp_data_new(dt, encoding, attrib, CDP_DATATYPE_DATA,  true, NULL, value, size, capacity, destructor), NULL)
+#define cdp_record_prepend_value(record, name, dt, encoding, attrib, value, size, capacity)                 cdp_record_append_new_data(record, name, true, cdp_data_new(dt, encoding, attrib, CDP_DATATYPE_VALUE, true, NULL, value, size, capacity))
+#define cdp_record_prepend_data(record, name, dt, encoding, attrib, value, size, capacity, destructor)      cdp_record_append_new_data(record, name, true, cdp_data_new(dt, encoding, attrib, CDP_DATATYPE_DATA,  true, NULL, value, size, capacity, destructor))
 
-#define cdp_record_prepend_list(record, name, dt, storage, ...)                                             cdp_record_append_child(record, CDP_TYPE_NORMAL, name, true, NULL, cdp_store_new(dt, storage, CDP_INDEX_BY_INSERTION, ##__VA_ARGS__))
-#define cdp_record_prepend_dictionary(record, name, dt, storage, ...)                                       cdp_record_append_child(record, CDP_TYPE_NORMAL, name, true, NULL, cdp_store_new(dt, storage, CDP_INDEX_BY_NAME, ##__VA_ARGS__))
-#define cdp_record_prepend_catalog(record, name, dt, storage, ...)                                          cdp_record_append_child(record, CDP_TYPE_NORMAL, name, true, NULL, cdp_store_new(dt, storage, CDP_INDEX_BY_FUNCTION, ##__VA_ARGS__))
+#define cdp_record_prepend_list(record, name, dt, storage, ...)                                             cdp_record_append_new_store(record, name, true, cdp_store_new(dt, storage, CDP_INDEX_BY_INSERTION, ##__VA_ARGS__))
+#define cdp_record_prepend_dictionary(record, name, dt, storage, ...)                                       cdp_record_append_new_store(record, name, true, cdp_store_new(dt, storage, CDP_INDEX_BY_NAME, ##__VA_ARGS__))
+#define cdp_record_prepend_catalog(record, name, dt, storage, ...)                                          cdp_record_append_new_store(record, name, true, cdp_store_new(dt, storage, CDP_INDEX_BY_FUNCTION, ##__VA_ARGS__))
 
+#define cdp_record_prepend_shared(record, name, source)                                                     cdp_record_append_new_data(record, name, true, cdp_record_share_data(source))
 #define cdp_record_prepend_link(record, name, source)                                                       cdp_record_append_child(record, CDP_TYPE_LINK, name, true, CDP_P(source), NULL)
 
 
@@ -754,16 +937,51 @@ cdpRecord* cdp_record_last (const cdpRecord* record);
 cdpRecord* cdp_record_find_by_name(const cdpRecord* record, const cdpDT* name);
 cdpRecord* cdp_record_find_by_key(const cdpRecord* record, cdpRecord* key, cdpCompare compare, void* context);
 cdpRecord* cdp_record_find_by_position(const cdpRecord* record, size_t position);
+size_t     cdp_record_index_of(const cdpRecord* record);
 cdpRecord* cdp_record_find_by_path(const cdpRecord* start, const cdpPath* path);
 
+// Paths resolved once and then re-checked against store generations (only levels that changed are searched again)
+cdpCompiledPath* cdp_compiled_path_new(const cdpRecord* start, const cdpPath* path);
+void             cdp_compiled_path_del(cdpCompiledPath* compiled);
+cdpRecord*       cdp_record_find_by_compiled_path(cdpCompiledPath* compiled);
+
 cdpRecord* cdp_record_prev(const cdpRecord* record, cdpRecord* child);
 cdpRecord* cdp_record_next(const cdpRecord* record, cdpRecord* child);
 
+// Pull-style iteration: the cursor keeps its place between calls, so loops need no callbacks (nor any stack, as stores link siblings).
+cdpRecord* cdp_cursor_first        (cdpCursor* cursor, const cdpRecord* record);
+cdpRecord* cdp_cursor_next         (cdpCursor* cursor);
+cdpRecord* cdp_cursor_seek         (cdpCursor* cursor, const cdpDT* name);
+cdpRecord* cdp_cursor_seek_key     (cdpCursor* cursor, cdpRecord* key, cdpCompare compare, void* context);
+cdpRecord* cdp_cursor_seek_position(cdpCursor* cursor, size_t position);
+size_t     cdp_cursor_position     (cdpCursor* cursor);                                  // Position of the current child (found, only when asked, after seeking by name or key).
+size_t     cdp_cursor_batch        (cdpCursor* cursor, cdpRecord** batch, size_t max);   // Fills 'batch' with up to 'max' children, moving past them.
+size_t     cdp_cursor_span         (cdpCursor* cursor, cdpRecord** span);                // Sets 'span' to a run of children contiguous in memory, returning its length.
+
+#define cdp_cursor_foreach(cursor, record, child)   for (cdpRecord* child = cdp_cursor_first(cursor, record);  child;  child = cdp_cursor_next(cursor))
+
 cdpRecord* cdp_record_find_next_by_name(const cdpRecord* record, cdpDT* name, uintptr_t* childIdx);
 cdpRecord* cdp_record_find_next_by_path(const cdpRecord* start, cdpPath* path, uintptr_t* prev);
 
 bool cdp_record_traverse     (cdpRecord* record, cdpTraverse func, void* context, cdpEntry* entry);
 bool cdp_record_deep_traverse(cdpRecord* record, cdpTraverse func, cdpTraverse listEnd, void* context, cdpEntry* entry);
+bool cdp_record_traverse_domain(cdpRecord* record, cdpID domain, cdpTraverse func, void* context, cdpEntry* entry);   // Only children named in 'domain'.
+
+// Parallel deep traversal: subtrees are spread over 'workers' threads (the caller being one of them) that steal work from each other.
+// 'func' gets the context of the worker calling it ('contexts' holds one of 'contextSize' bytes per worker), and may run concurrently
+// with itself for different records. It may read anything and write the data of the record it is given (or its own context), but no
+// record of the branch may be added, removed or moved until the traversal ends. Sibling order is kept, but not the order between subtrees.
+// Once all are done, 'reduce' (if given) folds each worker context (in worker order) into 'result' from the calling thread.
+// Only the traversal of 'record' itself is profiled (workers leave store profiles alone), and worker threads give back their cached slab items before ending.
+// It returns false if 'func' stopped it or memory ran out (then not all records were visited), and 'record' can't be a link.
+typedef void (*cdpReduce)(void* result, void* workerContext);
+bool cdp_record_parallel_traverse(cdpRecord* record, cdpTraverse func, unsigned workers, void* contexts, size_t contextSize, cdpReduce reduce, void* result);
+
+// Spatial (octree) queries: each child volume is given by 'locate' as a sphere
+bool   cdp_record_spatial_box    (const cdpRecord* record, const float min[3], const float max[3], cdpSpatialLocate locate, cdpSpatialFunc func, void* context);
+bool   cdp_record_spatial_sphere (const cdpRecord* record, const float center[3], float radius, cdpSpatialLocate locate, cdpSpatialFunc func, void* context);
+bool   cdp_record_spatial_ray    (const cdpRecord* record, const float origin[3], const float direction[3], float length, cdpSpatialLocate locate, cdpSpatialFunc func, void* context);
+size_t cdp_record_spatial_nearest(const cdpRecord* record, const float point[3], size_t k, cdpSpatialLocate locate, void* context, cdpRecord** nearest, float* distance);
 
 
 // Removing records
@@ -785,6 +1003,7 @@ static inline void* cdp_record_data_find_by_name(const cdpRecord* record, cdpDT*
     return cdp_record_data(found);
 }
 
+// Updating data (shared data is copied first, so the other records keep seeing the old content)
 void* cdp_record_update(cdpRecord* record, size_t size, size_t capacity, void* value, bool swap);
 #define cdp_record_update_value(r, z, v)    cdp_record_update(r, (z), sizeof(*(v)), v, false)
 #define cdp_record_update_attribute(r, a)   do{ assert(cdp_record_has_data(r);  (r)->data.attribute.id = CDP_ID(a); }while(0)
@@ -798,10 +1017,17 @@ static inline void cdp_record_dispose(cdpRecord* record)            {if (record
 
 // Converts an unsorted record into a sorted one
 void cdp_record_to_dictionary(cdpRecord* record);
-void cdp_record_sort(cdpRecord* record, cdpCompare compare, void* context);
+bool cdp_record_sort(cdpRecord* record, cdpCompare compare, void* context);    // False if the storage can't be sorted (hash tables must be converted first).
+
+// Moves children into another storage (keeping indexing), or into the one advised by profiling.
+// Adapting is never triggered by the library itself (it moves every child, so it must happen when the
+// caller holds no child pointer): call it periodically, it starts a new observation window each time.
+bool cdp_record_convert_storage(cdpRecord* record, unsigned storage);
+bool cdp_record_adapt_storage(cdpRecord* record, const cdpStoreTuning* tuning);
 
 
-// Initiate and shutdown record system
+// Initiate and shutdown record system (the allocator may only be set before initiating)
+void cdp_record_system_allocator(const cdpAllocator* allocator);
 void cdp_record_system_initiate(void);
 void cdp_record_system_shutdown(void);
 
@@ -812,7 +1038,6 @@ void cdp_record_system_shutdown(void);
     - Implement range queries (between a minimum and a maximum key) for records.
     - Implement clone (deep copy) records.
     - Traverse book in internal (stoTech) order.
-    - Add indexof for records.
     - Update MAX_DEPTH based on path/traverse operations.
     - Add cdp_record_update_nested_links(old, new).
     - If a record is added with its name explicitly above "auto_id", then that must be updated.
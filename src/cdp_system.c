@@ -234,7 +234,7 @@ cdpRecord* DATA;
 cdpRecord* NETWORK;
 cdpRecord* TEMP;
 
-cdpRecord* AGENCIES;
+cdpHandle  AGENCIES;     // A handle, as the "system" dictionary it sits in is an array.
 //cdpRecord* LIBRARY;
 
 cdpRecord* CDP_STEP;
@@ -258,7 +258,7 @@ static void system_initiate(void) {
     TEMP    = cdp_dict_add_list(&CDP_ROOT, CDP_DTAW("CDP", "temp"), CDP_DTAW("CDP", "list"), CDP_STORAGE_LINKED_LIST);
 
     // Initiate system structure
-    AGENCIES = cdp_dict_add_dictionary(system, CDP_DTAW("CDP", "agencies"), CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_RED_BLACK_T);
+    AGENCIES = cdp_record_handle(cdp_dict_add_dictionary(system, CDP_DTAW("CDP", "agencies"), CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_RED_BLACK_T));
     //LIBRARY = cdp_dict_add_dictionary(system, CDP_WORD_LIBRARY, CDP_ACRO("CDP"), CDP_WORD("dictionary"), CDP_STORAGE_RED_BLACK_T);
 
     // Add system agents
@@ -303,7 +303,7 @@ void cdp_system_shutdown(void) {
     cdp_record_delete_children(&CDP_ROOT);
     cdp_record_system_shutdown();
 
-    AGENCIES = NULL;
+    AGENCIES = 0;
 }
 
 
@@ -319,10 +319,10 @@ bool cdp_agency_register_agent(cdpDT* agency, cdpDT* input, cdpAgent agent) {
     if (!AGENCIES)
         system_initiate();
 
-    cdpRecord* ragencies = cdp_record_find_by_name(AGENCIES, agency);
+    cdpRecord* ragencies = cdp_record_find_by_name(cdp_handle_resolve(AGENCIES), agency);
     if (!ragencies) {
         // Create agency structure
-        ragencies = cdp_dict_add_dictionary(AGENCIES, agency, CDP_DTAW("CDP", "agency"), CDP_STORAGE_ARRAY, 4); {
+        ragencies = cdp_dict_add_dictionary(cdp_handle_resolve(AGENCIES), agency, CDP_DTAW("CDP", "agency"), CDP_STORAGE_ARRAY, 4); {
             cdp_dict_add_dictionary(ragencies, CDP_DTAW("CDP", "inputs"),  CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_RED_BLACK_T);
             cdp_dict_add_dictionary(ragencies, CDP_DTAW("CDP", "outputs"), CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_RED_BLACK_T);
             cdp_dict_add_list      (ragencies, CDP_DTAW("CDP", "tasks"),   CDP_DTAW("CDP", "queue"),      CDP_STORAGE_LINKED_LIST);
@@ -344,7 +344,7 @@ bool cdp_agency_set_output(cdpDT* agency, cdpDT* output) {
     if CDP_NOT_ASSERT(AGENCIES)
         return false;
 
-    cdpRecord* ragencies = cdp_record_find_by_name(AGENCIES, agency);
+    cdpRecord* ragencies = cdp_record_find_by_name(cdp_handle_resolve(AGENCIES), agency);
     if CDP_NOT_ASSERT(ragencies)
         return false;
         
@@ -365,7 +365,7 @@ cdpRecord* cdp_record_add_agency_instance(  cdpRecord* record, cdpDT* name, uint
         return NULL;
 
     // Create instance structure
-    cdpRecord* instance = cdp_record_add_dictionary(record, name, context, CDP_DTAW("CDP", "instance"), CDP_STORAGE_ARRAY, 4); {
+    cdpRecord* instance = cdp_record_add_dictionary(record, name, context, CDP_DTAW("CDP", "instance"), CDP_STORAGE_INLINE, 4); {
         cdp_dict_add_binary_dt (instance, CDP_DTAW("CDP", "agency"),     agency);
         cdp_dict_add_link      (instance, CDP_DTAW("CDP", "client"),     client);
         cdp_dict_add_dictionary(instance, CDP_DTAW("CDP", "outputs"),    CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_RED_BLACK_T);
@@ -387,7 +387,7 @@ bool cdp_agency_instance_message(cdpRecord* instance, cdpDT* input, cdpRecord* m
     if CDP_NOT_ASSERT(agency)
         return false;
     
-    cdpRecord* ragency = cdp_record_find_by_name(AGENCIES, agency);
+    cdpRecord* ragency = cdp_record_find_by_name(cdp_handle_resolve(AGENCIES), agency);
     if CDP_NOT_ASSERT(ragency)
         return false;
                 
@@ -397,7 +397,7 @@ bool cdp_agency_instance_message(cdpRecord* instance, cdpDT* input, cdpRecord* m
     
     // Create task structure
     cdpRecord task = {0};
-    cdp_record_initialize_dictionary(&task, input, CDP_DTAW("CDP", "task"), CDP_STORAGE_ARRAY, 2); {
+    cdp_record_initialize_dictionary(&task, input, CDP_DTAW("CDP", "task"), CDP_STORAGE_INLINE, 2); {
         cdp_dict_add_link(&task, CDP_DTAW("CDP", "instance"), instance);
         cdpRecord* rmessage = cdp_dict_add_list(&task, CDP_DTAW("CDP", "message"), CDP_DTAW("CDP", "list"), CDP_STORAGE_LINKED_LIST); {
             if (message)
@@ -437,7 +437,7 @@ bool cdp_agency_output_connect(cdpRecord* sourceI, cdpDT* output, cdpRecord* tar
 
     // Create channel structure (message):
     cdpRecord channel = {0};
-    cdp_record_initialize_dictionary(&channel, CDP_DTAW("CDP", "channel"), CDP_DTAW("CDP", "channel"), CDP_STORAGE_ARRAY, 3); {
+    cdp_record_initialize_dictionary(&channel, CDP_DTAW("CDP", "channel"), CDP_DTAW("CDP", "channel"), CDP_STORAGE_INLINE, 3); {
         cdp_dict_add_binary_dt(&channel, CDP_DTAW("CDP", "input"),  input);
         cdp_dict_add_binary_dt(&channel, CDP_DTAW("CDP", "output"), output);
         cdp_dict_add_link     (&channel, CDP_DTAW("CDP", "target"), targetI);
@@ -60,14 +60,40 @@
  * Memory Initialization
  */
 
+// Allocators are swapped only while nothing allocated with the previous one is alive.
+typedef struct {
+    void*   (*alloc)(void* context, size_t size);
+    void*   (*realloc)(void* context, void* ptr, size_t size);
+    void*   (*aligned)(void* context, size_t alignment, size_t size);
+    void    (*free)(void* context, void* ptr);
+    void*   context;
+} cdpAllocator;
+
+extern cdpAllocator CDP_ALLOCATOR;      // Allocator in use (libc's by default).
+
+static inline void* cdp_libc_alloc(void* context, size_t z)                  {(void)context;  return malloc(z);}
+static inline void* cdp_libc_realloc(void* context, void* p, size_t z)       {(void)context;  return realloc(p, z);}
+static inline void* cdp_libc_aligned(void* context, size_t a, size_t z)      {(void)context;  return aligned_alloc(a, z);}
+static inline void  cdp_libc_free(void* context, void* p)                    {(void)context;  free(p);}
+
+#define CDP_ALLOCATOR_LIBC    ((cdpAllocator){cdp_libc_alloc, cdp_libc_realloc, cdp_libc_aligned, cdp_libc_free, NULL})
+
 #if (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
   #error    unsoported target platform!
 #else
-  static inline void*   cdp_malloc(size_t z)                   {void* p = malloc(z);       if CDP_RARELY(!p)  abort();  return p;}
-  static inline void*   cdp_calloc(size_t n, size_t z)         {void* p = calloc(n, z);    if CDP_RARELY(!p)  abort();  return p;}
-  static inline void*   cdp_realloc(void* p, size_t z)         {void* r = realloc(p, z);   if CDP_RARELY(!r)  abort();  return r;}
+  // These may fail (returning NULL).
+  static inline void*   cdp_try_malloc(size_t z)                {return CDP_ALLOCATOR.alloc(CDP_ALLOCATOR.context, z);}
+  static inline void*   cdp_try_malloc0(size_t z)               {void* p = cdp_try_malloc(z);  if CDP_EXPECT_PTR(p)  memset(p, 0, z);  return p;}
+  static inline void*   cdp_try_realloc(void* p, size_t z)      {return CDP_ALLOCATOR.realloc(CDP_ALLOCATOR.context, p, z);}
+  static inline void*   cdp_try_aligned_alloc(size_t a, size_t z)   {return CDP_ALLOCATOR.aligned(CDP_ALLOCATOR.context, a, z);}
+
+  // These can't fail (running out of memory aborts).
+  static inline void*   cdp_malloc(size_t z)                   {void* p = cdp_try_malloc(z);   if CDP_RARELY(!p)  abort();  return p;}
+  static inline void*   cdp_calloc(size_t n, size_t z)         {size_t t;  if CDP_RARELY(__builtin_mul_overflow(n, z, &t))  abort();  return memset(cdp_malloc(t), 0, t);}
+  static inline void*   cdp_realloc(void* p, size_t z)         {void* r = cdp_try_realloc(p, z);   if CDP_RARELY(!r)  abort();  return r;}
+  static inline void*   cdp_aligned_alloc(size_t a, size_t z)  {void* p = cdp_try_aligned_alloc(a, z);  if CDP_RARELY(!p)  abort();  return p;}
+  static inline void    cdp_free(void* p)                      {if (p)  CDP_ALLOCATOR.free(CDP_ALLOCATOR.context, p);}
   #define   cdp_alloca  __builtin_alloca
-  #define   cdp_free    free
 #endif
 #define     cdp_malloc0(z, ...)       cdp_calloc(1, z __VA_ARGS__)
 
@@ -149,6 +175,82 @@ typedef void (*cdpDel)(void*);
 #define     cdp_is_set(v, f)          (((v) & (f)) != 0)
 
 
+/*
+ * Hashing
+ */
+
+static inline uint64_t cdp_hash_mum(uint64_t a, uint64_t b) {
+    // Folds the 128 bit product of both values.
+  #ifdef __SIZEOF_INT128__
+    __uint128_t r = (__uint128_t)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+  #else
+    uint64_t ha = a >> 32, la = (uint32_t)a, hb = b >> 32, lb = (uint32_t)b;
+    uint64_t hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+    uint64_t t  = ll + (hl << 32);
+    uint64_t lo = t + (lh << 32);
+    uint64_t hi = hh + (hl >> 32) + (lh >> 32) + (t < ll) + (lo < t);
+    return lo ^ hi;
+  #endif
+}
+
+static inline uint64_t cdp_hash_read64(const uint8_t* p)  {uint64_t v;  memcpy(&v, p, sizeof(v));  return v;}
+static inline uint64_t cdp_hash_read32(const uint8_t* p)  {uint32_t v;  memcpy(&v, p, sizeof(v));  return v;}
+
+static inline uint64_t cdp_hash64(const void* key, size_t size, uint64_t seed) {
+    // Fast 64 bit content hash (multiply-fold, wyhash style), reading 48 bytes per round.
+    static const uint64_t S0 = 0xA0761D6478BD642FULL, S1 = 0xE7037ED1A0B428DBULL,
+                          S2 = 0x8EBC6AF09C88C6E3ULL, S3 = 0x589965CC75374CC3ULL;
+    const uint8_t* p = key;
+    uint64_t a, b;
+    seed ^= cdp_hash_mum(seed ^ S0, S1);
+
+    if (size <= 16) {
+        if (size >= 4) {
+            size_t mid = (size >> 3) << 2;
+            a = (cdp_hash_read32(p) << 32) | cdp_hash_read32(p + mid);
+            b = (cdp_hash_read32(p + size - 4) << 32) | cdp_hash_read32(p + size - 4 - mid);
+        } else if (size) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[size >> 1] << 8) | p[size - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t left = size;
+        if (left > 48) {
+            uint64_t seed1 = seed, seed2 = seed;
+            do {
+                seed  = cdp_hash_mum(cdp_hash_read64(p)      ^ S1, cdp_hash_read64(p + 8)  ^ seed);
+                seed1 = cdp_hash_mum(cdp_hash_read64(p + 16) ^ S2, cdp_hash_read64(p + 24) ^ seed1);
+                seed2 = cdp_hash_mum(cdp_hash_read64(p + 32) ^ S3, cdp_hash_read64(p + 40) ^ seed2);
+                p += 48;  left -= 48;
+            } while (left > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (left > 16) {
+            seed = cdp_hash_mum(cdp_hash_read64(p) ^ S1, cdp_hash_read64(p + 8) ^ seed);
+            p += 16;  left -= 16;
+        }
+        a = cdp_hash_read64(p + left - 16);
+        b = cdp_hash_read64(p + left - 8);
+    }
+
+    a ^= S1;
+    b ^= seed;
+  #ifdef __SIZEOF_INT128__
+    __uint128_t r = (__uint128_t)a * b;
+    a = (uint64_t)r;
+    b = (uint64_t)(r >> 64);
+  #else
+    uint64_t m = cdp_hash_mum(a, b);   // (Folded already.)
+    a = m;
+    b = m ^ S3;
+  #endif
+    return cdp_hash_mum(a ^ S0 ^ size, b ^ S1);
+}
+
+
 /*
  * Function Utilities
  */
@@ -244,6 +244,7 @@ static inline cdpData* cdp_data_new_binary_dt(cdpDT* dt) {
     );
 }
 #define cdp_dict_add_binary_dt(record, name, dt)            cdp_record_add_child(record, CDP_TYPE_NORMAL, name, 0, cdp_data_new_binary_dt(dt), NULL)
+#define cdp_dict_add_binary_dt_interned(record, name, dt)   cdp_record_add_new_data(record, name, 0, cdp_data_intern(cdp_data_new_binary_dt(dt)))
 
 
 static inline cdpData* cdp_data_new_binary_agent(cdpAgent value) {
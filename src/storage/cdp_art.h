@@ -0,0 +1,702 @@
+/*
+ *  Copyright (c) 2025 Victor M. Barrientos (https://github.com/FirmwGuy/CacadeDP)
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of
+ *  this software and associated documentation files (the "Software"), to deal in
+ *  the Software without restriction, including without limitation the rights to
+ *  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is furnished to do
+ *  so.
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+
+typedef struct _cdpArtLeaf      cdpArtLeaf;
+
+#define ART_KEY_SIZE    16      // Name bytes: domain then tag, both big endian (so byte order is name order).
+
+enum {
+    ART_NODE4,
+    ART_NODE16,
+    ART_NODE48,
+    ART_NODE256,
+};
+
+struct _cdpArtLeaf {
+    cdpArtLeaf*   next;                 // Next leaf (in name order).
+    cdpArtLeaf*   prev;                 // Previous leaf.
+    uint8_t       key[ART_KEY_SIZE];    // Packed record name.
+    //
+    cdpRecord     record;               // Child record.
+};
+
+typedef struct {
+    uint8_t       type;                 // Node kind (by fan-out).
+    uint8_t       prefixLen;            // Bytes of the compressed path above the branching byte.
+    uint16_t      count;                // Number of children.
+    uint8_t       prefix[ART_KEY_SIZE]; // Compressed path (keys are short, so it's always stored whole).
+} cdpArtNode;
+
+typedef struct {
+    cdpArtNode    node;
+    uint8_t       key[4];               // Sorted branching bytes.
+    void*         child[4];
+} cdpArtNode4;
+
+typedef struct {
+    cdpArtNode    node;
+    uint8_t       key[16];              // Sorted branching bytes.
+    void*         child[16];
+} cdpArtNode16;
+
+typedef struct {
+    cdpArtNode    node;
+    uint8_t       index[256];           // Slot (plus one) of each branching byte, zero if absent.
+    void*         child[48];
+} cdpArtNode48;
+
+typedef struct {
+    cdpArtNode    node;
+    void*         child[256];
+} cdpArtNode256;
+
+typedef struct {
+    cdpStore      store;        // Parent info.
+    //
+    void*         root;         // Root node (a tagged leaf when there is a single child).
+    cdpArtLeaf*   first;        // Head of the ordered leaf list.
+    cdpArtLeaf*   last;         // Tail of the leaf list.
+} cdpArt;
+
+
+#define art_is_leaf(p)          ((uintptr_t)(p) & 1)
+#define art_leaf(p)             ((cdpArtLeaf*)((uintptr_t)(p) & ~(uintptr_t)1))
+#define art_leaf_tag(l)         ((void*)((uintptr_t)(l) | 1))
+
+
+
+
+/*
+    Adaptive radix tree implementation
+*/
+
+static inline cdpArt* art_new(void) {
+    SLAB_TRY_NEW(cdpArt, art);
+    return art;
+}
+
+#define art_del(art)    slab_del_item(cdpArt, art)
+
+
+static inline void art_key_of(const cdpDT* name, uint8_t* key) {
+    uint64_t domain = name->domain, tag = name->tag;
+    for (unsigned n = 0;  n < 8;  n++) {
+        key[n]     = (uint8_t)(domain >> (56 - 8*n));
+        key[8 + n] = (uint8_t)(tag    >> (56 - 8*n));
+    }
+}
+
+
+static inline cdpArtLeaf* art_leaf_new(cdpRecord* record) {
+    SLAB_TRY_NEW(cdpArtLeaf, leaf);
+    if CDP_RARELY(!leaf)
+        return NULL;
+    cdp_record_transfer(record, &leaf->record);
+    art_key_of(cdp_record_get_name(&leaf->record), leaf->key);
+    return leaf;
+}
+
+#define art_leaf_del(leaf)  slab_del_item(cdpArtLeaf, leaf)
+
+
+static inline cdpArtLeaf* art_leaf_from_record(const cdpRecord* record) {
+    return cdp_ptr_dif(record, offsetof(cdpArtLeaf, record));
+}
+
+
+static const size_t ART_NODE_SIZE[] = {sizeof(cdpArtNode4), sizeof(cdpArtNode16), sizeof(cdpArtNode48), sizeof(cdpArtNode256)};
+
+static inline cdpArtNode* art_node_new(unsigned type) {
+    cdpArtNode* node = slab_alloc0(ART_NODE_SIZE[type]);
+    node->type = type;
+    return node;
+}
+
+#define art_node_del(node)  slab_free(node, ART_NODE_SIZE[((cdpArtNode*)(node))->type])
+
+
+static inline void art_node_copy_header(cdpArtNode* dst, const cdpArtNode* src) {
+    dst->count     = src->count;
+    dst->prefixLen = src->prefixLen;
+    memcpy(dst->prefix, src->prefix, src->prefixLen);
+}
+
+
+
+
+static inline void** art_find_child(cdpArtNode* node, uint8_t byte) {
+    switch (node->type) {
+      case ART_NODE4: {
+        cdpArtNode4* n4 = (cdpArtNode4*) node;
+        for (unsigned i = 0;  i < node->count;  i++) {
+            if (n4->key[i] == byte)
+                return &n4->child[i];
+        }
+        return NULL;
+      }
+      case ART_NODE16: {
+        // Compares all bytes at once (the loop vectorizes) and picks the match from the mask.
+        cdpArtNode16* n16 = (cdpArtNode16*) node;
+        unsigned mask = 0;
+        for (unsigned i = 0;  i < 16;  i++)
+            mask |= (unsigned)(n16->key[i] == byte) << i;
+        mask &= (1u << node->count) - 1;
+        return mask?  &n16->child[__builtin_ctz(mask)]:  NULL;
+      }
+      case ART_NODE48: {
+        cdpArtNode48* n48 = (cdpArtNode48*) node;
+        return n48->index[byte]?  &n48->child[n48->index[byte] - 1]:  NULL;
+      }
+      case ART_NODE256: {
+        cdpArtNode256* n256 = (cdpArtNode256*) node;
+        return n256->child[byte]?  &n256->child[byte]:  NULL;
+      }
+    }
+    return NULL;
+}
+
+
+static inline void* art_next_child(cdpArtNode* node, int byte) {
+    // First child whose branching byte is above 'byte' (-1 gets the first one).
+    switch (node->type) {
+      case ART_NODE4:
+      case ART_NODE16: {
+        uint8_t* key   = (node->type == ART_NODE4)?  ((cdpArtNode4*)node)->key:    ((cdpArtNode16*)node)->key;
+        void**   child = (node->type == ART_NODE4)?  ((cdpArtNode4*)node)->child:  ((cdpArtNode16*)node)->child;
+        for (unsigned i = 0;  i < node->count;  i++) {
+            if (key[i] > byte)
+                return child[i];
+        }
+        return NULL;
+      }
+      case ART_NODE48: {
+        cdpArtNode48* n48 = (cdpArtNode48*) node;
+        for (unsigned b = byte + 1;  b < 256;  b++) {
+            if (n48->index[b])
+                return n48->child[n48->index[b] - 1];
+        }
+        return NULL;
+      }
+      case ART_NODE256: {
+        cdpArtNode256* n256 = (cdpArtNode256*) node;
+        for (unsigned b = byte + 1;  b < 256;  b++) {
+            if (n256->child[b])
+                return n256->child[b];
+        }
+        return NULL;
+      }
+    }
+    return NULL;
+}
+
+
+static inline cdpArtLeaf* art_minimum(void* node) {
+    while (!art_is_leaf(node))
+        node = art_next_child(node, -1);
+    return art_leaf(node);
+}
+
+
+
+
+static inline void art_add_child(void** ref, cdpArtNode* node, uint8_t byte, void* child);
+
+static inline void art_add_child_sorted(cdpArtNode* node, uint8_t* key, void** slot, uint8_t byte, void* child) {
+    unsigned i = 0;
+    while (i < node->count  &&  key[i] < byte)
+        i++;
+    unsigned tomove = node->count - i;
+    if (tomove) {
+        memmove(&key[i + 1],  &key[i],  tomove);
+        memmove(&slot[i + 1], &slot[i], tomove * sizeof(void*));
+    }
+    key[i]  = byte;
+    slot[i] = child;
+    node->count++;
+}
+
+
+static inline void art_add_child(void** ref, cdpArtNode* node, uint8_t byte, void* child) {
+    switch (node->type) {
+      case ART_NODE4: {
+        cdpArtNode4* n4 = (cdpArtNode4*) node;
+        if (node->count < 4) {
+            art_add_child_sorted(node, n4->key, n4->child, byte, child);
+            return;
+        }
+        cdpArtNode16* n16 = (cdpArtNode16*) art_node_new(ART_NODE16);
+        art_node_copy_header(&n16->node, node);
+        memcpy(n16->key,   n4->key,   sizeof(n4->key));
+        memcpy(n16->child, n4->child, sizeof(n4->child));
+        *ref = n16;
+        art_node_del(n4);
+        art_add_child_sorted(&n16->node, n16->key, n16->child, byte, child);
+        return;
+      }
+      case ART_NODE16: {
+        cdpArtNode16* n16 = (cdpArtNode16*) node;
+        if (node->count < 16) {
+            art_add_child_sorted(node, n16->key, n16->child, byte, child);
+            return;
+        }
+        cdpArtNode48* n48 = (cdpArtNode48*) art_node_new(ART_NODE48);
+        art_node_copy_header(&n48->node, node);
+        memcpy(n48->child, n16->child, sizeof(n16->child));
+        for (unsigned i = 0;  i < 16;  i++)
+            n48->index[n16->key[i]] = (uint8_t)(i + 1);
+        *ref = n48;
+        art_node_del(n16);
+        art_add_child(ref, &n48->node, byte, child);
+        return;
+      }
+      case ART_NODE48: {
+        cdpArtNode48* n48 = (cdpArtNode48*) node;
+        if (node->count < 48) {
+            unsigned i = 0;
+            while (n48->child[i])   // Removals leave holes.
+                i++;
+            n48->child[i] = child;
+            n48->index[byte] = (uint8_t)(i + 1);
+            node->count++;
+            return;
+        }
+        cdpArtNode256* n256 = (cdpArtNode256*) art_node_new(ART_NODE256);
+        art_node_copy_header(&n256->node, node);
+        for (unsigned b = 0;  b < 256;  b++) {
+            if (n48->index[b])
+                n256->child[b] = n48->child[n48->index[b] - 1];
+        }
+        *ref = n256;
+        art_node_del(n48);
+        art_add_child(ref, &n256->node, byte, child);
+        return;
+      }
+      case ART_NODE256: {
+        cdpArtNode256* n256 = (cdpArtNode256*) node;
+        n256->child[byte] = child;
+        node->count++;
+        return;
+      }
+    }
+}
+
+
+static inline void art_remove_child_sorted(cdpArtNode* node, uint8_t* key, void** slot, void** child) {
+    unsigned i = (unsigned)(child - slot);
+    unsigned tomove = node->count - i - 1;
+    if (tomove) {
+        memmove(&key[i],  &key[i + 1],  tomove);
+        memmove(&slot[i], &slot[i + 1], tomove * sizeof(void*));
+    }
+    node->count--;
+}
+
+
+static inline void art_remove_child(void** ref, cdpArtNode* node, uint8_t byte, void** child) {
+    switch (node->type) {
+      case ART_NODE4: {
+        cdpArtNode4* n4 = (cdpArtNode4*) node;
+        art_remove_child_sorted(node, n4->key, n4->child, child);
+        if (node->count > 1)
+            return;
+
+        // A single child left: merge this node into it (extending its compressed path).
+        void* only = n4->child[0];
+        if (!art_is_leaf(only)) {
+            cdpArtNode* sub = only;
+            unsigned len = node->prefixLen;
+            assert(len + 1 + sub->prefixLen < ART_KEY_SIZE);
+            memmove(&sub->prefix[len + 1], sub->prefix, sub->prefixLen);
+            memcpy(sub->prefix, node->prefix, len);
+            sub->prefix[len] = n4->key[0];
+            sub->prefixLen += len + 1;
+        }
+        *ref = only;
+        art_node_del(n4);
+        return;
+      }
+      case ART_NODE16: {
+        cdpArtNode16* n16 = (cdpArtNode16*) node;
+        art_remove_child_sorted(node, n16->key, n16->child, child);
+        if (node->count > 3)
+            return;
+        cdpArtNode4* n4 = (cdpArtNode4*) art_node_new(ART_NODE4);
+        art_node_copy_header(&n4->node, node);
+        memcpy(n4->key,   n16->key,   node->count);
+        memcpy(n4->child, n16->child, node->count * sizeof(void*));
+        *ref = n4;
+        art_node_del(n16);
+        return;
+      }
+      case ART_NODE48: {
+        cdpArtNode48* n48 = (cdpArtNode48*) node;
+        *child = NULL;
+        n48->index[byte] = 0;
+        node->count--;
+        if (node->count > 12)
+            return;
+        cdpArtNode16* n16 = (cdpArtNode16*) art_node_new(ART_NODE16);
+        art_node_copy_header(&n16->node, node);
+        unsigned i = 0;
+        for (unsigned b = 0;  b < 256;  b++) {
+            if (n48->index[b]) {
+                n16->key[i]   = (uint8_t)b;
+                n16->child[i] = n48->child[n48->index[b] - 1];
+                i++;
+            }
+        }
+        *ref = n16;
+        art_node_del(n48);
+        return;
+      }
+      case ART_NODE256: {
+        cdpArtNode256* n256 = (cdpArtNode256*) node;
+        *child = NULL;
+        node->count--;
+        if (node->count > 37)
+            return;
+        cdpArtNode48* n48 = (cdpArtNode48*) art_node_new(ART_NODE48);
+        art_node_copy_header(&n48->node, node);
+        unsigned i = 0;
+        for (unsigned b = 0;  b < 256;  b++) {
+            if (n256->child[b]) {
+                n48->child[i] = n256->child[b];
+                n48->index[b] = (uint8_t)(++i);
+            }
+        }
+        *ref = n48;
+        art_node_del(n256);
+        return;
+      }
+    }
+}
+
+
+
+
+static inline cdpArtLeaf* art_search(cdpArt* art, const uint8_t* key) {
+    // Compressed paths are skipped without looking (the whole key is checked once, at the leaf).
+    void* node = art->root;
+    unsigned depth = 0;
+    while (node  &&  !art_is_leaf(node)) {
+        cdpArtNode* inner = node;
+        depth += inner->prefixLen;
+        void** child = art_find_child(inner, key[depth]);
+        if (!child)
+            return NULL;
+        node = *child;
+        depth++;
+    }
+    if (!node)
+        return NULL;
+    cdpArtLeaf* leaf = art_leaf(node);
+    return memcmp(leaf->key, key, ART_KEY_SIZE)?  NULL:  leaf;
+}
+
+
+static inline cdpArtLeaf* art_lower_bound(void* node, const uint8_t* key, unsigned depth) {
+    // First leaf whose key is not below 'key'.
+    if (!node)
+        return NULL;
+    if (art_is_leaf(node)) {
+        cdpArtLeaf* leaf = art_leaf(node);
+        return (0 <= memcmp(leaf->key, key, ART_KEY_SIZE))?  leaf:  NULL;
+    }
+
+    cdpArtNode* inner = node;
+    for (unsigned i = 0;  i < inner->prefixLen;  i++) {
+        if (inner->prefix[i] != key[depth + i])
+            return (inner->prefix[i] > key[depth + i])?  art_minimum(inner):  NULL;
+    }
+    depth += inner->prefixLen;
+
+    void** child = art_find_child(inner, key[depth]);
+    if (child) {
+        cdpArtLeaf* leaf = art_lower_bound(*child, key, depth + 1);
+        if (leaf)
+            return leaf;
+    }
+    void* next = art_next_child(inner, key[depth]);
+    return next?  art_minimum(next):  NULL;
+}
+
+
+
+
+static inline void art_insert_leaf(void** ref, cdpArtLeaf* leaf, unsigned depth) {
+    for (;;) {
+        void* node = *ref;
+        if (!node) {
+            *ref = art_leaf_tag(leaf);
+            return;
+        }
+
+        if (art_is_leaf(node)) {
+            // Two leaves: branch where their keys first differ.
+            cdpArtLeaf* other = art_leaf(node);
+            unsigned d = depth;
+            while (other->key[d] == leaf->key[d]) {
+                d++;
+                assert(d < ART_KEY_SIZE);       // Duplicates are not allowed.
+            }
+            cdpArtNode* inner = art_node_new(ART_NODE4);
+            inner->prefixLen = (uint8_t)(d - depth);
+            memcpy(inner->prefix, &leaf->key[depth], inner->prefixLen);
+            art_add_child(ref, inner, other->key[d], node);
+            art_add_child(ref, inner, leaf->key[d], art_leaf_tag(leaf));
+            *ref = inner;
+            return;
+        }
+
+        cdpArtNode* inner = node;
+        unsigned p = 0;
+        while (p < inner->prefixLen  &&  inner->prefix[p] == leaf->key[depth + p])
+            p++;
+        if (p < inner->prefixLen) {
+            // Split the compressed path where it stops matching.
+            cdpArtNode* split = art_node_new(ART_NODE4);
+            split->prefixLen = (uint8_t)p;
+            memcpy(split->prefix, inner->prefix, p);
+            art_add_child(ref, split, inner->prefix[p], inner);
+            art_add_child(ref, split, leaf->key[depth + p], art_leaf_tag(leaf));
+            inner->prefixLen -= p + 1;
+            memmove(inner->prefix, &inner->prefix[p + 1], inner->prefixLen);
+            *ref = split;
+            return;
+        }
+        depth += inner->prefixLen;
+
+        void** child = art_find_child(inner, leaf->key[depth]);
+        if (!child) {
+            art_add_child(ref, inner, leaf->key[depth], art_leaf_tag(leaf));
+            return;
+        }
+        ref = child;
+        depth++;
+    }
+}
+
+
+static inline cdpRecord* art_named_insert(cdpArt* art, cdpRecord* record) {
+    cdpArtLeaf* leaf = art_leaf_new(record);
+    if CDP_RARELY(!leaf)
+        return NULL;
+    cdpArtLeaf* next = art_lower_bound(art->root, leaf->key, 0);
+    assert(!next  ||  memcmp(next->key, leaf->key, ART_KEY_SIZE));     // Duplicates are not allowed.
+
+    art_insert_leaf(&art->root, leaf, 0);
+
+    // Link it before its successor.
+    leaf->next = next;
+    leaf->prev = next?  next->prev:  art->last;
+    if (leaf->prev)
+        leaf->prev->next = leaf;
+    else
+        art->first = leaf;
+    if (next)
+        next->prev = leaf;
+    else
+        art->last = leaf;
+
+    return &leaf->record;
+}
+
+
+
+
+static inline cdpRecord* art_first(cdpArt* art) {
+    return &art->first->record;
+}
+
+
+static inline cdpRecord* art_last(cdpArt* art) {
+    return &art->last->record;
+}
+
+
+static inline cdpRecord* art_find_by_name(cdpArt* art, const cdpDT* name) {
+    uint8_t key[ART_KEY_SIZE];
+    art_key_of(name, key);
+    cdpArtLeaf* leaf = art_search(art, key);
+    return leaf? &leaf->record: NULL;
+}
+
+
+static inline cdpRecord* art_find_by_key(cdpArt* art, cdpRecord* key, cdpCompare compare, void* context) {
+    // Only names are indexed.
+    for (cdpArtLeaf* leaf = art->first;  leaf;  leaf = leaf->next) {
+        if (0 == compare(key, &leaf->record, context))
+            return &leaf->record;
+    }
+    return NULL;
+}
+
+
+static inline cdpRecord* art_find_by_position(cdpArt* art, size_t position) {
+    size_t n = 0;
+    for (cdpArtLeaf* leaf = art->first;  leaf;  leaf = leaf->next, n++) {
+        if (n == position)
+            return &leaf->record;
+    }
+    return NULL;
+}
+
+
+static inline cdpRecord* art_first_in_domain(cdpArt* art, cdpID domain) {
+    cdpDT name = {.domain = domain};
+    uint8_t key[ART_KEY_SIZE];
+    art_key_of(&name, key);
+    cdpArtLeaf* leaf = art_lower_bound(art->root, key, 0);
+    return (leaf  &&  !memcmp(leaf->key, key, ART_KEY_SIZE / 2))?  &leaf->record:  NULL;
+}
+
+
+static inline cdpRecord* art_prev(const cdpRecord* record) {
+    cdpArtLeaf* leaf = art_leaf_from_record(record);
+    return leaf->prev? &leaf->prev->record: NULL;
+}
+
+
+static inline cdpRecord* art_next(const cdpRecord* record) {
+    cdpArtLeaf* leaf = art_leaf_from_record(record);
+    return leaf->next? &leaf->next->record: NULL;
+}
+
+
+static inline bool art_traverse(cdpArt* art, cdpTraverse func, void* context, cdpEntry* entry) {
+    entry->parent = art->store.owner;
+    entry->depth  = 0;
+    cdpArtLeaf* leaf = art->first, *next;
+    do {
+        next = leaf->next;
+        entry->record = &leaf->record;
+        entry->next = next? &next->record: NULL;
+        if (!func(entry, context))
+            return false;
+        entry->position++;
+        entry->prev = entry->record;
+        leaf = next;
+    } while (leaf);
+    return true;
+}
+
+
+
+
+static inline void art_remove_leaf(cdpArt* art, cdpArtLeaf* leaf) {
+    if (art_is_leaf(art->root)) {
+        assert(art_leaf(art->root) == leaf);
+        art->root = NULL;
+    } else {
+        void** ref = &art->root;
+        unsigned depth = 0;
+        for (;;) {
+            cdpArtNode* inner = *ref;
+            depth += inner->prefixLen;
+            void** child = art_find_child(inner, leaf->key[depth]);
+            assert(child);
+            if (art_is_leaf(*child)) {
+                assert(art_leaf(*child) == leaf);
+                art_remove_child(ref, inner, leaf->key[depth], child);
+                break;
+            }
+            ref = child;
+            depth++;
+        }
+    }
+
+    if (leaf->next) leaf->next->prev = leaf->prev;
+    else            art->last = leaf->prev;
+    if (leaf->prev) leaf->prev->next = leaf->next;
+    else            art->first = leaf->next;
+
+    art_leaf_del(leaf);
+}
+
+
+static inline void art_take(cdpArt* art, cdpRecord* target) {
+    assert(art && art->last);
+    cdpArtLeaf* leaf = art->last;
+    cdp_record_transfer(&leaf->record, target);
+    art_remove_leaf(art, leaf);
+}
+
+
+static inline void art_pop(cdpArt* art, cdpRecord* target) {
+    assert(art && art->first);
+    cdpArtLeaf* leaf = art->first;
+    cdp_record_transfer(&leaf->record, target);
+    art_remove_leaf(art, leaf);
+}
+
+
+static inline void art_remove_record(cdpArt* art, cdpRecord* record) {
+    assert(art && art->first);
+    art_remove_leaf(art, art_leaf_from_record(record));
+}
+
+
+static inline void art_node_del_all(void* node) {
+    if (!node  ||  art_is_leaf(node))
+        return;     // Leaves are released from the list.
+
+    cdpArtNode* inner = node;
+    switch (inner->type) {
+      case ART_NODE4: {
+        for (unsigned i = 0;  i < inner->count;  i++)
+            art_node_del_all(((cdpArtNode4*)inner)->child[i]);
+        break;
+      }
+      case ART_NODE16: {
+        for (unsigned i = 0;  i < inner->count;  i++)
+            art_node_del_all(((cdpArtNode16*)inner)->child[i]);
+        break;
+      }
+      case ART_NODE48: {
+        for (unsigned i = 0;  i < 48;  i++)
+            art_node_del_all(((cdpArtNode48*)inner)->child[i]);
+        break;
+      }
+      case ART_NODE256: {
+        for (unsigned i = 0;  i < 256;  i++)
+            art_node_del_all(((cdpArtNode256*)inner)->child[i]);
+        break;
+      }
+    }
+    art_node_del(inner);
+}
+
+
+static inline void art_del_all_children(cdpArt* art) {
+    art_node_del_all(art->root);
+    cdpArtLeaf* leaf = art->first, *toDel;
+    while (leaf) {
+        cdp_record_finalize(&leaf->record);
+        toDel = leaf;
+        leaf = leaf->next;
+        art_leaf_del(toDel);
+    }
+    art->root  = NULL;
+    art->first = art->last = NULL;
+}
@@ -0,0 +1,689 @@
+/*
+ *  Copyright (c) 2025 Victor M. Barrientos (https://github.com/FirmwGuy/CacadeDP)
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of
+ *  this software and associated documentation files (the "Software"), to deal in
+ *  the Software without restriction, including without limitation the rights to
+ *  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is furnished to do
+ *  so.
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+
+typedef struct _cdpBTreeInner   cdpBTreeInner;
+typedef struct _cdpBTreeLeaf    cdpBTreeLeaf;
+
+#define BTREE_LEAF_SIZE     4096    // Leaf size in bytes (leaves are also aligned to this size).
+#define BTREE_LEAF_WIDTH    72      // Records per leaf.
+#define BTREE_INNER_WIDTH   64      // Children per inner node.
+
+struct _cdpBTreeLeaf {
+    cdpBTreeLeaf*   next;                       // Next leaf (for sequential scans).
+    cdpBTreeLeaf*   prev;                       // Previous leaf.
+    cdpBTreeInner*  parent;                     // Parent inner node (NULL if the leaf is root).
+    unsigned        count;                      // Number of records in this leaf.
+    //
+    cdpDT           key[BTREE_LEAF_WIDTH];      // Packed record names (for name indexing).
+    cdpRecord       record[BTREE_LEAF_WIDTH];   // Child records.
+};
+
+struct _cdpBTreeInner {
+    cdpBTreeInner*  parent;                     // Parent inner node (NULL if root).
+    unsigned        count;                      // Number of children.
+    bool            leaves;                     // True if children are leaves.
+    //
+    cdpDT           key[BTREE_INNER_WIDTH];     // Packed name lower bound of each child (key[0] is unused).
+    cdpBTreeLeaf*   least[BTREE_INNER_WIDTH];   // Leftmost leaf of each child (its first record is the live lower bound).
+    void*           child[BTREE_INNER_WIDTH];   // Children nodes.
+};
+
+typedef struct {
+    cdpStore        store;      // Parent info.
+    //
+    void*           root;       // Root node (a leaf if height is zero).
+    unsigned        height;     // Number of inner levels.
+    cdpBTreeLeaf*   first;      // Head of the leaf list.
+    cdpBTreeLeaf*   last;       // Tail of the leaf list.
+} cdpBTree;
+
+static_assert(sizeof(cdpBTreeLeaf) <= BTREE_LEAF_SIZE, "B+tree leaf doesn't fit in its block!");
+
+
+#define btree_leaf_from_record(r)   ((cdpBTreeLeaf*)((uintptr_t)(r) & ~(uintptr_t)(BTREE_LEAF_SIZE - 1)))
+
+
+
+
+/*
+    B+tree implementation
+*/
+
+static inline cdpBTree* btree_new(void) {
+    SLAB_TRY_NEW(cdpBTree, btree);
+    return btree;
+}
+
+#define btree_del(btree)    slab_del_item(cdpBTree, btree)
+
+
+static inline cdpBTreeLeaf* btree_leaf_new(void) {
+    cdpBTreeLeaf* leaf = cdp_try_aligned_alloc(BTREE_LEAF_SIZE, BTREE_LEAF_SIZE);
+    if CDP_EXPECT_PTR(leaf)
+        memset(leaf, 0, offsetof(cdpBTreeLeaf, key));
+    return leaf;
+}
+
+#define btree_leaf_del    cdp_free
+
+
+static inline cdpBTreeInner* btree_inner_new(bool leaves) {
+    SLAB_NEW(cdpBTreeInner, inner);
+    inner->leaves = leaves;
+    return inner;
+}
+
+#define btree_inner_del(inner)  slab_del_item(cdpBTreeInner, inner)
+
+
+static inline void btree_relink_records(cdpRecord* record, unsigned count) {
+    for (;  count;  count--, record++) {
+        if (!cdp_record_is_link(record) && record->store)
+            cdp_record_relink_storage(record);
+    }
+}
+
+
+static inline void btree_leaf_move(cdpBTreeLeaf* dst, unsigned dpos, cdpBTreeLeaf* src, unsigned spos, unsigned count) {
+    // Moves records between leaves (or within one, if dst is src).
+    memmove(&dst->key[dpos],    &src->key[spos],    count * sizeof(cdpDT));
+    memmove(&dst->record[dpos], &src->record[spos], count * sizeof(cdpRecord));
+    cdp_record_moved(&dst->record[dpos], &src->record[spos], count);
+    btree_relink_records(&dst->record[dpos], count);
+}
+
+
+static inline void btree_set_parent(cdpBTreeInner* inner, void* child) {
+    if (inner->leaves)
+        ((cdpBTreeLeaf*)child)->parent = inner;
+    else
+        ((cdpBTreeInner*)child)->parent = inner;
+}
+
+
+static inline unsigned btree_inner_index_of(cdpBTreeInner* inner, void* child) {
+    unsigned i = 0;
+    while (inner->child[i] != child) {
+        i++;
+        assert(i < inner->count);
+    }
+    return i;
+}
+
+
+
+
+static inline unsigned btree_inner_search_by_name(cdpBTreeInner* inner, const cdpDT* name) {
+    // Last child whose lower bound is not above name.
+    unsigned imin = 1, imax = inner->count;
+    while (imin < imax) {
+        unsigned i = (imin + imax) >> 1;
+        if (0 > cdp_dt_compare(name, &inner->key[i]))
+            imax = i;
+        else
+            imin = i + 1;
+    }
+    return imin - 1;
+}
+
+
+static inline unsigned btree_inner_search(cdpBTreeInner* inner, const cdpRecord* key, cdpCompare compare, void* context) {
+    unsigned imin = 1, imax = inner->count;
+    while (imin < imax) {
+        unsigned i = (imin + imax) >> 1;
+        if (0 > compare(key, inner->least[i]->record, context))
+            imax = i;
+        else
+            imin = i + 1;
+    }
+    return imin - 1;
+}
+
+
+static inline unsigned btree_leaf_search_by_name(cdpBTreeLeaf* leaf, const cdpDT* name) {
+    // First record not below name.
+    unsigned imin = 0, imax = leaf->count;
+    while (imin < imax) {
+        unsigned i = (imin + imax) >> 1;
+        if (0 < cdp_dt_compare(name, &leaf->key[i]))
+            imin = i + 1;
+        else
+            imax = i;
+    }
+    return imin;
+}
+
+
+static inline unsigned btree_leaf_search(cdpBTreeLeaf* leaf, const cdpRecord* key, cdpCompare compare, void* context) {
+    unsigned imin = 0, imax = leaf->count;
+    while (imin < imax) {
+        unsigned i = (imin + imax) >> 1;
+        if (0 < compare(key, &leaf->record[i], context))
+            imin = i + 1;
+        else
+            imax = i;
+    }
+    return imin;
+}
+
+
+static inline cdpBTreeLeaf* btree_find_leaf_by_name(cdpBTree* btree, const cdpDT* name) {
+    void* node = btree->root;
+    for (unsigned h = btree->height;  h;  h--) {
+        cdpBTreeInner* inner = node;
+        node = inner->child[btree_inner_search_by_name(inner, name)];
+    }
+    return node;
+}
+
+
+static inline cdpBTreeLeaf* btree_find_leaf(cdpBTree* btree, const cdpRecord* key, cdpCompare compare, void* context) {
+    void* node = btree->root;
+    for (unsigned h = btree->height;  h;  h--) {
+        cdpBTreeInner* inner = node;
+        node = inner->child[btree_inner_search(inner, key, compare, context)];
+    }
+    return node;
+}
+
+
+
+
+static inline cdpRecord* btree_leaf_insert_at(cdpBTreeLeaf* leaf, unsigned pos, cdpRecord* record) {
+    assert(leaf->count < BTREE_LEAF_WIDTH);
+    unsigned tomove = leaf->count - pos;
+    if (tomove) {
+        memmove(&leaf->key[pos + 1], &leaf->key[pos], tomove * sizeof(cdpDT));
+        memmove(&leaf->record[pos + 1], &leaf->record[pos], tomove * sizeof(cdpRecord));
+        cdp_record_moved(&leaf->record[pos + 1], &leaf->record[pos], tomove);
+        btree_relink_records(&leaf->record[pos + 1], tomove);
+    }
+    leaf->count++;
+
+    cdpRecord* child = &leaf->record[pos];
+    cdp_record_transfer(record, child);
+    leaf->key[pos] = *cdp_record_get_name(child);
+    return child;
+}
+
+
+static inline void btree_inner_insert_at(cdpBTreeInner* inner, unsigned pos, const cdpDT* key, cdpBTreeLeaf* least, void* child) {
+    assert(inner->count < BTREE_INNER_WIDTH);
+    unsigned tomove = inner->count - pos;
+    if (tomove) {
+        memmove(&inner->key[pos + 1],   &inner->key[pos],   tomove * sizeof(cdpDT));
+        memmove(&inner->least[pos + 1], &inner->least[pos], tomove * sizeof(cdpBTreeLeaf*));
+        memmove(&inner->child[pos + 1], &inner->child[pos], tomove * sizeof(void*));
+    }
+    inner->count++;
+
+    inner->key[pos]   = *key;
+    inner->least[pos] = least;
+    inner->child[pos] = child;
+    btree_set_parent(inner, child);
+}
+
+
+static inline void btree_insert_child(cdpBTree* btree, cdpBTreeInner* parent, void* left, const cdpDT* key, cdpBTreeLeaf* least, void* right, bool leaves) {
+    if (!parent) {
+        // Grow a new root.
+        cdpBTreeInner* root = btree_inner_new(leaves);
+        root->count    = 1;
+        root->least[0] = leaves? left: ((cdpBTreeInner*)left)->least[0];
+        root->child[0] = left;
+        btree_set_parent(root, left);
+        btree_inner_insert_at(root, 1, key, least, right);
+
+        btree->root = root;
+        btree->height++;
+        return;
+    }
+
+    unsigned pos = btree_inner_index_of(parent, left) + 1;
+    if (parent->count < BTREE_INNER_WIDTH) {
+        btree_inner_insert_at(parent, pos, key, least, right);
+        return;
+    }
+
+    // Split the (full) inner node in halves.
+    unsigned mid = BTREE_INNER_WIDTH / 2;
+    cdpBTreeInner* sibling = btree_inner_new(parent->leaves);
+    sibling->count = BTREE_INNER_WIDTH - mid;
+    memcpy(sibling->key,   &parent->key[mid],   sibling->count * sizeof(cdpDT));
+    memcpy(sibling->least, &parent->least[mid], sibling->count * sizeof(cdpBTreeLeaf*));
+    memcpy(sibling->child, &parent->child[mid], sibling->count * sizeof(void*));
+    for (unsigned i = 0;  i < sibling->count;  i++)
+        btree_set_parent(sibling, sibling->child[i]);
+    parent->count = mid;
+
+    if (pos <= mid)
+        btree_inner_insert_at(parent, pos, key, least, right);
+    else
+        btree_inner_insert_at(sibling, pos - mid, key, least, right);
+
+    btree_insert_child(btree, parent->parent, parent, &sibling->key[0], sibling->least[0], sibling, false);
+}
+
+
+static inline cdpRecord* btree_leaf_insert(cdpBTree* btree, cdpBTreeLeaf* leaf, unsigned pos, cdpRecord* record) {
+    if (!leaf) {
+        // First record.
+        leaf = btree_leaf_new();
+        if CDP_RARELY(!leaf)
+            return NULL;
+        btree->root  = leaf;
+        btree->first = btree->last = leaf;
+        return btree_leaf_insert_at(leaf, 0, record);
+    }
+    if (leaf->count < BTREE_LEAF_WIDTH)
+        return btree_leaf_insert_at(leaf, pos, record);
+
+    // Split the (full) leaf. Appending at the end of the tree leaves the
+    // old leaf full (so sequential loads don't waste half of every leaf).
+    unsigned mid = (pos == BTREE_LEAF_WIDTH && !leaf->next)?  BTREE_LEAF_WIDTH:  BTREE_LEAF_WIDTH / 2;
+    unsigned tomove = BTREE_LEAF_WIDTH - mid;
+    cdpBTreeLeaf* right = btree_leaf_new();
+    if CDP_RARELY(!right)
+        return NULL;        // Out of memory (inner nodes still can't fail).
+    if (tomove) {
+        memcpy(right->key,    &leaf->key[mid],    tomove * sizeof(cdpDT));
+        memcpy(right->record, &leaf->record[mid], tomove * sizeof(cdpRecord));
+        cdp_record_moved(right->record, &leaf->record[mid], tomove);
+        btree_relink_records(right->record, tomove);
+        right->count = tomove;
+        leaf->count  = mid;
+    }
+
+    right->prev = leaf;
+    right->next = leaf->next;
+    if (leaf->next)
+        leaf->next->prev = right;
+    else
+        btree->last = right;
+    leaf->next = right;
+
+    cdpRecord* child;
+    if (pos < mid  ||  (pos == mid  &&  mid < BTREE_LEAF_WIDTH))
+        child = btree_leaf_insert_at(leaf, pos, record);
+    else
+        child = btree_leaf_insert_at(right, pos - mid, record);
+
+    btree_insert_child(btree, leaf->parent, leaf, &right->key[0], right, right, true);
+
+    return child;
+}
+
+
+static inline cdpRecord* btree_named_insert(cdpBTree* btree, cdpRecord* record) {
+    const cdpDT* name = cdp_record_get_name(record);
+    cdpBTreeLeaf* leaf = NULL;
+    unsigned pos = 0;
+    if (btree->root) {
+        leaf = btree_find_leaf_by_name(btree, name);
+        pos  = btree_leaf_search_by_name(leaf, name);
+        assert(pos == leaf->count  ||  0 != cdp_dt_compare(name, &leaf->key[pos]));   // Duplicates are not allowed.
+    }
+    return btree_leaf_insert(btree, leaf, pos, record);
+}
+
+
+static inline cdpRecord* btree_sorted_insert(cdpBTree* btree, cdpRecord* record, cdpCompare compare, void* context) {
+    cdpBTreeLeaf* leaf = NULL;
+    unsigned pos = 0;
+    if (btree->root) {
+        leaf = btree_find_leaf(btree, record, compare, context);
+        pos  = btree_leaf_search(leaf, record, compare, context);
+        assert(pos == leaf->count  ||  0 != compare(record, &leaf->record[pos], context));   // Duplicates are not allowed.
+    }
+    return btree_leaf_insert(btree, leaf, pos, record);
+}
+
+
+
+
+static inline cdpRecord* btree_first(cdpBTree* btree) {
+    return btree->first->record;
+}
+
+
+static inline cdpRecord* btree_last(cdpBTree* btree) {
+    return &btree->last->record[btree->last->count - 1];
+}
+
+
+static inline cdpRecord* btree_find_by_name(cdpBTree* btree, const cdpDT* name) {
+    if (cdp_store_is_dictionary(&btree->store)) {
+        cdpBTreeLeaf* leaf = btree_find_leaf_by_name(btree, name);
+        unsigned pos = btree_leaf_search_by_name(leaf, name);
+        if (pos < leaf->count  &&  0 == cdp_dt_compare(name, &leaf->key[pos]))
+            return &leaf->record[pos];
+    } else {
+        for (cdpBTreeLeaf* leaf = btree->first;  leaf;  leaf = leaf->next) {
+            for (unsigned i = 0;  i < leaf->count;  i++) {
+                if (cdp_record_name_is(&leaf->record[i], name))
+                    return &leaf->record[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+
+static inline cdpRecord* btree_find_by_key(cdpBTree* btree, cdpRecord* key, cdpCompare compare, void* context) {
+    cdpBTreeLeaf* leaf = btree_find_leaf(btree, key, compare, context);
+    unsigned pos = btree_leaf_search(leaf, key, compare, context);
+    if (pos < leaf->count  &&  0 == compare(key, &leaf->record[pos], context))
+        return &leaf->record[pos];
+    return NULL;
+}
+
+
+static inline cdpRecord* btree_find_by_position(cdpBTree* btree, size_t position) {
+    for (cdpBTreeLeaf* leaf = btree->first;  leaf;  leaf = leaf->next) {
+        if (position < leaf->count)
+            return &leaf->record[position];
+        position -= leaf->count;
+    }
+    return NULL;
+}
+
+
+static inline cdpRecord* btree_prev(const cdpRecord* record) {
+    cdpBTreeLeaf* leaf = btree_leaf_from_record(record);
+    if (record > leaf->record)
+        return (cdpRecord*)record - 1;
+    leaf = leaf->prev;
+    return leaf? &leaf->record[leaf->count - 1]: NULL;
+}
+
+
+static inline cdpRecord* btree_next(const cdpRecord* record) {
+    cdpBTreeLeaf* leaf = btree_leaf_from_record(record);
+    if (record < &leaf->record[leaf->count - 1])
+        return (cdpRecord*)record + 1;
+    leaf = leaf->next;
+    return leaf? leaf->record: NULL;
+}
+
+
+static inline size_t btree_index_of(const cdpRecord* record) {
+    cdpBTreeLeaf* leaf = btree_leaf_from_record(record);
+    size_t index = (size_t)(record - leaf->record);
+    for (leaf = leaf->prev;  leaf;  leaf = leaf->prev)
+        index += leaf->count;
+    return index;
+}
+
+
+static inline cdpRecord* btree_next_by_name(cdpBTree* btree, cdpDT* name, uintptr_t* prev) {
+    cdpRecord* record = *prev?  btree_next((cdpRecord*)*prev):  btree_first(btree);
+    while (record) {
+        if (cdp_record_name_is(record, name)) {
+            *prev = (uintptr_t)record;
+            return record;
+        }
+        record = btree_next(record);
+    }
+    *prev = 0;
+    return NULL;
+}
+
+
+static inline bool btree_traverse(cdpBTree* btree, cdpTraverse func, void* context, cdpEntry* entry) {
+    entry->parent = btree->store.owner;
+    entry->depth  = 0;
+    for (cdpBTreeLeaf* leaf = btree->first;  leaf;  leaf = leaf->next) {
+        for (unsigned i = 0;  i < leaf->count;  i++) {
+            entry->record = &leaf->record[i];
+            entry->next = (i + 1 < leaf->count)?  &leaf->record[i + 1]:  (leaf->next? leaf->next->record: NULL);
+            if (!func(entry, context))
+                return false;
+            entry->position++;
+            entry->prev = entry->record;
+        }
+    }
+    return true;
+}
+
+
+
+
+static inline void btree_detach(cdpBTree* btree, cdpBTreeInner* parent, void* child) {
+    if (!parent) {
+        btree->root   = NULL;
+        btree->height = 0;
+        return;
+    }
+
+    unsigned i = btree_inner_index_of(parent, child);
+    if (parent->count == 1) {
+        btree_detach(btree, parent->parent, parent);
+        btree_inner_del(parent);
+        return;
+    }
+
+    parent->count--;
+    unsigned tomove = parent->count - i;
+    if (tomove) {
+        memmove(&parent->key[i],   &parent->key[i + 1],   tomove * sizeof(cdpDT));
+        memmove(&parent->least[i], &parent->least[i + 1], tomove * sizeof(cdpBTreeLeaf*));
+        memmove(&parent->child[i], &parent->child[i + 1], tomove * sizeof(void*));
+    }
+
+    if (!i) {
+        // The leftmost leaf changed: update references above.
+        cdpBTreeLeaf* least = parent->least[0];
+        for (cdpBTreeInner* inner = parent;  inner->parent;  inner = inner->parent) {
+            unsigned j = btree_inner_index_of(inner->parent, inner);
+            inner->parent->least[j] = least;
+            if (j)
+                break;
+        }
+    }
+}
+
+
+static inline void btree_shrink_root(cdpBTree* btree) {
+    while (btree->height) {
+        cdpBTreeInner* root = btree->root;
+        if (root->count > 1)
+            break;
+        btree->root = root->child[0];
+        btree->height--;
+        if (btree->height)
+            ((cdpBTreeInner*)btree->root)->parent = NULL;
+        else
+            ((cdpBTreeLeaf*)btree->root)->parent = NULL;
+        btree_inner_del(root);
+    }
+}
+
+
+static inline void btree_leaf_release(cdpBTree* btree, cdpBTreeLeaf* leaf) {
+    if (leaf->next) leaf->next->prev = leaf->prev;
+    else            btree->last = leaf->prev;
+    if (leaf->prev) leaf->prev->next = leaf->next;
+    else            btree->first = leaf->next;
+
+    btree_detach(btree, leaf->parent, leaf);
+    btree_leaf_del(leaf);
+    btree_shrink_root(btree);
+}
+
+
+static inline void btree_leaf_rebalance(cdpBTree* btree, cdpBTreeLeaf* leaf) {
+    // An underfull leaf is merged with a sibling (of the same parent, so
+    // inner keys stay valid) if both fit in one leaf, otherwise records are
+    // shared evenly between both.
+    cdpBTreeInner* parent = leaf->parent;
+    if (!parent  ||  parent->count < 2) {
+        if (!leaf->count)
+            btree_leaf_release(btree, leaf);
+        return;
+    }
+    unsigned i = btree_inner_index_of(parent, leaf);
+    if (i + 1 == parent->count)
+        i--;
+    cdpBTreeLeaf* left  = parent->child[i];
+    cdpBTreeLeaf* right = parent->child[i + 1];
+    unsigned total = left->count + right->count;
+
+    if (total <= BTREE_LEAF_WIDTH) {
+        btree_leaf_move(left, left->count, right, 0, right->count);
+        left->count  = total;
+        right->count = 0;
+        btree_leaf_release(btree, right);
+        return;
+    }
+
+    unsigned half = total / 2;
+    if (left->count < half) {
+        unsigned tomove = half - left->count;
+        btree_leaf_move(left, left->count, right, 0, tomove);
+        btree_leaf_move(right, 0, right, tomove, right->count - tomove);
+        right->count -= tomove;
+    } else {
+        unsigned tomove = left->count - half;
+        btree_leaf_move(right, tomove, right, 0, right->count);
+        btree_leaf_move(right, 0, left, half, tomove);
+        right->count += tomove;
+    }
+    left->count = half;
+    parent->key[i + 1] = right->key[0];     // (Its least leaf is still the same.)
+}
+
+
+static inline void btree_remove_at(cdpBTree* btree, cdpBTreeLeaf* leaf, unsigned pos) {
+    leaf->count--;
+    unsigned tomove = leaf->count - pos;
+    if (tomove) {
+        memmove(&leaf->key[pos],    &leaf->key[pos + 1],    tomove * sizeof(cdpDT));
+        memmove(&leaf->record[pos], &leaf->record[pos + 1], tomove * sizeof(cdpRecord));
+        cdp_record_moved(&leaf->record[pos], &leaf->record[pos + 1], tomove);
+        btree_relink_records(&leaf->record[pos], tomove);
+    }
+    if (leaf->count < BTREE_LEAF_WIDTH / 2)
+        btree_leaf_rebalance(btree, leaf);
+}
+
+
+static inline void btree_take(cdpBTree* btree, cdpRecord* target) {
+    assert(btree && btree->last);
+    cdpBTreeLeaf* leaf = btree->last;
+    cdp_record_transfer(&leaf->record[leaf->count - 1], target);
+    btree_remove_at(btree, leaf, leaf->count - 1);
+}
+
+
+static inline void btree_pop(cdpBTree* btree, cdpRecord* target) {
+    assert(btree && btree->first);
+    cdpBTreeLeaf* leaf = btree->first;
+    cdp_record_transfer(leaf->record, target);
+    btree_remove_at(btree, leaf, 0);
+}
+
+
+static inline void btree_remove_record(cdpBTree* btree, cdpRecord* record) {
+    assert(btree && btree->first);
+    cdpBTreeLeaf* leaf = btree_leaf_from_record(record);
+    btree_remove_at(btree, leaf, (unsigned)(record - leaf->record));
+}
+
+
+static inline void btree_inner_del_all(cdpBTreeInner* inner) {
+    if (!inner->leaves) {
+        for (unsigned i = 0;  i < inner->count;  i++)
+            btree_inner_del_all(inner->child[i]);
+    }
+    btree_inner_del(inner);
+}
+
+
+static inline bool btree_sort(cdpBTree* btree, cdpCompare compare, void* context) {
+    // Records are gathered in a temporary block, sorted there and packed
+    // back into the (now full) leaves. Then inner levels are rebuilt by
+    // appending each leaf after the previous one.
+    size_t count = btree->store.chdCount;
+    cdpRecord* record = cdp_try_malloc(count * sizeof(cdpRecord));
+    if CDP_RARELY(!record)
+        return false;
+    size_t n = 0;
+    for (cdpBTreeLeaf* leaf = btree->first;  leaf;  leaf = leaf->next) {
+        memcpy(&record[n], leaf->record, leaf->count * sizeof(cdpRecord));
+        cdp_record_moved(&record[n], leaf->record, leaf->count);
+        n += leaf->count;
+    }
+    assert(n == count);
+    record_sort(record, count, compare, context);
+
+    cdpBTreeLeaf* leaf = btree->first;
+    for (n = 0;  ;  leaf = leaf->next) {
+        unsigned fill = (unsigned) cdp_min(count - n, (size_t)BTREE_LEAF_WIDTH);
+        memcpy(leaf->record, &record[n], fill * sizeof(cdpRecord));
+        cdp_record_moved(leaf->record, &record[n], fill);
+        btree_relink_records(leaf->record, fill);
+        for (unsigned i = 0;  i < fill;  i++)
+            leaf->key[i] = *cdp_record_get_name(&leaf->record[i]);
+        leaf->count  = fill;
+        leaf->parent = NULL;
+        n += fill;
+        if (n == count)
+            break;
+    }
+    cdp_free(record);
+
+    // Leaves left over are released (they were holding fewer records).
+    for (cdpBTreeLeaf* next = leaf->next, *toDel;  next; ) {
+        toDel = next;
+        next = next->next;
+        btree_leaf_del(toDel);
+    }
+    leaf->next  = NULL;
+    btree->last = leaf;
+
+    if (btree->height)
+        btree_inner_del_all(btree->root);
+    btree->root   = btree->first;
+    btree->height = 0;
+    for (leaf = btree->first->next;  leaf;  leaf = leaf->next)
+        btree_insert_child(btree, leaf->prev->parent, leaf->prev, &leaf->key[0], leaf, leaf, true);
+    return true;
+}
+
+
+static inline void btree_del_all_children(cdpBTree* btree) {
+    cdpBTreeLeaf* leaf = btree->first, *toDel;
+    while (leaf) {
+        for (unsigned i = 0;  i < leaf->count;  i++)
+            cdp_record_finalize(&leaf->record[i]);
+        toDel = leaf;
+        leaf = leaf->next;
+        btree_leaf_del(toDel);
+    }
+    if (btree->height)
+        btree_inner_del_all(btree->root);
+    btree->root   = NULL;
+    btree->height = 0;
+    btree->first  = btree->last = NULL;
+}
@@ -22,15 +22,42 @@
  */
 
 
+typedef struct {
+    uint64_t    domain;         // Child name domain (without system bits).
+    uint64_t    tag;            // Child name tag.
+} cdpArrayKey;
+
 typedef struct {
     cdpStore    store;          // Parent info.
     //
     size_t      capacity;       // Total capacity of the array to manage allocations
+    cdpRecord*  buffer;         // Allocated buffer (children may start past its beginning).
+    cdpArrayKey* keys;          // Packed children names, parallel to buffer (dictionaries only).
     //
-    cdpRecord*  record;         // Children Record
+    cdpRecord*  record;         // Children Record (the first one).
 } cdpArray;
 
 
+/*
+    Children are kept contiguous, but not necessarily at the start of the
+    buffer: the free gap before them lets prepends and pops at the front
+    run in (amortized) constant time, just like appends and takes at the
+    back, so an array works as a deque.
+*/
+#define array_front_room(a)   ((size_t)((a)->record - (a)->buffer))
+#define array_back_room(a)    ((a)->capacity - array_front_room(a) - (a)->store.chdCount)
+
+
+/*
+    Name lookups in dictionaries run over a packed copy of the children
+    names instead of the records themselves: four keys share a cache line
+    and the search is branch-free, with no compare callback involved.
+    The key for a child lives at the same index as its record.
+*/
+#define ARRAY_KEY_SCAN          8       // Keys left for the final linear count.
+#define array_key_of(a, r)      (&(a)->keys[(r) - (a)->buffer])
+
+
 
 
 /*
@@ -38,16 +65,84 @@ typedef struct {
 */
 
 static inline cdpArray* array_new(int capacity) {
-    CDP_NEW(cdpArray, array);
+    SLAB_TRY_NEW(cdpArray, array);
+    if CDP_RARELY(!array)
+        return NULL;
     array->capacity = capacity;
-    array->record = cdp_malloc0(capacity * sizeof(cdpRecord));
+    array->buffer = cdp_try_malloc0(capacity * sizeof(cdpRecord));
+    if CDP_RARELY(!array->buffer) {
+        slab_del_item(cdpArray, array);
+        return NULL;
+    }
+    array->record = array->buffer;
     return array;
 }
 
 
 static inline void array_del(cdpArray* array) {
-    cdp_free(array->record);
-    cdp_free(array);
+    cdp_free(array->keys);
+    cdp_free(array->buffer);
+    slab_del_item(cdpArray, array);
+}
+
+
+static inline void array_key_set(cdpArray* array, const cdpRecord* record) {
+    cdpArrayKey* key = array_key_of(array, record);
+    key->domain = record->metarecord.domain;
+    key->tag    = record->metarecord.tag;
+}
+
+
+static inline void array_keys_move(cdpArray* array, cdpRecord* dst, cdpRecord* src, size_t count) {
+    if (array->keys)
+        memmove(array_key_of(array, dst), array_key_of(array, src), count * sizeof(cdpArrayKey));
+}
+
+
+static inline bool array_keys_build(cdpArray* array) {
+    if (!array->keys) {
+        array->keys = cdp_try_malloc(array->capacity * sizeof(cdpArrayKey));
+        if CDP_RARELY(!array->keys)
+            return false;
+    }
+    cdpRecord* record = array->record;
+    for (size_t n = 0;  n < array->store.chdCount;  n++, record++)
+        array_key_set(array, record);
+    return true;
+}
+
+
+static inline size_t array_key_less(const cdpArrayKey* key, uint64_t domain, uint64_t tag) {
+    return (key->domain < domain) | ((key->domain == domain) & (key->tag < tag));
+}
+
+
+static inline size_t array_key_lower_bound(cdpArray* array, uint64_t domain, uint64_t tag) {
+    // Branch-free binary search, then a linear count the compiler can vectorize.
+    const cdpArrayKey* first = array_key_of(array, array->record);
+    const cdpArrayKey* base  = first;
+    size_t len = array->store.chdCount;
+    while (len > ARRAY_KEY_SCAN) {
+        size_t half = len >> 1;
+        base += array_key_less(&base[half - 1], domain, tag) * half;
+        len  -= half;
+    }
+    size_t less = 0;
+    for (size_t n = 0;  n < len;  n++)
+        less += array_key_less(&base[n], domain, tag);
+    return (size_t)(base - first) + less;
+}
+
+
+static inline cdpRecord* array_search_by_name(cdpArray* array, const cdpDT* name, size_t* index) {
+    size_t i = array_key_lower_bound(array, name->domain, name->tag);
+    CDP_PTR_SEC_SET(index, i);
+    if (i < array->store.chdCount) {
+        const cdpArrayKey* key = array_key_of(array, &array->record[i]);
+        if (key->domain == name->domain  &&  key->tag == name->tag)
+            return &array->record[i];
+    }
+    return NULL;
 }
 
 
@@ -76,90 +171,186 @@ static inline cdpRecord* array_search(cdpArray* array, const void* key, cdpCompa
 
 static inline void array_update_children_parent_ptr(cdpRecord* record, cdpRecord* last) {
     for (;  record <= last;  record++) {
-        if (cdp_record_children(record))
+        if (!cdp_record_is_link(record) && record->store)
             cdp_record_relink_storage(record);
     }
 }
 
 
-static inline void array_grow(cdpArray* array) {
-      assert(array->capacity);
-      array->capacity *= 2;
-      CDP_REALLOC(array->record, array->capacity * sizeof(cdpRecord));
-      memset(&array->record[array->store.chdCount], 0, array->store.chdCount * sizeof(cdpRecord));
-      array_update_children_parent_ptr(array->record, &array->record[array->store.chdCount - 1]);
+static inline void array_move_children(cdpArray* array, cdpRecord* record) {
+    // Moves the block of children to a new start inside the buffer.
+    size_t count = array->store.chdCount;
+    if (!count) {
+        array->record = record;
+        return;
+    }
+    memmove(record, array->record, count * sizeof(cdpRecord));
+    cdp_record_moved(record, array->record, count);
+    array_keys_move(array, record, array->record, count);
+    if (record < array->record)
+        memset(&record[count], 0, (size_t)(array->record - record) * sizeof(cdpRecord));
+    else
+        memset(array->record, 0, (size_t)(record - array->record) * sizeof(cdpRecord));
+    array->record = record;
+    array_update_children_parent_ptr(record, &record[count - 1]);
 }
 
 
-static inline cdpRecord* array_sorted_insert_record(cdpArray* array, const cdpRecord* record, cdpCompare compare, void* context) {
-    size_t index = 0;
-    cdpRecord* prev = array_search(array, record, compare, context, &index);
-    if (prev) {
-        // FixMe: delete children.
-        assert(prev);
+static inline bool array_make_room(cdpArray* array, bool front) {
+    if (front? array_front_room(array): array_back_room(array))
+        return true;
+
+    size_t count = array->store.chdCount;
+    size_t slack = array->capacity - count;
+
+    if (slack  &&  (slack << 2) >= array->capacity) {
+        // There is plenty of space on the other end: split it evenly.
+        size_t gap = front? (slack + 1) >> 1:  slack >> 1;
+        array_move_children(array, &array->buffer[gap]);
+        return true;
     }
-    cdpRecord* child = &array->record[index];
-    if (index < array->store.chdCount) {
-        memmove(child + 1, child, array->store.chdCount * sizeof(cdpRecord));
-        array_update_children_parent_ptr(child + 1, &array->record[array->store.chdCount]);
-        CDP_0(child);
+
+    assert(array->capacity);
+    size_t front_room = array_front_room(array);     // Zero when growing the front.
+    size_t added = array->capacity;
+    size_t capacity = array->capacity * 2;
+    if (array->keys) {
+        // Keys grow first: if the buffer can't, they are just larger than needed.
+        cdpArrayKey* keys = cdp_try_realloc(array->keys, capacity * sizeof(cdpArrayKey));
+        if CDP_RARELY(!keys)
+            return false;
+        array->keys = keys;
     }
-    return child;
+    cdpRecord* buffer = cdp_try_realloc(array->buffer, capacity * sizeof(cdpRecord));
+    if CDP_RARELY(!buffer)
+        return false;
+    if (buffer != array->buffer)
+        cdp_record_moved(&buffer[front_room], array->record, count);
+    array->buffer   = buffer;
+    array->capacity = capacity;
+    memset(&array->buffer[array->capacity - added], 0, added * sizeof(cdpRecord));
+    array->record = &array->buffer[front_room];
+    if (front) {
+        // All new room goes to the front.
+        array_move_children(array, &array->buffer[added]);
+    } else if (count) {
+        array_update_children_parent_ptr(array->record, &array->record[count - 1]);
+    }
+    return true;
 }
 
 
-static inline cdpRecord* array_insert(cdpArray* array, cdpRecord* record, size_t position) {
-    if (array->capacity == array->store.chdCount)
-        array_grow(array);
-
+static inline cdpRecord* array_open_slot(cdpArray* array, size_t position) {
+    // Makes room for a new child at position, moving the shorter side.
+    size_t count = array->store.chdCount;
     cdpRecord* child;
 
-    if (array->store.chdCount) {
+    if (position < (count >> 1)) {
+        if CDP_RARELY(!array_make_room(array, true))
+            return NULL;
+        array->record--;
         child = &array->record[position];
-        size_t tomove = array->store.chdCount - position;
+        if (position) {
+            memmove(array->record, array->record + 1, position * sizeof(cdpRecord));
+            cdp_record_moved(array->record, array->record + 1, position);
+            array_keys_move(array, array->record, array->record + 1, position);
+            array_update_children_parent_ptr(array->record, child - 1);
+        }
+    } else {
+        if CDP_RARELY(!array_make_room(array, false))
+            return NULL;
+        child = &array->record[position];
+        size_t tomove = count - position;
         if (tomove) {
             memmove(child + 1, child, tomove * sizeof(cdpRecord));
-            array_update_children_parent_ptr(child + 1,  &array->record[array->store.chdCount]);
+            cdp_record_moved(child + 1, child, tomove);
+            array_keys_move(array, child + 1, child, tomove);
+            array_update_children_parent_ptr(child + 1, &array->record[count]);
+        }
+    }
+
+    CDP_0(child);
+    return child;
+}
+
+
+static inline void array_close_slot(cdpArray* array, cdpRecord* record) {
+    // Removes the (already released) child at record, moving the shorter side.
+    size_t count = array->store.chdCount;
+    size_t position = (size_t)(record - array->record);
+
+    if (position < (count >> 1)) {
+        if (position) {
+            memmove(array->record + 1, array->record, position * sizeof(cdpRecord));
+            cdp_record_moved(array->record + 1, array->record, position);
+            array_keys_move(array, array->record + 1, array->record, position);
+            array_update_children_parent_ptr(array->record + 1, record);
         }
-        CDP_0(child);
+        CDP_0(array->record);
+        array->record++;
     } else {
-        child = array->record;
+        cdpRecord* last = &array->record[count - 1];
+        if (record < last) {
+            memmove(record, record + 1, (size_t) cdp_ptr_dif(last, record));
+            cdp_record_moved(record, record + 1, (size_t)(last - record));
+            array_keys_move(array, record, record + 1, (size_t)(last - record));
+            array_update_children_parent_ptr(record, last - 1);
+        }
+        CDP_0(last);
     }
 
-    cdp_record_transfer(record, child);
+    if (count == 1)
+        array->record = array->buffer;      // Empty again: restart at the front.
+}
+
 
+static inline cdpRecord* array_sorted_insert_record(cdpArray* array, const cdpRecord* record, cdpCompare compare, void* context) {
+    size_t index = 0;
+    cdpRecord* prev = array_search(array, record, compare, context, &index);
+    if (prev) {
+        // FixMe: delete children.
+        assert(prev);
+    }
+    return array_open_slot(array, index);
+}
+
+
+static inline cdpRecord* array_insert(cdpArray* array, cdpRecord* record, size_t position) {
+    cdpRecord* child = array_open_slot(array, position);
+    if CDP_RARELY(!child)
+        return NULL;
+    cdp_record_transfer(record, child);
     return child;
 }
 
 
 static inline cdpRecord* array_named_insert(cdpArray* array, cdpRecord* record) {
-    if (array->capacity == array->store.chdCount)
-        array_grow(array);
-
-    cdpRecord* child;
+    if (!array->keys  &&  !array_keys_build(array))
+        return NULL;
 
-    if (array->store.chdCount) {
-        child = array_sorted_insert_record(array, record, record_compare_by_name, NULL);
-    } else {
-        child = array->record;
-    }
+    size_t index = 0;
+    if (array->store.chdCount)
+        array_search_by_name(array, cdp_record_get_name(record), &index);
+    cdpRecord* child = array_open_slot(array, index);
+    if CDP_RARELY(!child)
+        return NULL;
 
     cdp_record_transfer(record, child);
+    array_key_set(array, child);
 
     return child;
 }
 
 
 static inline cdpRecord* array_sorted_insert(cdpArray* array, cdpRecord* record, cdpCompare compare, void* context) {
-    if (array->capacity == array->store.chdCount)
-        array_grow(array);
-
     cdpRecord* child;
 
     if (array->store.chdCount)
         child = array_sorted_insert_record(array, record, compare, context);
     else
         child = array->record;
+    if CDP_RARELY(!child)
+        return NULL;
 
     cdp_record_transfer(record, child);
 
@@ -168,17 +359,13 @@ static inline cdpRecord* array_sorted_insert(cdpArray* array, cdpRecord* record,
 
 
 static inline cdpRecord* array_append(cdpArray* array, cdpRecord* record, bool prepend) {
-    if (array->capacity == array->store.chdCount)
-        array_grow(array);
-
     cdpRecord* child;
 
     if (array->store.chdCount) {
+        if CDP_RARELY(!array_make_room(array, prepend))
+            return NULL;
         if (prepend) {
-            child = array->record;
-            memmove(child + 1, child, array->store.chdCount * sizeof(cdpRecord));
-            array_update_children_parent_ptr(child + 1, &array->record[array->store.chdCount]);
-            CDP_0(child);
+            child = --array->record;
         } else {
             child = &array->record[array->store.chdCount];
         }
@@ -204,6 +391,8 @@ static inline cdpRecord* array_last(cdpArray* array) {
 
 static inline cdpRecord* array_find_by_name(cdpArray* array, const cdpDT* name) {
     if (cdp_store_is_dictionary(&array->store)) {
+        if (array->keys)
+            return array_search_by_name(array, name, NULL);
         cdpRecord key = {.metarecord.domain = name->domain, .metarecord.tag = name->tag};
         return array_search(array, &key, record_compare_by_name, NULL, NULL);
     } else {
@@ -232,6 +421,11 @@ static inline cdpRecord* array_prev(cdpArray* array, cdpRecord* record) {
 }
 
 
+static inline size_t array_index_of(cdpArray* array, const cdpRecord* record) {
+    return (size_t)(record - array->record);
+}
+
+
 static inline cdpRecord* array_next(cdpArray* array, cdpRecord* record) {
     cdpRecord* last = &array->record[array->store.chdCount - 1];
     return (record < last)? record + 1: NULL;
@@ -239,11 +433,14 @@ static inline cdpRecord* array_next(cdpArray* array, cdpRecord* record) {
 
 
 static inline cdpRecord* array_next_by_name(cdpArray* array, cdpDT* name, uintptr_t* prev) {
-    cdpRecord* record = array->record;
-    for (size_t i = prev? (*prev + 1): 0;  i < array->store.chdCount;  i++, record++){
-        if (cdp_record_name_is(record, name))
+    cdpRecord* record = *prev?  array_next(array, (cdpRecord*)*prev):  array->record;
+    for (;  record;  record = array_next(array, record)) {
+        if (cdp_record_name_is(record, name)) {
+            *prev = (uintptr_t)record;
             return record;
+        }
     }
+    *prev = 0;
     return NULL;
 }
 
@@ -269,14 +466,11 @@ static inline bool array_traverse(cdpArray* array, cdpTraverse func, void* conte
 
 
 static inline void array_sort(cdpArray* array, cdpCompare compare, void* context) {
-  #ifdef _GNU_SOURCE
-    qsort_r
-  #else
-    qsort_s
-  #endif
-        (array->record, array->store.chdCount, sizeof(cdpRecord), (cdpFunc) compare, context);
+    record_sort(array->record, array->store.chdCount, compare, context);
 
     array_update_children_parent_ptr(array->record, &array->record[array->store.chdCount - 1]);
+    if (array->keys)
+        array_keys_build(array);
 }
 
 
@@ -284,31 +478,21 @@ static inline void array_take(cdpArray* array, cdpRecord* target) {
     assert(array && array->capacity >= array->store.chdCount);
     cdpRecord* last = &array->record[array->store.chdCount - 1];
     cdp_record_transfer(last, target);
-    CDP_0(last);
+    array_close_slot(array, last);
 }
 
 
 static inline void array_pop(cdpArray* array, cdpRecord* target) {
     assert(array && array->capacity >= array->store.chdCount);
     cdpRecord* first = array->record;
-    cdpRecord* last = &array->record[array->store.chdCount - 1];
     cdp_record_transfer(first, target);
-    if (first < last) {
-        memmove(first, first + 1, (size_t) cdp_ptr_dif(last, first));
-        array_update_children_parent_ptr(first, last - 1);
-    }
-    CDP_0(last);
+    array_close_slot(array, first);
 }
 
 
 static inline void array_remove_record(cdpArray* array, cdpRecord* record) {
     assert(array && array->capacity >= array->store.chdCount);
-    cdpRecord* last = &array->record[array->store.chdCount - 1];
-    if (record < last) {
-        memmove(record, record + 1, (size_t) cdp_ptr_dif(last, record));
-        array_update_children_parent_ptr(record, last - 1);
-    }
-    CDP_0(last);
+    array_close_slot(array, record);
 }
 
 
@@ -318,4 +502,5 @@ static inline void array_del_all_children(cdpArray* array) {
         cdp_record_finalize(child);
         CDP_0(child);   // ToDo: this may be skipped.
     }
+    array->record = array->buffer;
 }
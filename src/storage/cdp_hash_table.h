@@ -0,0 +1,350 @@
+/*
+ *  Copyright (c) 2025 Victor M. Barrientos (https://github.com/FirmwGuy/CacadeDP)
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of
+ *  this software and associated documentation files (the "Software"), to deal in
+ *  the Software without restriction, including without limitation the rights to
+ *  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is furnished to do
+ *  so.
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+
+typedef struct _cdpHashNode     cdpHashNode;
+
+struct _cdpHashNode {
+    cdpHashNode*  next;         // Next node (in insertion order).
+    cdpHashNode*  prev;         // Previous node.
+    uint64_t      hash;         // Hash value of the record key.
+    //
+    cdpRecord     record;       // Child record.
+};
+
+typedef struct {
+    uint64_t      hash;         // Hash value of the occupying node (cached for probing).
+    cdpHashNode*  node;         // Node occupying this slot (NULL if empty).
+} cdpHashSlot;
+
+typedef struct {
+    cdpStore      store;        // Parent info.
+    //
+    size_t        capacity;     // Number of slots (always a power of two).
+    cdpHashSlot*  slot;         // Open addressing (linear probing) slot table.
+    cdpHashNode*  head;         // Head of the insertion ordered node list.
+    cdpHashNode*  tail;         // Tail of the node list.
+} cdpHashTable;
+
+
+#define HASH_TABLE_MIN_CAPACITY     8
+#define hash_table_overloaded(t, n) (((n) << 2) > ((t)->capacity * 3))     // Load factor above 3/4.
+
+
+
+
+/*
+    Hash table implementation
+*/
+
+static inline cdpHashTable* hash_table_new(size_t capacity) {
+    SLAB_TRY_NEW(cdpHashTable, table);
+    if CDP_RARELY(!table)
+        return NULL;
+    capacity = cdp_max((size_t)HASH_TABLE_MIN_CAPACITY, capacity + (capacity / 3) + 1);
+    table->capacity = cdp_next_pow_of_two(capacity);
+    table->slot = cdp_try_malloc0(table->capacity * sizeof(cdpHashSlot));
+    if CDP_RARELY(!table->slot) {
+        slab_del_item(cdpHashTable, table);
+        return NULL;
+    }
+    return table;
+}
+
+
+static inline void hash_table_del(cdpHashTable* table) {
+    cdp_free(table->slot);
+    slab_del_item(cdpHashTable, table);
+}
+
+
+static inline cdpHashNode* hash_table_node_new(cdpRecord* record) {
+    SLAB_TRY_NEW(cdpHashNode, hnode);
+    if CDP_EXPECT_PTR(hnode)
+        cdp_record_transfer(record, &hnode->record);
+    return hnode;
+}
+
+#define hash_table_node_del(hnode)  slab_del_item(cdpHashNode, hnode)
+
+
+static inline cdpHashNode* hash_table_node_from_record(const cdpRecord* record) {
+    return cdp_ptr_dif(record, offsetof(cdpHashNode, record));
+}
+
+
+static inline uint64_t hash_table_record_hash(cdpHashTable* table, const cdpRecord* record) {
+    if (table->store.indexing == CDP_INDEX_BY_NAME)
+        return cdp_dt_hash(cdp_record_get_name(record));
+    return record_data_hash(record);      // Cached in the data itself.
+}
+
+
+
+
+static inline void hash_table_slot_put(cdpHashTable* table, cdpHashNode* hnode) {
+    size_t mask = table->capacity - 1;
+    size_t i = hnode->hash & mask;
+    while (table->slot[i].node)
+        i = (i + 1) & mask;
+    table->slot[i].hash = hnode->hash;
+    table->slot[i].node = hnode;
+}
+
+
+static inline size_t hash_table_slot_of(cdpHashTable* table, cdpHashNode* hnode) {
+    size_t mask = table->capacity - 1;
+    size_t i = hnode->hash & mask;
+    while (table->slot[i].node != hnode) {
+        assert(table->slot[i].node);
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+
+static inline void hash_table_slot_clear(cdpHashTable* table, size_t i) {
+    // Backward shift deletion (no tombstones are ever left behind).
+    size_t mask = table->capacity - 1;
+    size_t j = i;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (!table->slot[j].node)
+            break;
+        size_t k = table->slot[j].hash & mask;      // Home slot of the entry at 'j'.
+        if ((i <= j)?  ((i < k) && (k <= j)):  ((i < k) || (k <= j)))
+            continue;
+        table->slot[i] = table->slot[j];
+        i = j;
+    }
+    table->slot[i].node = NULL;
+}
+
+
+static inline void hash_table_grow(cdpHashTable* table) {
+    cdpHashSlot* slot = cdp_try_malloc0(table->capacity * 2 * sizeof(cdpHashSlot));
+    if CDP_RARELY(!slot)
+        return;     // Out of memory: just keep probing longer.
+    cdp_free(table->slot);
+    table->capacity *= 2;
+    table->slot = slot;
+    for (cdpHashNode* hnode = table->head;  hnode;  hnode = hnode->next) {
+        hash_table_slot_put(table, hnode);
+    }
+}
+
+
+static inline cdpHashNode* hash_table_search(cdpHashTable* table, uint64_t hash, const cdpRecord* key, cdpCompare compare, void* context) {
+    size_t mask = table->capacity - 1;
+    for (size_t i = hash & mask;  table->slot[i].node;  i = (i + 1) & mask) {
+        if (table->slot[i].hash == hash
+         && 0 == compare(key, &table->slot[i].node->record, context))
+            return table->slot[i].node;
+    }
+    return NULL;
+}
+
+
+
+
+static inline bool hash_table_reserve(cdpHashTable* table) {
+    // Makes room for one more node, before the record is transferred into it (failing then undoes nothing).
+    if (hash_table_overloaded(table, table->store.chdCount + 1))
+        hash_table_grow(table);
+    return (table->store.chdCount + 1 < table->capacity);     // Some slot must stay empty.
+}
+
+
+static inline cdpRecord* hash_table_insert_hnode(cdpHashTable* table, cdpHashNode* hnode) {
+    hash_table_slot_put(table, hnode);
+
+    hnode->prev = table->tail;
+    if (table->tail)
+        table->tail->next = hnode;
+    else
+        table->head = hnode;
+    table->tail = hnode;
+
+    return &hnode->record;
+}
+
+
+static inline cdpRecord* hash_table_named_insert(cdpHashTable* table, cdpRecord* record) {
+    uint64_t hash = cdp_dt_hash(cdp_record_get_name(record));
+    assert(!hash_table_search(table, hash, record, record_compare_by_name, NULL));   // Duplicates are not allowed.
+    if CDP_RARELY(!hash_table_reserve(table))
+        return NULL;
+    cdpHashNode* hnode = hash_table_node_new(record);
+    if CDP_RARELY(!hnode)
+        return NULL;
+    hnode->hash = hash;
+    return hash_table_insert_hnode(table, hnode);
+}
+
+
+static inline cdpRecord* hash_table_hashed_insert(cdpHashTable* table, cdpRecord* record, cdpCompare compare, void* context) {
+    uint64_t hash = record_data_hash(record);
+    assert(!hash_table_search(table, hash, record, compare, context));              // Duplicates are not allowed.
+    if CDP_RARELY(!hash_table_reserve(table))
+        return NULL;
+    cdpHashNode* hnode = hash_table_node_new(record);
+    if CDP_RARELY(!hnode)
+        return NULL;
+    hnode->hash = hash;
+    return hash_table_insert_hnode(table, hnode);
+}
+
+
+static inline cdpRecord* hash_table_first(cdpHashTable* table) {
+    return &table->head->record;
+}
+
+
+static inline cdpRecord* hash_table_last(cdpHashTable* table) {
+    return &table->tail->record;
+}
+
+
+static inline cdpRecord* hash_table_find_by_name(cdpHashTable* table, const cdpDT* name) {
+    if (cdp_store_is_dictionary(&table->store)) {
+        cdpRecord key = {.metarecord.domain = name->domain, .metarecord.tag = name->tag};
+        cdpHashNode* hnode = hash_table_search(table, cdp_dt_hash(name), &key, record_compare_by_name, NULL);
+        return hnode? &hnode->record: NULL;
+    } else {
+        for (cdpHashNode* hnode = table->head;  hnode;  hnode = hnode->next) {
+            if (cdp_record_name_is(&hnode->record, name))
+                return &hnode->record;
+        }
+    }
+    return NULL;
+}
+
+
+static inline cdpRecord* hash_table_find_by_key(cdpHashTable* table, cdpRecord* key, cdpCompare compare, void* context) {
+    cdpHashNode* hnode = hash_table_search(table, hash_table_record_hash(table, key), key, compare, context);
+    return hnode? &hnode->record: NULL;
+}
+
+
+static inline cdpRecord* hash_table_find_by_position(cdpHashTable* table, size_t position) {
+    size_t n = 0;
+    for (cdpHashNode* hnode = table->head;  hnode;  hnode = hnode->next, n++) {
+        if (n == position)
+            return &hnode->record;
+    }
+    return NULL;
+}
+
+
+static inline cdpRecord* hash_table_prev(const cdpRecord* record) {
+    cdpHashNode* hnode = hash_table_node_from_record(record);
+    return hnode->prev? &hnode->prev->record: NULL;
+}
+
+
+static inline cdpRecord* hash_table_next(const cdpRecord* record) {
+    cdpHashNode* hnode = hash_table_node_from_record(record);
+    return hnode->next? &hnode->next->record: NULL;
+}
+
+
+static inline cdpRecord* hash_table_next_by_name(cdpHashTable* table, cdpDT* name, cdpHashNode** prev) {
+    cdpHashNode* hnode = *prev?  (*prev)->next:  table->head;
+    while (hnode) {
+        if (cdp_record_name_is(&hnode->record, name)) {
+            *prev = hnode;
+            return &hnode->record;
+        }
+        hnode = hnode->next;
+    }
+    *prev = NULL;
+    return NULL;
+}
+
+
+static inline bool hash_table_traverse(cdpHashTable* table, cdpTraverse func, void* context, cdpEntry* entry) {
+    entry->parent = table->store.owner;
+    entry->depth  = 0;
+    cdpHashNode* hnode = table->head, *next;
+    do {
+        next = hnode->next;
+        entry->record = &hnode->record;
+        entry->next = next? &next->record: NULL;
+        if (!func(entry, context))
+            return false;
+        entry->position++;
+        entry->prev = entry->record;
+        hnode = next;
+    } while (hnode);
+    return true;
+}
+
+
+static inline void hash_table_remove_hnode(cdpHashTable* table, cdpHashNode* hnode) {
+    hash_table_slot_clear(table, hash_table_slot_of(table, hnode));
+
+    // Unlink node.
+    if (hnode->next) hnode->next->prev = hnode->prev;
+    else             table->tail = hnode->prev;
+    if (hnode->prev) hnode->prev->next = hnode->next;
+    else             table->head = hnode->next;
+
+    hash_table_node_del(hnode);
+}
+
+
+static inline void hash_table_take(cdpHashTable* table, cdpRecord* target) {
+    assert(table && table->tail);
+    cdpHashNode* hnode = table->tail;
+    cdp_record_transfer(&hnode->record, target);
+    hash_table_remove_hnode(table, hnode);
+}
+
+
+static inline void hash_table_pop(cdpHashTable* table, cdpRecord* target) {
+    assert(table && table->head);
+    cdpHashNode* hnode = table->head;
+    cdp_record_transfer(&hnode->record, target);
+    hash_table_remove_hnode(table, hnode);
+}
+
+
+static inline void hash_table_remove_record(cdpHashTable* table, cdpRecord* record) {
+    assert(table && table->head);
+    hash_table_remove_hnode(table, hash_table_node_from_record(record));
+}
+
+
+static inline void hash_table_del_all_children(cdpHashTable* table) {
+    cdpHashNode* hnode = table->head, *toDel;
+    if (hnode) {
+        do {
+            cdp_record_finalize(&hnode->record);
+            toDel = hnode;
+            hnode = hnode->next;
+            hash_table_node_del(toDel);
+        } while (hnode);
+        table->head = table->tail = NULL;
+        memset(table->slot, 0, table->capacity * sizeof(cdpHashSlot));
+    }
+}
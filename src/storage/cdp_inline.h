@@ -0,0 +1,244 @@
+/*
+ *  Copyright (c) 2025 Victor M. Barrientos (https://github.com/FirmwGuy/CacadeDP)
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of
+ *  this software and associated documentation files (the "Software"), to deal in
+ *  the Software without restriction, including without limitation the rights to
+ *  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is furnished to do
+ *  so.
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+
+typedef struct {
+    cdpStore    store;          // Parent info.
+    //
+    size_t      capacity;       // Children that fit (fixed at creation).
+    cdpRecord   record[];       // Children records, in the same block as the store.
+} cdpInline;
+
+
+/*
+    A handful of children live right after the store header, so records
+    with very few children take a single allocation. Children always
+    start at the first slot and lookups are linear (which is as fast as
+    it gets at this size). Once full, the store is promoted to a regular
+    array (see cdp_store_add_child).
+*/
+#define INLINE_MAX_CAPACITY     16
+#define inline_is_full(i)       ((i)->store.chdCount >= (i)->capacity)
+
+
+
+
+/*
+    Inline (small vector) implementation
+*/
+
+static inline cdpInline* inline_new(size_t capacity) {
+    assert(capacity  &&  capacity <= INLINE_MAX_CAPACITY);
+    cdpInline* inl = slab_try_alloc0(sizeof(cdpInline) + (capacity * sizeof(cdpRecord)));
+    if CDP_RARELY(!inl)
+        return NULL;
+    inl->capacity = capacity;
+    return inl;
+}
+
+#define inline_del(inl)     slab_free(inl, sizeof(cdpInline) + ((inl)->capacity * sizeof(cdpRecord)))
+
+
+static inline void inline_update_children_parent_ptr(cdpRecord* record, cdpRecord* last) {
+    for (;  record <= last;  record++) {
+        if (!cdp_record_is_link(record) && record->store)
+            cdp_record_relink_storage(record);
+    }
+}
+
+
+static inline cdpRecord* inline_open_slot(cdpInline* inl, size_t position) {
+    assert(!inline_is_full(inl)  &&  position <= inl->store.chdCount);
+    cdpRecord* child = &inl->record[position];
+    size_t tomove = inl->store.chdCount - position;
+    if (tomove) {
+        memmove(child + 1, child, tomove * sizeof(cdpRecord));
+        cdp_record_moved(child + 1, child, tomove);
+        inline_update_children_parent_ptr(child + 1, child + tomove);
+    }
+    CDP_0(child);
+    return child;
+}
+
+
+static inline void inline_close_slot(cdpInline* inl, cdpRecord* record) {
+    // Removes the (already released) child at record.
+    cdpRecord* last = &inl->record[inl->store.chdCount - 1];
+    if (record < last) {
+        memmove(record, record + 1, (size_t) cdp_ptr_dif(last, record));
+        cdp_record_moved(record, record + 1, (size_t)(last - record));
+        inline_update_children_parent_ptr(record, last - 1);
+    }
+    CDP_0(last);
+}
+
+
+static inline size_t inline_search(cdpInline* inl, const cdpRecord* key, cdpCompare compare, void* context) {
+    // Position of the first child not below key.
+    size_t i = 0;
+    while (i < inl->store.chdCount  &&  0 < compare(key, &inl->record[i], context))
+        i++;
+    return i;
+}
+
+
+
+
+static inline cdpRecord* inline_insert(cdpInline* inl, cdpRecord* record, size_t position) {
+    cdpRecord* child = inline_open_slot(inl, position);
+    cdp_record_transfer(record, child);
+    return child;
+}
+
+
+static inline cdpRecord* inline_sorted_insert(cdpInline* inl, cdpRecord* record, cdpCompare compare, void* context) {
+    size_t position = inline_search(inl, record, compare, context);
+    assert(position == inl->store.chdCount  ||  0 != compare(record, &inl->record[position], context));   // Duplicates are not allowed.
+    return inline_insert(inl, record, position);
+}
+
+
+static inline cdpRecord* inline_named_insert(cdpInline* inl, cdpRecord* record) {
+    return inline_sorted_insert(inl, record, record_compare_by_name, NULL);
+}
+
+
+static inline cdpRecord* inline_append(cdpInline* inl, cdpRecord* record, bool prepend) {
+    return inline_insert(inl, record, prepend? 0: inl->store.chdCount);
+}
+
+
+static inline cdpRecord* inline_first(cdpInline* inl) {
+    return inl->record;
+}
+
+
+static inline cdpRecord* inline_last(cdpInline* inl) {
+    return &inl->record[inl->store.chdCount - 1];
+}
+
+
+static inline cdpRecord* inline_find_by_name(cdpInline* inl, const cdpDT* name) {
+    cdpRecord* record = inl->record;
+    for (size_t i = 0;  i < inl->store.chdCount;  i++, record++) {
+        if (cdp_record_name_is(record, name))
+            return record;
+    }
+    return NULL;
+}
+
+
+static inline cdpRecord* inline_find_by_key(cdpInline* inl, cdpRecord* key, cdpCompare compare, void* context) {
+    cdpRecord* record = inl->record;
+    for (size_t i = 0;  i < inl->store.chdCount;  i++, record++) {
+        if (0 == compare(key, record, context))
+            return record;
+    }
+    return NULL;
+}
+
+
+static inline cdpRecord* inline_find_by_position(cdpInline* inl, size_t position) {
+    return &inl->record[position];
+}
+
+
+static inline cdpRecord* inline_prev(cdpInline* inl, cdpRecord* record) {
+    return (record > inl->record)? record - 1: NULL;
+}
+
+
+static inline cdpRecord* inline_next(cdpInline* inl, cdpRecord* record) {
+    return (record < &inl->record[inl->store.chdCount - 1])? record + 1: NULL;
+}
+
+
+static inline size_t inline_index_of(cdpInline* inl, const cdpRecord* record) {
+    return (size_t)(record - inl->record);
+}
+
+
+static inline cdpRecord* inline_next_by_name(cdpInline* inl, cdpDT* name, uintptr_t* prev) {
+    cdpRecord* record = *prev?  inline_next(inl, (cdpRecord*)*prev):  inl->record;
+    for (;  record;  record = inline_next(inl, record)) {
+        if (cdp_record_name_is(record, name)) {
+            *prev = (uintptr_t)record;
+            return record;
+        }
+    }
+    *prev = 0;
+    return NULL;
+}
+
+
+static inline bool inline_traverse(cdpInline* inl, cdpTraverse func, void* context, cdpEntry* entry) {
+    entry->parent = inl->store.owner;
+    entry->depth  = 0;
+    cdpRecord* last = &inl->record[inl->store.chdCount - 1];
+    for (cdpRecord* record = inl->record;  record <= last;  record++) {
+        entry->record = record;
+        entry->next = (record < last)? record + 1: NULL;
+        if (!func(entry, context))
+            return false;
+        entry->position++;
+        entry->prev = entry->record;
+    }
+    return true;
+}
+
+
+static inline void inline_sort(cdpInline* inl, cdpCompare compare, void* context) {
+    record_sort(inl->record, inl->store.chdCount, compare, context);
+
+    inline_update_children_parent_ptr(inl->record, &inl->record[inl->store.chdCount - 1]);
+}
+
+
+
+
+static inline void inline_take(cdpInline* inl, cdpRecord* target) {
+    assert(inl && inl->store.chdCount);
+    cdpRecord* last = &inl->record[inl->store.chdCount - 1];
+    cdp_record_transfer(last, target);
+    inline_close_slot(inl, last);
+}
+
+
+static inline void inline_pop(cdpInline* inl, cdpRecord* target) {
+    assert(inl && inl->store.chdCount);
+    cdp_record_transfer(inl->record, target);
+    inline_close_slot(inl, inl->record);
+}
+
+
+static inline void inline_remove_record(cdpInline* inl, cdpRecord* record) {
+    assert(inl && inl->store.chdCount);
+    inline_close_slot(inl, record);
+}
+
+
+static inline void inline_del_all_children(cdpInline* inl) {
+    for (size_t i = 0;  i < inl->store.chdCount;  i++)
+        cdp_record_finalize(&inl->record[i]);
+    memset(inl->record, 0, inl->store.chdCount * sizeof(cdpRecord));
+}
@@ -45,17 +45,18 @@ typedef struct {
     Double linked list implementation
 */
 
-#define list_new()      cdp_new(cdpList)
-#define list_del        cdp_free
+#define list_new()      slab_try_new_item(cdpList)
+#define list_del(list)  slab_del_item(cdpList, list)
 
 
 static inline cdpListNode* list_node_new(cdpRecord* record) {
-    CDP_NEW(cdpListNode, node);
-    cdp_record_transfer(record, &node->record);
+    SLAB_TRY_NEW(cdpListNode, node);
+    if CDP_EXPECT_PTR(node)
+        cdp_record_transfer(record, &node->record);
     return node;
 }
 
-#define list_node_del   cdp_free
+#define list_node_del(node)     slab_del_item(cdpListNode, node)
 
 
 static inline cdpListNode* list_node_from_record(const cdpRecord* record) {
@@ -99,6 +100,8 @@ static inline void list_insert_node_before_next(cdpList* list, cdpListNode* node
 
 static inline cdpRecord* list_insert(cdpList* list, cdpRecord* record, size_t position) {
     cdpListNode* node = list_node_new(record);
+    if CDP_RARELY(!node)
+        return NULL;
     size_t n = 0;
     cdpListNode* next;
     for (next = list->head;  next;  next = next->next, n++) {
@@ -116,6 +119,8 @@ static inline cdpRecord* list_insert(cdpList* list, cdpRecord* record, size_t po
 
 static inline cdpRecord* list_named_insert(cdpList* list, cdpRecord* record) {
     cdpListNode* node = list_node_new(record);
+    if CDP_RARELY(!node)
+        return NULL;
     cdpListNode* next;
     for (next = list->head;  next;  next = next->next) {
         int cmp = record_compare_by_name(&node->record, &next->record, NULL);
@@ -134,6 +139,8 @@ static inline cdpRecord* list_named_insert(cdpList* list, cdpRecord* record) {
 
 static inline cdpRecord* list_sorted_insert(cdpList* list, cdpRecord* record, cdpCompare compare, void* context) {
     cdpListNode* node = list_node_new(record);
+    if CDP_RARELY(!node)
+        return NULL;
     cdpListNode* next;
     for (next = list->head;  next;  next = next->next) {
         int cmp = compare(&node->record, &next->record, context);
@@ -152,6 +159,8 @@ static inline cdpRecord* list_sorted_insert(cdpList* list, cdpRecord* record, cd
 
 static inline cdpRecord* list_append(cdpList* list, cdpRecord* record, bool prepend) {
     cdpListNode* node = list_node_new(record);
+    if CDP_RARELY(!node)
+        return NULL;
 
     if (list->store.chdCount) {
         if (prepend)
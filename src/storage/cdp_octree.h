@@ -24,6 +24,7 @@
 
 typedef struct _cdpOctreeList   cdpOctreeList;
 typedef struct _cdpOctreeNode   cdpOctreeNode;
+typedef struct _cdpOctreeSlab   cdpOctreeSlab;
 
 struct _cdpOctreeList {
     cdpOctreeList*  next;           // Next child in current sector.
@@ -34,17 +35,19 @@ struct _cdpOctreeList {
     cdpRecord       record;         // Child record.
 };
 
-typedef struct {
-    float           subwide;        // Half the width/height/depth of the bounding space.
-    float           center[3];      // Center of the bounding space (XYZ coords).
-} cdpOctreeBound;
-
 struct _cdpOctreeNode {
     cdpOctreeNode*  children[8];    // Pointers to child nodes.
     cdpOctreeNode*  parent;         // Parent node.
     cdpOctreeList*  list;           // List of records in this node.
     cdpOctreeBound  bound;          // Bounding space covered by this node.
-    unsigned        index;          // Child index of this node in parent.
+    size_t          count;          // Records in this node and all its descendants.
+    unsigned        index:  3,      // Child index of this node in parent.
+                    split:  1;      // Records go down to children (otherwise this is a leaf bucket).
+};
+
+struct _cdpOctreeSlab {
+    cdpOctreeSlab*  next;           // Next slab owned by the same octree.
+    size_t          _pad;
 };
 
 typedef struct {
@@ -52,10 +55,20 @@ typedef struct {
     //
     cdpOctreeNode   root;           // The root node.
     unsigned        depth;          // Maximum tree depth (ever used).
+    unsigned        leafCap;        // Records a leaf holds before it is split.
+    unsigned        maxDepth;       // Leaves at this depth are never split.
+    //
+    cdpOctreeSlab*  slabs;          // Memory blocks for nodes and list items.
+    cdpOctreeNode*  freeNode;       // Released nodes ready for re-use.
+    cdpOctreeList*  freeList;       // Released list items.
 } cdpOctree;
 
 
-#define EPSILON     (1e-10)
+#define EPSILON                 (1e-10)
+
+#define OCTREE_LEAF_CAPACITY    8
+#define OCTREE_MAX_DEPTH        24
+#define OCTREE_SLAB_ITEMS       32
 
 
 
@@ -64,52 +77,67 @@ typedef struct {
     Octree implementation
 */
 
-static inline cdpOctreeNode* octree_node_new(cdpOctreeNode* parent, cdpOctreeBound* bound, unsigned index) {
-    assert(bound && bound->subwide > EPSILON);
-    CDP_NEW(cdpOctreeNode, onode);
-    onode->parent = parent;
-    onode->bound  = *bound;
-    onode->index  = index;
-    return onode;
+static inline void* octree_slab_alloc(cdpOctree* octree, void** freeItem, size_t itemSize) {
+    if (!*freeItem) {
+        // Carve a new slab into free items.
+        cdpOctreeSlab* slab = cdp_malloc(sizeof(cdpOctreeSlab) + (OCTREE_SLAB_ITEMS * itemSize));
+        slab->next = octree->slabs;
+        octree->slabs = slab;
+        uint8_t* item = (uint8_t*)(slab + 1);
+        for (unsigned n = 0;  n < OCTREE_SLAB_ITEMS;  n++, item += itemSize) {
+            *(void**)item = *freeItem;
+            *freeItem = item;
+        }
+    }
+    void* item = *freeItem;
+    *freeItem = *(void**)item;
+    memset(item, 0, itemSize);
+    return item;
 }
 
 
-static inline void octree_node_del(cdpOctreeNode* onode);
+static inline void octree_slab_free(void** freeItem, void* item) {
+    *(void**)item = *freeItem;      // First field of nodes and list items is a pointer.
+    *freeItem = item;
+}
 
-static inline void octree_node_clean(cdpOctreeNode* onode) {
-    for (unsigned n = 0;  n < 8;  n++) {
-        if (onode->children[n])
-            octree_node_del(onode->children[n]);
-    }
 
-    cdpOctreeList* list = onode->list;
-    while (list) {
-        cdpOctreeList* next = list->next;
-        cdp_free(list);
-        list = next;
-    }
+static inline cdpOctreeNode* octree_node_new(cdpOctree* octree, cdpOctreeNode* parent, cdpOctreeBound* bound, unsigned index) {
+    assert(bound && bound->subwide > EPSILON);
+    cdpOctreeNode* onode = octree_slab_alloc(octree, (void**)&octree->freeNode, sizeof(cdpOctreeNode));
+    onode->parent = parent;
+    onode->bound  = *bound;
+    onode->index  = index;
+    return onode;
 }
 
+#define octree_node_del(octree, onode)  octree_slab_free((void**)&(octree)->freeNode, onode)
 
-static inline void octree_node_del(cdpOctreeNode* onode) {
-    octree_node_clean(onode);
-    cdp_free(onode);
-}
+#define octree_list_new(octree)         ((cdpOctreeList*) octree_slab_alloc(octree, (void**)&(octree)->freeList, sizeof(cdpOctreeList)))
+#define octree_list_del(octree, list)   octree_slab_free((void**)&(octree)->freeList, list)
 
 
 static inline cdpOctree* octree_new(cdpOctreeBound* bound) {
     assert(bound && bound->subwide > EPSILON);
-    CDP_NEW(cdpOctree, octree);
+    SLAB_TRY_NEW(cdpOctree, octree);
+    if CDP_RARELY(!octree)
+        return NULL;
     octree->root.bound = *bound;
-    octree->depth = 1;
+    octree->depth    = 1;
+    octree->leafCap  = OCTREE_LEAF_CAPACITY;
+    octree->maxDepth = OCTREE_MAX_DEPTH;
     return octree;
 }
 
 
 static inline void octree_del(cdpOctree* octree){
     if (!octree) return;
-    octree_node_clean(&octree->root);
-    cdp_free(octree);
+    // Children must be deleted already: every node and list item lives in a slab.
+    for (cdpOctreeSlab* slab = octree->slabs, *next;  slab;  slab = next) {
+        next = slab->next;
+        cdp_free(slab);
+    }
+    slab_del_item(cdpOctree, octree);
 }
 
 
@@ -127,158 +155,189 @@ static inline cdpOctreeList* octree_list_from_record(cdpRecord* record) {
     } while(0)
 
 
-static inline cdpRecord* octree_sorted_insert(cdpOctree* octree, cdpRecord* record, cdpCompare compare, void* context) {
-    CDP_NEW(cdpOctreeList, list);
-    cdp_record_transfer(record, &list->record);
-
-    cdpOctreeNode* onode = &octree->root;
-    unsigned depth = 1;
-    unsigned n;
-    do {
-        for (n = 0;  n < 8;  n++) {
-            if (onode->children[n]) {
-                if (0 < compare(&list->record, context, &onode->children[n]->bound)) {
-                    onode = onode->children[n];
-                    depth++;
-                    break;
-                }
-            } else {
-                cdpOctreeBound bound;
-                bound.subwide = onode->bound.subwide / 2.0f;
-                assert(bound.subwide > EPSILON);
-
-                switch (n) {
-                  case 0:   BOUND_CENTER_QUADRANT(bound, onode, +, +, +);   break;
-                  case 1:   BOUND_CENTER_QUADRANT(bound, onode, +, -, +);   break;
-                  case 2:   BOUND_CENTER_QUADRANT(bound, onode, -, -, +);   break;
-                  case 3:   BOUND_CENTER_QUADRANT(bound, onode, -, +, +);   break;
-                  case 4:   BOUND_CENTER_QUADRANT(bound, onode, +, +, -);   break;
-                  case 5:   BOUND_CENTER_QUADRANT(bound, onode, +, -, -);   break;
-                  case 6:   BOUND_CENTER_QUADRANT(bound, onode, -, -, -);   break;
-                  case 7:   BOUND_CENTER_QUADRANT(bound, onode, -, +, -);   break;
-                }
-
-                if (0 < compare(&list->record, context, &bound)) {
-                    onode->children[n] = octree_node_new(onode, &bound, n);
-                    onode = onode->children[n];
-                    depth++;
-                    break;
-                }
-            }
-        }
-    } while (n < 8);
-
-    // Insert list item
+static inline void octree_list_link(cdpOctreeNode* onode, cdpOctreeList* list) {
     list->onode = onode;
+    list->prev  = NULL;
     list->next  = onode->list;
     if (list->next)
         list->next->prev = list;
     onode->list = list;
+}
 
-    if (octree->depth < depth)
-        octree->depth = depth;
 
-    return &list->record;
+static inline void octree_list_unlink(cdpOctreeList* list) {
+    if (list->prev) {
+        list->prev->next = list->next;
+    } else {
+        list->onode->list = list->next;
+    }
+    if (list->next) {
+        list->next->prev = list->prev;
+    }
 }
 
 
-static inline cdpRecord* octree_first(cdpOctree* octree) {
-    cdpOctreeNode* onode = &octree->root;
-    for (;;) {
-        if (onode->list)
-            return &onode->list->record;
+static inline cdpOctreeNode* octree_child_for(cdpOctree* octree, cdpOctreeNode* onode, cdpRecord* record, cdpCompare compare, void* context) {
+    // Finds (or creates) the child quadrant that fully contains the record.
+    for (unsigned n = 0;  n < 8;  n++) {
+        if (onode->children[n]) {
+            if (0 < compare(record, context, &onode->children[n]->bound))
+                return onode->children[n];
+        } else {
+            cdpOctreeBound bound;
+            bound.subwide = onode->bound.subwide / 2.0f;
+            assert(bound.subwide > EPSILON);
+
+            switch (n) {
+              case 0:   BOUND_CENTER_QUADRANT(bound, onode, +, +, +);   break;
+              case 1:   BOUND_CENTER_QUADRANT(bound, onode, +, -, +);   break;
+              case 2:   BOUND_CENTER_QUADRANT(bound, onode, -, -, +);   break;
+              case 3:   BOUND_CENTER_QUADRANT(bound, onode, -, +, +);   break;
+              case 4:   BOUND_CENTER_QUADRANT(bound, onode, +, +, -);   break;
+              case 5:   BOUND_CENTER_QUADRANT(bound, onode, +, -, -);   break;
+              case 6:   BOUND_CENTER_QUADRANT(bound, onode, -, -, -);   break;
+              case 7:   BOUND_CENTER_QUADRANT(bound, onode, -, +, -);   break;
+            }
 
-        // Check children for a node with records
-        bool hasChildren = false;
-        for (unsigned n = 0;  n < 8;  n++) {
-            if (onode->children[n]) {
-                onode = onode->children[n];
-                hasChildren = true;
-                break;
+            if (0 < compare(record, context, &bound)) {
+                onode->children[n] = octree_node_new(octree, onode, &bound, n);
+                return onode->children[n];
             }
         }
-        if (!hasChildren)
-            break;
     }
-
     return NULL;
 }
 
 
-static inline cdpRecord* octree_last(cdpOctree* octree) {
-    cdpOctreeNode* onode = &octree->root;
-    cdpOctreeList* last  = NULL;
-    for (;;) {
-        // Find the last node in the current node's list
-        if (onode->list) {
-            for (last = onode->list;  last->next;  last = last->next);
+static inline void octree_node_split(cdpOctree* octree, cdpOctreeNode* onode, cdpCompare compare, void* context) {
+    // Pushes bucket records down to the quadrants fully containing them.
+    onode->split = true;
+    for (cdpOctreeList* list = onode->list, *next;  list;  list = next) {
+        next = list->next;
+        cdpOctreeNode* child = octree_child_for(octree, onode, &list->record, compare, context);
+        if (child) {
+            octree_list_unlink(list);
+            octree_list_link(child, list);
+            child->count++;
         }
+    }
+}
 
-        // Check children for deeper nodes
-        bool hasChildren = false;
-        for (int i = 7;  i >= 0;  i--) {    // Start from the last child.
-            if (onode->children[i]) {
-                onode = onode->children[i];
-                hasChildren = true;
+
+static inline cdpRecord* octree_sorted_insert(cdpOctree* octree, cdpRecord* record, cdpCompare compare, void* context) {
+    cdpOctreeList* list = octree_list_new(octree);
+    cdp_record_transfer(record, &list->record);
+
+    cdpOctreeNode* onode = &octree->root;
+    unsigned depth = 1;
+    for (;;) {
+        onode->count++;
+        if (!onode->split) {
+            if (onode->count <= octree->leafCap
+             || depth >= octree->maxDepth
+             || onode->bound.subwide / 2.0f <= EPSILON)
                 break;
-            }
+            octree_node_split(octree, onode, compare, context);
         }
-        if (!hasChildren) {
-            break;
+
+        cdpOctreeNode* child = octree_child_for(octree, onode, &list->record, compare, context);
+        if (!child)
+            break;      // Doesn't fit in any quadrant: it stays here.
+        onode = child;
+        depth++;
+    }
+
+    octree_list_link(onode, list);
+
+    if (octree->depth < depth + 1)
+        octree->depth = depth + 1;      // Split buckets may have pushed records one level down.
+
+    return &list->record;
+}
+
+
+static inline cdpOctreeNode* octree_node_next(cdpOctreeNode* onode) {
+    // Next node in pre-order: the first child, or else the next sibling of the nearest ancestor.
+    for (unsigned n = 0;  n < 8;  n++) {
+        if (onode->children[n])
+            return onode->children[n];
+    }
+    for (;  onode->parent;  onode = onode->parent) {
+        for (unsigned n = onode->index + 1;  n < 8;  n++) {
+            if (onode->parent->children[n])
+                return onode->parent->children[n];
         }
     }
+    return NULL;
+}
+
+
+static inline cdpOctreeNode* octree_node_last(cdpOctreeNode* onode) {
+    // Last node of a subtree in pre-order.
+    for (;;) {
+        int n = 7;
+        while (n >= 0  &&  !onode->children[n])
+            n--;
+        if (n < 0)
+            return onode;
+        onode = onode->children[n];
+    }
+}
+
+
+static inline cdpOctreeNode* octree_node_prev(cdpOctreeNode* onode) {
+    // Previous node in pre-order: the last one under the previous sibling, or else the parent.
+    if (!onode->parent)
+        return NULL;
+    for (int n = (int)onode->index - 1;  n >= 0;  n--) {
+        if (onode->parent->children[n])
+            return octree_node_last(onode->parent->children[n]);
+    }
+    return onode->parent;
+}
+
+
+static inline cdpRecord* octree_first(cdpOctree* octree) {
+    for (cdpOctreeNode* onode = &octree->root;  onode;  onode = octree_node_next(onode)) {
+        if (onode->list)
+            return &onode->list->record;
+    }
+    return NULL;
+}
 
-    return last? &last->record: NULL;
+
+static inline cdpRecord* octree_last(cdpOctree* octree) {
+    for (cdpOctreeNode* onode = octree_node_last(&octree->root);  onode;  onode = octree_node_prev(onode)) {
+        if (onode->list) {
+            cdpOctreeList* last = onode->list;
+            while (last->next)
+                last = last->next;
+            return &last->record;
+        }
+    }
+    return NULL;
 }
 
 
 static inline bool octree_traverse(cdpOctree* octree, cdpTraverse func, void* context, cdpEntry* entry) {
     assert(octree && func);
 
-    cdpOctreeNode* onode = &octree->root;
-
     entry->parent = octree->store.owner;
     entry->depth  = 0;
-    do {
-        // Process all records in the current node
+    for (cdpOctreeNode* onode = &octree->root;  onode;  onode = octree_node_next(onode)) {
         for (cdpOctreeList* list = onode->list;  list;  list = list->next) {
             if (entry->next) {
                 entry->prev   = entry->record;
                 entry->record = entry->next;
                 entry->next   = &list->record;
                 if (!func(entry, context))
-                    return true;
+                    return false;
+                entry->position++;
             } else {
                 entry->next = &list->record;
             }
-            entry->position++;
-        }
-
-        // Move to the first child node if available
-        bool hasChild = false;
-        for (unsigned n = 0;  n < 8;  n++) {
-            if (onode->children[n]) {
-                onode = onode->children[n];
-                hasChild = true;
-                break;
-            }
-        }
-        if (!hasChild) {
-            // Backtrack to the next sibling or parent
-            while (onode && onode->parent) {
-                unsigned n = onode->index + 1;
-                while (n < 8  &&  !onode->parent->children[n]) {
-                    n++;
-                }
-                if (n < 8) {
-                    onode = onode->parent->children[n];
-                    break;
-                }
-
-                onode = onode->parent;
-            }
         }
-    } while (onode);
+    }
 
     entry->prev   = entry->record;
     entry->record = entry->next;
@@ -288,9 +347,12 @@ static inline bool octree_traverse(cdpOctree* octree, cdpTraverse func, void* co
 
 
 static inline cdpRecord* octree_find_by_name(cdpOctree* octree, const cdpDT* name) {
-    cdpEntry entry = {0};
-    if (!octree_traverse(octree, (cdpFunc) rb_traverse_func_break_at_name, cdp_v2p(name), &entry))
-        return entry.record;
+    for (cdpOctreeNode* onode = &octree->root;  onode;  onode = octree_node_next(onode)) {
+        for (cdpOctreeList* list = onode->list;  list;  list = list->next) {
+            if (cdp_record_name_is(&list->record, name))
+                return &list->record;
+        }
+    }
     return NULL;
 }
 
@@ -316,43 +378,15 @@ static inline cdpRecord* octree_prev(cdpRecord* record) {
     if (list->prev)
         return &list->prev->record;
 
-    // Find the previous sibling node or parent with records
-    cdpOctreeNode* onode = list->onode;
-    while (onode) {
-        unsigned index = onode->index;
-        onode = onode->parent;
-        if (!onode)
-            break; // Root node reached.
-
-        for (int i = (int)index - 1;  i >= 0;  i--) {
-            if (onode->children[i]) {
-                cdpOctreeNode* sibling = onode->children[i];
-                while (sibling) {
-                    // Find the last record in this subtree
-                    if (sibling->list) {
-                        cdpOctreeList* last = sibling->list;
-                        while (last->next) {
-                            last = last->next;
-                        }
-                        return &last->record;
-                    }
-
-                    // Descend into the last child node
-                    bool hasChildren = false;
-                    for (int j = 7;  j >= 0;  j--) {
-                        if (sibling->children[j]) {
-                            sibling = sibling->children[j];
-                            hasChildren = true;
-                            break;
-                        }
-                    }
-                    if (!hasChildren)
-                        break;
-                }
-            }
+    // Follow the traversal order back to the previous node with records.
+    for (cdpOctreeNode* onode = octree_node_prev(list->onode);  onode;  onode = octree_node_prev(onode)) {
+        if (onode->list) {
+            cdpOctreeList* last = onode->list;
+            while (last->next)
+                last = last->next;
+            return &last->record;
         }
     }
-
     return NULL;
 }
 
@@ -362,79 +396,60 @@ static inline cdpRecord* octree_next(cdpRecord* record) {
     if (list->next)
         return &list->next->record;
 
-    // Find the next sibling node or parent with records
-    cdpOctreeNode* onode = list->onode;
-    while (onode) {
-        for (unsigned n = onode->index + 1;  n < 8;  n++) {
-            if (onode->parent->children[n]) {
-                cdpOctreeNode* next = onode->parent->children[n];
-                while (next) {
-                    if (next->list)
-                        return &next->list->record;
-
-                    bool hasChildren = false;
-                    for (unsigned m = 0;  m < 8;  m++) {
-                        if (next->children[m]) {
-                            next = next->children[m];
-                            hasChildren = true;
-                            break;
-                        }
-                    }
-                    if (!hasChildren)
-                        break;
-                }
-            }
-        }
-
-        onode = onode->parent;
+    // Follow the traversal order to the next node with records.
+    for (cdpOctreeNode* onode = octree_node_next(list->onode);  onode;  onode = octree_node_next(onode)) {
+        if (onode->list)
+            return &onode->list->record;
     }
-
     return NULL;
 }
 
 
+static inline void octree_node_gather(cdpOctree* octree, cdpOctreeNode* onode, cdpOctreeNode* target) {
+    // Moves all records below onode into target, releasing the nodes.
+    for (unsigned n = 0;  n < 8;  n++) {
+        cdpOctreeNode* child = onode->children[n];
+        if (!child)
+            continue;
+        octree_node_gather(octree, child, target);
+        for (cdpOctreeList* list = child->list, *next;  list;  list = next) {
+            next = list->next;
+            octree_list_link(target, list);
+        }
+        octree_node_del(octree, child);
+        onode->children[n] = NULL;
+    }
+}
+
+
 static inline void octree_remove_record(cdpOctree* octree, cdpRecord* record) {
     cdpOctreeList* list  = octree_list_from_record(record);
     cdpOctreeNode* onode = list->onode;
 
-    // Remove list item
-    if (list->prev) {
-        list->prev->next = list->next;
-    } else {
-        list->onode->list = list->next;
-    }
-    if (list->next) {
-        list->next->prev = list->prev;
-    }
-
-    cdp_free(list);
+    octree_list_unlink(list);
+    octree_list_del(octree, list);
 
-    // Remove empty nodes
-    for(;;) {
-        if (onode->list)
-            break;
-
-        bool hasChildren = false;
-        for (unsigned n = 0;  n < 8;  n++) {
-            if (onode->children[n]) {
-                hasChildren = true;
-                break;
-            }
+    // Find the highest split node now holding few enough records to be a leaf again.
+    cdpOctreeNode* merge = NULL;
+    for (cdpOctreeNode* node = onode;  node;  node = node->parent) {
+        node->count--;
+        if (node->count <= (octree->leafCap >> 1)) {
+            if (node->split)
+                merge = node;
         }
-        if (hasChildren)
-            break;
+    }
 
-        // If the node is empty, remove it
-        cdpOctreeNode* parent = onode->parent;
-        if (parent) {
-            parent->children[onode->index] = NULL;
-            cdp_free(onode);
-            onode = parent;
-        } else {
-            octree->depth = 1;
-            break;
-        }
+    if (merge) {
+        octree_node_gather(octree, merge, merge);
+        merge->split = false;
+    } else if (!onode->split  &&  !onode->count  &&  onode->parent) {
+        // Drop the empty leaf.
+        onode->parent->children[onode->index] = NULL;
+        octree_node_del(octree, onode);
     }
+
+    if (!octree->root.count)
+        octree->depth = 1;
 }
 
 
@@ -452,48 +467,306 @@ static inline void octree_pop(cdpOctree* octree, cdpRecord* target) {
 }
 
 
-#define OCTREE_MIN_DEPTH    128
-
 static inline void octree_del_all_children(cdpOctree* octree) {
-    size_t      stackSize = octree->depth * sizeof(void*);
-    cdpOctreeNode** stack = (octree->depth > OCTREE_MIN_DEPTH)? cdp_malloc(stackSize): cdp_alloca(stackSize);
-    unsigned          top = 0;
+    // Finalize records and return every node and list item to its free list.
+    octree_node_gather(octree, &octree->root, &octree->root);
+    for (cdpOctreeList* list = octree->root.list, *next;  list;  list = next) {
+        next = list->next;
+        cdp_record_finalize(&list->record);
+        octree_list_del(octree, list);
+    }
+    octree->root.list  = NULL;
+    octree->root.count = 0;
+    octree->root.split = false;
+    octree->depth = 1;
+}
 
-    // Push all root's children onto the stack
-    for (unsigned n = 0;  n < 8;  n++) {
-        if (octree->root.children[n]) {
-            stack[top++] = octree->root.children[n];
-            octree->root.children[n] = NULL;
+
+
+
+/*
+    Spatial queries
+*/
+
+typedef struct {
+    cdpSpatialLocate    locate;         // Gets the bounding sphere of each child.
+    cdpSpatialFunc      func;           // Receives each hit.
+    void*               context;
+    //
+    float               point[3];       // Box min, sphere center or ray origin.
+    float               vector[3];      // Box max or ray direction.
+    float               radius;         // Sphere radius or ray length.
+} cdpOctreeQuery;
+
+typedef struct {
+    cdpSpatialLocate    locate;
+    void*               context;
+    float               point[3];       // Query point.
+    //
+    size_t              k;              // Maximum neighbours wanted.
+    size_t              count;          // Neighbours found so far.
+    cdpRecord**         record;         // Max-heap (on distance) of the nearest records.
+    float*              distance;
+} cdpOctreeNearest;
+
+
+static inline float octree_box_distance2(const float min[3], const float max[3], const float point[3]) {
+    float d2 = 0.0f;
+    for (unsigned i = 0;  i < 3;  i++) {
+        float d = (point[i] < min[i])?  min[i] - point[i]:  (point[i] > max[i])?  point[i] - max[i]:  0.0f;
+        d2 += d * d;
+    }
+    return d2;
+}
+
+
+static inline float octree_node_distance2(const cdpOctreeNode* onode, const float point[3]) {
+    float d2 = 0.0f;
+    for (unsigned i = 0;  i < 3;  i++) {
+        float d = fabsf(point[i] - onode->bound.center[i]) - onode->bound.subwide;
+        if (d > 0.0f)
+            d2 += d * d;
+    }
+    return d2;
+}
+
+
+static inline float octree_point_distance(const float a[3], const float b[3]) {
+    float dx = a[0] - b[0],  dy = a[1] - b[1],  dz = a[2] - b[2];
+    return sqrtf(dx*dx + dy*dy + dz*dz);
+}
+
+
+static inline bool octree_query_box_node(cdpOctreeNode* onode, cdpOctreeQuery* query) {
+    // Records in the root may lie outside its bound, so it's never pruned.
+    if (onode->parent) {
+        for (unsigned i = 0;  i < 3;  i++) {
+            if (onode->bound.center[i] + onode->bound.subwide < query->point[i]
+             || onode->bound.center[i] - onode->bound.subwide > query->vector[i])
+                return true;
         }
     }
 
-    // Delete all child nodes
-    while (top > 0) {
-        cdpOctreeNode* onode = stack[--top];
+    for (cdpOctreeList* list = onode->list;  list;  list = list->next) {
+        float center[3], radius = 0.0f;
+        query->locate(&list->record, query->context, center, &radius);
+        if (octree_box_distance2(query->point, query->vector, center) <= radius * radius
+         && !query->func(&list->record, 0.0f, query->context))
+            return false;
+    }
+
+    for (unsigned n = 0;  n < 8;  n++) {
+        if (onode->children[n] && !octree_query_box_node(onode->children[n], query))
+            return false;
+    }
+    return true;
+}
+
 
-        // Free all records in this node
-        cdpOctreeList* list = onode->list;
-        while (list) {
-            cdpOctreeList* next = list->next;
-            cdp_record_finalize(&list->record);
-            cdp_free(list);
-            list = next;
+static inline bool octree_query_box(cdpOctree* octree, const float min[3], const float max[3], cdpSpatialLocate locate, cdpSpatialFunc func, void* context) {
+    cdpOctreeQuery query = {.locate = locate, .func = func, .context = context};
+    memcpy(query.point,  min, sizeof(query.point));
+    memcpy(query.vector, max, sizeof(query.vector));
+    return octree_query_box_node(&octree->root, &query);
+}
+
+
+static inline bool octree_query_sphere_node(cdpOctreeNode* onode, cdpOctreeQuery* query) {
+    if (onode->parent  &&  octree_node_distance2(onode, query->point) > query->radius * query->radius)
+        return true;
+
+    for (cdpOctreeList* list = onode->list;  list;  list = list->next) {
+        float center[3], radius = 0.0f;
+        query->locate(&list->record, query->context, center, &radius);
+        float distance = octree_point_distance(center, query->point) - radius;
+        if (distance <= query->radius
+         && !query->func(&list->record, cdp_max(distance, 0.0f), query->context))
+            return false;
+    }
+
+    for (unsigned n = 0;  n < 8;  n++) {
+        if (onode->children[n] && !octree_query_sphere_node(onode->children[n], query))
+            return false;
+    }
+    return true;
+}
+
+
+static inline bool octree_query_sphere(cdpOctree* octree, const float center[3], float radius, cdpSpatialLocate locate, cdpSpatialFunc func, void* context) {
+    cdpOctreeQuery query = {.locate = locate, .func = func, .context = context, .radius = radius};
+    memcpy(query.point, center, sizeof(query.point));
+    return octree_query_sphere_node(&octree->root, &query);
+}
+
+
+static inline bool octree_ray_hits_node(const cdpOctreeNode* onode, const cdpOctreeQuery* query, float* near) {
+    // Slab test of the ray segment against the node cube.
+    float t0 = 0.0f, t1 = query->radius;
+    for (unsigned i = 0;  i < 3;  i++) {
+        float min = onode->bound.center[i] - onode->bound.subwide;
+        float max = onode->bound.center[i] + onode->bound.subwide;
+        if (fabsf(query->vector[i]) < EPSILON) {
+            if (query->point[i] < min  ||  query->point[i] > max)
+                return false;
+        } else {
+            float inv = 1.0f / query->vector[i];
+            float ta = (min - query->point[i]) * inv;
+            float tb = (max - query->point[i]) * inv;
+            if (ta > tb) {float t = ta;  ta = tb;  tb = t;}
+            if (ta > t0) t0 = ta;
+            if (tb < t1) t1 = tb;
+            if (t0 > t1)
+                return false;
         }
+    }
+    *near = t0;
+    return true;
+}
+
+
+static inline bool octree_ray_hits_sphere(const cdpOctreeQuery* query, const float center[3], float radius, float* t) {
+    float oc[3] = {query->point[0] - center[0],  query->point[1] - center[1],  query->point[2] - center[2]};
+    const float* d = query->vector;
+    float a = d[0]*d[0] + d[1]*d[1] + d[2]*d[2];
+    float b = oc[0]*d[0] + oc[1]*d[1] + oc[2]*d[2];
+    float c = oc[0]*oc[0] + oc[1]*oc[1] + oc[2]*oc[2] - radius*radius;
+    float disc = b*b - a*c;
+    if (disc < 0.0f)
+        return false;
+    float root = sqrtf(disc);
+    float tin  = (-b - root) / a;
+    float tout = (-b + root) / a;
+    if (tout < 0.0f  ||  tin > query->radius)
+        return false;
+    *t = cdp_max(tin, 0.0f);       // Zero if the origin is inside.
+    return true;
+}
+
+
+static inline bool octree_query_ray_node(cdpOctreeNode* onode, cdpOctreeQuery* query) {
+    for (cdpOctreeList* list = onode->list;  list;  list = list->next) {
+        float center[3], radius = 0.0f, t;
+        query->locate(&list->record, query->context, center, &radius);
+        if (octree_ray_hits_sphere(query, center, radius, &t)
+         && !query->func(&list->record, t, query->context))
+            return false;
+    }
 
-        // Push all children of the current node onto the stack
-        for (unsigned n = 0;  n < 8;  n++) {
-            if (onode->children[n]) {
-                stack[top++] = onode->children[n];
-                onode->children[n] = NULL;
+    // Visit crossed quadrants front to back.
+    cdpOctreeNode* child[8];
+    float near[8];
+    unsigned count = 0;
+    for (unsigned n = 0;  n < 8;  n++) {
+        float t;
+        if (onode->children[n] && octree_ray_hits_node(onode->children[n], query, &t)) {
+            unsigned i = count++;
+            for (;  i && near[i - 1] > t;  i--) {
+                child[i] = child[i - 1];
+                near[i]  = near[i - 1];
             }
+            child[i] = onode->children[n];
+            near[i]  = t;
         }
+    }
+    for (unsigned i = 0;  i < count;  i++) {
+        if (!octree_query_ray_node(child[i], query))
+            return false;
+    }
+    return true;
+}
+
+
+static inline bool octree_query_ray(cdpOctree* octree, const float origin[3], const float direction[3], float length, cdpSpatialLocate locate, cdpSpatialFunc func, void* context) {
+    cdpOctreeQuery query = {.locate = locate, .func = func, .context = context, .radius = length};
+    memcpy(query.point,  origin,    sizeof(query.point));
+    memcpy(query.vector, direction, sizeof(query.vector));
+    assert(query.vector[0] || query.vector[1] || query.vector[2]);
+    return octree_query_ray_node(&octree->root, &query);
+}
+
 
-        cdp_free(onode);
+static inline void octree_nearest_sift_down(cdpOctreeNearest* nearest, size_t i, size_t count, cdpRecord* record, float distance) {
+    for (;;) {
+        size_t child = (i << 1) + 1;
+        if (child >= count)
+            break;
+        if (child + 1 < count  &&  nearest->distance[child + 1] > nearest->distance[child])
+            child++;
+        if (nearest->distance[child] <= distance)
+            break;
+        nearest->record[i]   = nearest->record[child];
+        nearest->distance[i] = nearest->distance[child];
+        i = child;
     }
+    nearest->record[i]   = record;
+    nearest->distance[i] = distance;
+}
 
-    if (octree->depth > OCTREE_MIN_DEPTH)
-        cdp_free(stack);
 
-    octree->depth = 1;
+static inline void octree_nearest_push(cdpOctreeNearest* nearest, cdpRecord* record, float distance) {
+    if (nearest->count < nearest->k) {
+        size_t i = nearest->count++;
+        while (i) {
+            size_t parent = (i - 1) >> 1;
+            if (nearest->distance[parent] >= distance)
+                break;
+            nearest->record[i]   = nearest->record[parent];
+            nearest->distance[i] = nearest->distance[parent];
+            i = parent;
+        }
+        nearest->record[i]   = record;
+        nearest->distance[i] = distance;
+    } else if (distance < nearest->distance[0]) {
+        octree_nearest_sift_down(nearest, 0, nearest->count, record, distance);
+    }
 }
 
+
+static inline void octree_nearest_node(cdpOctreeNode* onode, cdpOctreeNearest* nearest) {
+    for (cdpOctreeList* list = onode->list;  list;  list = list->next) {
+        float center[3], radius = 0.0f;
+        nearest->locate(&list->record, nearest->context, center, &radius);
+        float distance = octree_point_distance(center, nearest->point) - radius;
+        octree_nearest_push(nearest, &list->record, cdp_max(distance, 0.0f));
+    }
+
+    // Descend into closer quadrants first, so farther ones get pruned.
+    cdpOctreeNode* child[8];
+    float dist2[8];
+    unsigned count = 0;
+    for (unsigned n = 0;  n < 8;  n++) {
+        if (onode->children[n]) {
+            float d2 = octree_node_distance2(onode->children[n], nearest->point);
+            unsigned i = count++;
+            for (;  i && dist2[i - 1] > d2;  i--) {
+                child[i] = child[i - 1];
+                dist2[i] = dist2[i - 1];
+            }
+            child[i] = onode->children[n];
+            dist2[i] = d2;
+        }
+    }
+    for (unsigned i = 0;  i < count;  i++) {
+        if (nearest->count == nearest->k  &&  sqrtf(dist2[i]) >= nearest->distance[0])
+            break;
+        octree_nearest_node(child[i], nearest);
+    }
+}
+
+
+static inline size_t octree_query_nearest(cdpOctree* octree, const float point[3], size_t k, cdpSpatialLocate locate, void* context, cdpRecord** record, float* distance) {
+    cdpOctreeNearest nearest = {.locate = locate, .context = context, .k = k, .record = record, .distance = distance};
+    memcpy(nearest.point, point, sizeof(nearest.point));
+    octree_nearest_node(&octree->root, &nearest);
+
+    // Heap sort, leaving results in ascending distance.
+    for (size_t end = nearest.count;  end > 1;  ) {
+        end--;
+        cdpRecord* last = record[end];
+        float    lastD  = distance[end];
+        record[end]   = record[0];
+        distance[end] = distance[0];
+        octree_nearest_sift_down(&nearest, 0, end, last, lastD);
+    }
+    return nearest.count;
+}
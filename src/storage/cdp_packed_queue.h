@@ -37,10 +37,29 @@ typedef struct {
     cdpStore        store;      // Parent info.
     //
     size_t          pSize;      // Pack (node) size in bytes.
+    size_t          pChunk;     // Node allocation size (a power of two, which is also its alignment).
     cdpPackedQNode* pHead;      // Head of the buffer list.
     cdpPackedQNode* pTail;      // Tail of the buffer list.
+    //
+    cdpPackedQNode* pSpare;     // Drained nodes kept for re-use (linked by pNext).
+    unsigned        spares;     // Number of spare nodes.
+    bool            shared;     // Spare nodes overflow to (and are taken from) the shared pool.
+    cdpChunkStats   stats;      // Node recycling counters.
 } cdpPackedQ;
 
+typedef struct {
+    cdpPackedQNode* free;       // Idle nodes of this size (linked by pNext).
+    size_t          count;      // Number of idle nodes.
+} cdpPackedQPool;
+
+
+#define PACKED_Q_MAX_SPARES     2       // Spare nodes kept by each queue.
+#define PACKED_Q_POOL_CLASSES   32      // One shared pool per (power of two) node size.
+#define PACKED_Q_POOL_LIMIT     64      // Idle nodes kept by each shared pool.
+
+static cdpPackedQPool PACKED_Q_POOL[PACKED_Q_POOL_CLASSES];     // Shared pools (as the rest of records, these aren't thread safe).
+static cdpChunkStats  PACKED_Q_TOTALS;                          // Counters for all queues.
+
 
 
 
@@ -48,24 +67,118 @@ typedef struct {
     Packed Queue implementation
 */
 
-static inline cdpPackedQ* packed_q_new(int capacity) {
-    CDP_NEW(cdpPackedQ, pkdq);
-    pkdq->pSize = capacity * sizeof(cdpRecord);
+static inline cdpPackedQ* packed_q_new(size_t capacity) {
+    SLAB_TRY_NEW(cdpPackedQ, pkdq);
+    if CDP_RARELY(!pkdq)
+        return NULL;
+    // Nodes are aligned to their (power of two) size, so the owner node
+    // of any record is found by masking its address. The buffer takes
+    // whatever is left of the node after its header.
+    pkdq->pChunk = cdp_next_pow_of_two(sizeof(cdpPackedQNode) + (capacity * sizeof(cdpRecord)));
+    pkdq->pSize  = ((pkdq->pChunk - sizeof(cdpPackedQNode)) / sizeof(cdpRecord)) * sizeof(cdpRecord);
     return pkdq;
 }
 
 
-#define packed_q_del              cdp_free
-#define packed_q_node_new(pkdq)   cdp_malloc0(sizeof(cdpPackedQNode) + (pkdq)->pSize)
 #define packed_q_node_del         cdp_free
+#define packed_q_pool_of(chunk)   (&PACKED_Q_POOL[cdp_ctz(chunk)])
+
+
+static inline cdpPackedQNode* packed_q_node_new(cdpPackedQ* pkdq) {
+    cdpPackedQNode* pNode;
+    cdpPackedQPool* pool = packed_q_pool_of(pkdq->pChunk);
+    if (pkdq->pSpare) {
+        pNode = pkdq->pSpare;
+        pkdq->pSpare = pNode->pNext;
+        pkdq->spares--;
+        pkdq->stats.recycled++;
+        PACKED_Q_TOTALS.recycled++;
+    } else if (pkdq->shared  &&  pool->free) {
+        pNode = pool->free;
+        pool->free = pNode->pNext;
+        pool->count--;
+        pkdq->stats.recycled++;
+        PACKED_Q_TOTALS.recycled++;
+        PACKED_Q_TOTALS.spare--;
+    } else {
+        pNode = cdp_try_aligned_alloc(pkdq->pChunk, pkdq->pChunk);
+        if CDP_RARELY(!pNode)
+            return NULL;
+        pkdq->stats.allocated++;
+        PACKED_Q_TOTALS.allocated++;
+    }
+    CDP_0(pNode);
+    return pNode;
+}
 
 
-static inline cdpPackedQNode* packed_q_node_from_record(cdpPackedQ* pkdq, cdpRecord* record) {
-    for (cdpPackedQNode* pNode = pkdq->pHead;  pNode;  pNode = pNode->pNext) {
-        if (pNode->first <= record  &&  pNode->last >= record)
-            return pNode;
+static inline void packed_q_node_release(cdpPackedQ* pkdq, cdpPackedQNode* pNode) {
+    if (pkdq->spares < PACKED_Q_MAX_SPARES) {
+        pNode->pNext = pkdq->pSpare;
+        pkdq->pSpare = pNode;
+        pkdq->spares++;
+        return;
+    }
+    cdpPackedQPool* pool = packed_q_pool_of(pkdq->pChunk);
+    if (pkdq->shared  &&  pool->count < PACKED_Q_POOL_LIMIT) {
+        pNode->pNext = pool->free;
+        pool->free = pNode;
+        pool->count++;
+        PACKED_Q_TOTALS.spare++;
+        return;
+    }
+    pkdq->stats.released++;
+    PACKED_Q_TOTALS.released++;
+    packed_q_node_del(pNode);
+}
+
+
+static inline void packed_q_del(cdpPackedQ* pkdq) {
+    cdpPackedQNode* pNode = pkdq->pSpare, *next;
+    pkdq->pSpare = NULL;
+    pkdq->spares = PACKED_Q_MAX_SPARES;     // So spares are passed on to the shared pool (or the heap).
+    for (;  pNode;  pNode = next) {
+        next = pNode->pNext;
+        packed_q_node_release(pkdq, pNode);
+    }
+    slab_del_item(cdpPackedQ, pkdq);
+}
+
+
+static inline void packed_q_pool_flush(void) {
+    for (unsigned n = 0;  n < PACKED_Q_POOL_CLASSES;  n++) {
+        cdpPackedQPool* pool = &PACKED_Q_POOL[n];
+        while (pool->free) {
+            cdpPackedQNode* pNode = pool->free;
+            pool->free = pNode->pNext;
+            packed_q_node_del(pNode);
+            PACKED_Q_TOTALS.released++;
+        }
+        pool->count = 0;
+    }
+    PACKED_Q_TOTALS.spare = 0;
+}
+
+
+static inline cdpPackedQNode* packed_q_node_from_record(cdpPackedQ* pkdq, const cdpRecord* record) {
+    return (cdpPackedQNode*)((uintptr_t)record & ~(uintptr_t)(pkdq->pChunk - 1));
+}
+
+
+static inline void packed_q_node_unlink(cdpPackedQ* pkdq, cdpPackedQNode* pNode) {
+    if (pNode->pNext)   pNode->pNext->pPrev = pNode->pPrev;
+    else                pkdq->pTail = pNode->pPrev;
+    if (pNode->pPrev)   pNode->pPrev->pNext = pNode->pNext;
+    else                pkdq->pHead = pNode->pNext;
+    packed_q_node_release(pkdq, pNode);
+}
+
+
+static inline void packed_q_relink_records(cdpRecord* record, cdpRecord* last) {
+    for (;  record <= last;  record++) {
+        if (!cdp_record_is_link(record) && record->store)
+            cdp_record_relink_storage(record);
     }
-    return NULL;
 }
 
 
@@ -78,6 +191,8 @@ static inline cdpRecord* packed_q_append(cdpPackedQ* pkdq, cdpRecord* record, bo
                 pkdq->pHead->first--;
             } else {
                 cdpPackedQNode* pNode = packed_q_node_new(pkdq);
+                if CDP_RARELY(!pNode)
+                    return NULL;
                 pNode->first = pNode->last = cdp_ptr_off(pNode->record, pkdq->pSize - sizeof(cdpRecord));
                 pNode->pNext = pkdq->pHead;
                 pkdq->pHead->pPrev = pNode;
@@ -89,6 +204,8 @@ static inline cdpRecord* packed_q_append(cdpPackedQ* pkdq, cdpRecord* record, bo
                 pkdq->pTail->last++;
             } else {
                 cdpPackedQNode* pNode = packed_q_node_new(pkdq);
+                if CDP_RARELY(!pNode)
+                    return NULL;
                 pNode->last  = pNode->first = pNode->record;
                 pNode->pPrev = pkdq->pTail;
                 pkdq->pTail->pNext = pNode;
@@ -99,6 +216,8 @@ static inline cdpRecord* packed_q_append(cdpPackedQ* pkdq, cdpRecord* record, bo
     } else {
         assert(!pkdq->pTail);
         cdpPackedQNode* pNode = packed_q_node_new(pkdq);
+        if CDP_RARELY(!pNode)
+            return NULL;
         pNode->last = pNode->first = pNode->record;
         pkdq->pTail = pkdq->pHead = pNode;
         child = pNode->last;
@@ -144,31 +263,45 @@ static inline cdpRecord* packed_q_find_by_position(cdpPackedQ* pkdq, size_t posi
 }
 
 
+static inline size_t packed_q_index_of(cdpPackedQ* pkdq, const cdpRecord* record) {
+    size_t index = 0;
+    for (cdpPackedQNode* pNode = pkdq->pHead;  pNode;  pNode = pNode->pNext) {
+        if (pNode->first <= record  &&  pNode->last >= record)
+            return index + (size_t)(record - pNode->first);
+        index += cdp_ptr_idx(pNode->first, pNode->last, sizeof(cdpRecord)) + 1;
+    }
+    assert(!pkdq);     // Record not in queue.
+    return index;
+}
+
+
 static inline cdpRecord* packed_q_prev(cdpPackedQ* pkdq, cdpRecord* record) {
     cdpPackedQNode* pNode = packed_q_node_from_record(pkdq, record);
-    assert(pNode);
-    if (pNode->first == record)
-        return NULL;
-    return record - 1;
+    assert(pNode->first <= record  &&  record <= pNode->last);
+    if (pNode->first < record)
+        return record - 1;
+    return pNode->pPrev? pNode->pPrev->last: NULL;
 }
 
 
 static inline cdpRecord* packed_q_next(cdpPackedQ* pkdq, cdpRecord* record) {
     cdpPackedQNode* pNode = packed_q_node_from_record(pkdq, record);
-    assert(pNode);
-    if (pNode->last == record)
-        return NULL;
-    return record + 1;
+    assert(pNode->first <= record  &&  record <= pNode->last);
+    if (pNode->last > record)
+        return record + 1;
+    return pNode->pNext? pNode->pNext->first: NULL;
 }
 
 
-static inline cdpRecord* packed_q_next_by_name(cdpPackedQ* pkdq, cdpDT* name, cdpPackedQNode** prev) {
-    for (cdpPackedQNode* pNode = prev? (*prev)->pNext: pkdq->pHead;  pNode;  pNode = pNode->pNext) {
-        for (cdpRecord* record = pNode->first;  record <= pNode->last;  record++) {
-            if (cdp_record_name_is(record, name))
-                return record;
+static inline cdpRecord* packed_q_next_by_name(cdpPackedQ* pkdq, cdpDT* name, uintptr_t* prev) {
+    cdpRecord* record = *prev?  packed_q_next(pkdq, (cdpRecord*)*prev):  pkdq->pHead->first;
+    for (;  record;  record = packed_q_next(pkdq, record)) {
+        if (cdp_record_name_is(record, name)) {
+            *prev = (uintptr_t)record;
+            return record;
         }
     }
+    *prev = 0;
     return NULL;
 }
 
@@ -200,17 +333,10 @@ static inline void packed_q_take(cdpPackedQ* pkdq, cdpRecord* target) {
     cdpRecord* last = pkdq->pTail->last;
     cdp_record_transfer(last, target);
     pkdq->pTail->last--;
-    if (pkdq->pTail->last >= pkdq->pTail->first) {
+    if (pkdq->pTail->last >= pkdq->pTail->first)
         CDP_0(last);
-    } else {
-        cdpPackedQNode* pNode = pkdq->pTail;
-        pkdq->pTail = pkdq->pTail->pPrev;
-        if (pkdq->pTail)
-            pkdq->pTail->pNext = NULL;
-        else
-            pkdq->pHead = NULL;
-        packed_q_node_del(pNode);
-    }
+    else
+        packed_q_node_unlink(pkdq, pkdq->pTail);
 }
 
 
@@ -218,30 +344,38 @@ static inline void packed_q_pop(cdpPackedQ* pkdq, cdpRecord* target) {
     cdpRecord* first = pkdq->pHead->first;
     cdp_record_transfer(first, target);
     pkdq->pHead->first++;
-    if (pkdq->pHead->first <= pkdq->pHead->last) {
+    if (pkdq->pHead->first <= pkdq->pHead->last)
         CDP_0(first);
-    } else {
-        cdpPackedQNode* pNode = pkdq->pHead;
-        pkdq->pHead = pkdq->pHead->pNext;
-        if (pkdq->pHead)
-            pkdq->pHead->pPrev = NULL;
-        else
-            pkdq->pTail = NULL;
-        packed_q_node_del(pNode);       //ToDo: keep last node for re-use.
-    }
+    else
+        packed_q_node_unlink(pkdq, pkdq->pHead);
 }
 
 
 static inline void packed_q_remove_record(cdpPackedQ* pkdq, cdpRecord* record) {
-    cdpRecord dummy;
-    if (record == pkdq->pHead->first) {
-        packed_q_pop(pkdq, &dummy);
-    } else if (record == pkdq->pTail->last) {
-        packed_q_take(pkdq, &dummy);
+    cdpPackedQNode* pNode = packed_q_node_from_record(pkdq, record);
+    assert(pNode->first <= record  &&  record <= pNode->last);
+
+    // Close the gap by moving the shorter side of the node.
+    if ((record - pNode->first) < (pNode->last - record)) {
+        if (record > pNode->first) {
+            memmove(pNode->first + 1, pNode->first, (size_t)(record - pNode->first) * sizeof(cdpRecord));
+            cdp_record_moved(pNode->first + 1, pNode->first, (size_t)(record - pNode->first));
+            packed_q_relink_records(pNode->first + 1, record);
+        }
+        CDP_0(pNode->first);
+        pNode->first++;
     } else {
-        // Only removing first/last is allowed for this.
-        assert(record == pkdq->pHead->first || record == pkdq->pTail->last);
+        if (record < pNode->last) {
+            memmove(record, record + 1, (size_t)(pNode->last - record) * sizeof(cdpRecord));
+            cdp_record_moved(record, record + 1, (size_t)(pNode->last - record));
+            packed_q_relink_records(record, pNode->last - 1);
+        }
+        CDP_0(pNode->last);
+        pNode->last--;
     }
+
+    if (pNode->first > pNode->last)
+        packed_q_node_unlink(pkdq, pNode);
 }
 
 
@@ -254,7 +388,7 @@ static inline void packed_q_del_all_children(cdpPackedQ* pkdq) {
             }
             toDel = pNode;
             pNode = pNode->pNext;
-            packed_q_node_del(toDel);
+            packed_q_node_release(pkdq, toDel);
         } while (pNode);
         pkdq->pHead = pkdq->pTail = NULL;
     }
@@ -28,6 +28,7 @@ struct _cdpRbTreeNode {
     cdpRbTreeNode*  left;         // Left node.
     cdpRbTreeNode*  right;        // Right node.
     cdpRbTreeNode*  tParent;      // Parent node.
+    size_t          size;         // Number of nodes in this subtree (for order statistics).
     bool            isRed;        // True if node is red.
     //
     cdpRecord       record;       // Child record.
@@ -48,23 +49,33 @@ typedef struct {
     Red-black tree implementation
 */
 
-#define rb_tree_new()     cdp_new(cdpRbTree)
-#define rb_tree_del       cdp_free
+#define rb_tree_new()       slab_try_new_item(cdpRbTree)
+#define rb_tree_del(tree)   slab_del_item(cdpRbTree, tree)
 
 
 static inline cdpRbTreeNode* rb_tree_node_new(cdpRecord* record) {
-    CDP_NEW(cdpRbTreeNode, tnode);
+    SLAB_TRY_NEW(cdpRbTreeNode, tnode);
+    if CDP_RARELY(!tnode)
+        return NULL;
+    tnode->size  = 1;
     tnode->isRed = true;
     cdp_record_transfer(record, &tnode->record);
     return tnode;
 }
 
 
-static inline cdpRbTreeNode* rb_tree_node_from_record(cdpRecord* record) {
+static inline cdpRbTreeNode* rb_tree_node_from_record(const cdpRecord* record) {
     return cdp_ptr_dif(record, offsetof(cdpRbTreeNode, record));
 }
 
 
+#define rb_tree_size(tnode)   ((tnode)? (tnode)->size: 0)
+
+static inline void rb_tree_update_size(cdpRbTreeNode* tnode) {
+    tnode->size = 1 + rb_tree_size(tnode->left) + rb_tree_size(tnode->right);
+}
+
+
 static inline void rb_tree_rotate_left(cdpRbTree* tree, cdpRbTreeNode* x) {
     cdpRbTreeNode* y = x->right;
     x->right = y->left;
@@ -80,6 +91,8 @@ static inline void rb_tree_rotate_left(cdpRbTree* tree, cdpRbTreeNode* x) {
     }
     y->left = x;
     x->tParent = y;
+    y->size = x->size;
+    rb_tree_update_size(x);
 }
 
 static inline void rb_tree_rotate_right(cdpRbTree* tree, cdpRbTreeNode* x) {
@@ -97,6 +110,8 @@ static inline void rb_tree_rotate_right(cdpRbTree* tree, cdpRbTreeNode* x) {
     }
     y->right = x;
     x->tParent = y;
+    y->size = x->size;
+    rb_tree_update_size(x);
 }
 
 static inline void rb_tree_fix_insert(cdpRbTree* tree, cdpRbTreeNode* z) {
@@ -144,6 +159,7 @@ static inline void rb_tree_sorted_insert_tnode(cdpRbTree* tree, cdpRbTreeNode* t
         cdpRbTreeNode* x = tree->root, *y;
         do {
             y = x;
+            y->size++;
             int cmp = compare(&tnode->record, &x->record, context);
             if (0 > cmp) {
                 x = x->left;
@@ -169,6 +185,8 @@ static inline void rb_tree_sorted_insert_tnode(cdpRbTree* tree, cdpRbTreeNode* t
 
 static inline cdpRecord* rb_tree_named_insert(cdpRbTree* tree, cdpRecord* record) {
     cdpRbTreeNode* tnode = rb_tree_node_new(record);
+    if CDP_RARELY(!tnode)
+        return NULL;
     rb_tree_sorted_insert_tnode(tree, tnode, record_compare_by_name, NULL);
     return &tnode->record;
 }
@@ -176,6 +194,8 @@ static inline cdpRecord* rb_tree_named_insert(cdpRbTree* tree, cdpRecord* record
 
 static inline cdpRecord* rb_tree_sorted_insert(cdpRbTree* tree, cdpRecord* record, cdpCompare compare, void* context) {
     cdpRbTreeNode* tnode = rb_tree_node_new(record);
+    if CDP_RARELY(!tnode)
+        return NULL;
     rb_tree_sorted_insert_tnode(tree, tnode, compare, context);
     return &tnode->record;
 }
@@ -195,50 +215,53 @@ static inline cdpRecord* rb_tree_last(cdpRbTree* tree) {
 }
 
 
-#define RB_TREE_MIN_DEPTH   64
-
-static inline bool rb_tree_traverse(cdpRbTree* tree, unsigned maxDepth, cdpTraverse func, void* context, cdpEntry* entry) {
-    cdpRbTreeNode*  tnode = tree->root, *tnodePrev = NULL;
-    size_t      stackSize = maxDepth * sizeof(void*);
-    cdpRbTreeNode** stack = (maxDepth > RB_TREE_MIN_DEPTH)?  cdp_malloc(stackSize):  cdp_alloca(stackSize);
-    int top = -1;  // Stack index initialized to empty.
-
-    entry->parent = tree->store.owner;
-    entry->depth  = 0;
-    do {
-        if (tnode) {
-            assert(top < ((int)maxDepth - 1));
-            stack[++top] = tnode;
-            tnode = tnode->left;
-        } else {
-            tnode = stack[top--];
-            if (tnodePrev) {
-                entry->next   = &tnode->record;
-                entry->record = &tnodePrev->record;
-                if (!func(entry, context)) {
-                    if (maxDepth > RB_TREE_MIN_DEPTH)
-                        cdp_free(stack);
-                    return false;
-                }
-                entry->position++;
-                entry->prev = entry->record;
-            }
-            tnodePrev = tnode;
-            tnode = tnode->right;
-        }
-    } while (top != -1 || tnode);
+static inline cdpRecord* rb_tree_prev(cdpRecord* record) {
+    cdpRbTreeNode* tnode = rb_tree_node_from_record(record);
+    if (tnode->left) {
+        tnode = tnode->left;
+        while (tnode->right) tnode = tnode->right;
+        return &tnode->record;
+    }
+    cdpRbTreeNode* tParent = tnode->tParent;
+    while (tParent && tnode == tParent->left) {
+        tnode = tParent;
+        tParent = tParent->tParent;
+    }
+    return tParent? &tParent->record: NULL;
+}
 
-    if (maxDepth > RB_TREE_MIN_DEPTH)
-        cdp_free(stack);
 
-    entry->next   = NULL;
-    entry->record = &tnodePrev->record;
-    return func(entry, context);
+static inline cdpRecord* rb_tree_next(cdpRecord* record) {
+    cdpRbTreeNode* tnode = rb_tree_node_from_record(record);
+    if (tnode->right) {
+        tnode = tnode->right;
+        while (tnode->left) tnode = tnode->left;
+        return &tnode->record;
+    }
+    cdpRbTreeNode* tParent = tnode->tParent;
+    while (tParent && tnode == tParent->right) {
+        tnode = tParent;
+        tParent = tParent->tParent;
+    }
+    return tParent? &tParent->record: NULL;
 }
 
 
-static inline int rb_traverse_func_break_at_name(cdpEntry* entry, uintptr_t name) {
-    return !cdp_record_name_is(entry->record, name);
+static inline bool rb_tree_traverse(cdpRbTree* tree, cdpTraverse func, void* context, cdpEntry* entry) {
+    // Parent links give the in-order walk, so no stack is needed.
+    entry->parent = tree->store.owner;
+    entry->depth  = 0;
+    entry->record = rb_tree_first(tree);
+    for (;;) {
+        entry->next = rb_tree_next(entry->record);
+        if (!func(entry, context))
+            return false;
+        if (!entry->next)
+            return true;
+        entry->position++;
+        entry->prev   = entry->record;
+        entry->record = entry->next;
+    }
 }
 
 
@@ -262,10 +285,10 @@ static inline cdpRecord* rb_tree_find_by_dt(cdpRbTree* tree, const cdpDT* dt) {
 static inline cdpRecord* rb_tree_find_by_name(cdpRbTree* tree, const cdpDT* name) {
     if (cdp_store_is_dictionary(&tree->store)) {
         return rb_tree_find_by_dt(tree, name);
-    } else {
-        cdpEntry entry = {0};
-        if (!rb_tree_traverse(tree, cdp_bitson(tree->store.chdCount) + 2, (cdpFunc) rb_traverse_func_break_at_name, cdp_v2p(name), &entry))
-            return entry.record;
+    }
+    for (cdpRecord* record = rb_tree_first(tree);  record;  record = rb_tree_next(record)) {
+        if (cdp_record_name_is(record, name))
+            return record;
     }
     return NULL;
 }
@@ -292,42 +315,30 @@ static inline int rb_traverse_func_break_at_position(cdpEntry* entry, uintptr_t
 }
 
 static inline cdpRecord* rb_tree_find_by_position(cdpRbTree* tree, size_t position) {
-    cdpEntry entry = {0};
-    if (!rb_tree_traverse(tree, cdp_bitson(tree->store.chdCount) + 2, (void*) rb_traverse_func_break_at_position, cdp_v2p(position), &entry))
-        return entry.record;
-    return NULL;
-}
-
-
-static inline cdpRecord* rb_tree_prev(cdpRecord* record) {
-    cdpRbTreeNode* tnode = rb_tree_node_from_record(record);
-    if (tnode->left) {
-        tnode = tnode->left;
-        while (tnode->right) tnode = tnode->right;
-        return &tnode->record;
-    }
-    cdpRbTreeNode* tParent = tnode->tParent;
-    while (tParent && tnode == tParent->left) {
-        tnode = tParent;
-        tParent = tParent->tParent;
+    cdpRbTreeNode* tnode = tree->root;
+    while (tnode) {
+        size_t lsize = rb_tree_size(tnode->left);
+        if (position < lsize) {
+            tnode = tnode->left;
+        } else if (position > lsize) {
+            position -= lsize + 1;
+            tnode = tnode->right;
+        } else {
+            return &tnode->record;
+        }
     }
-    return tParent? &tParent->record: NULL;
+    return NULL;
 }
 
 
-static inline cdpRecord* rb_tree_next(cdpRecord* record) {
+static inline size_t rb_tree_index_of(const cdpRecord* record) {
     cdpRbTreeNode* tnode = rb_tree_node_from_record(record);
-    if (tnode->right) {
-        tnode = tnode->right;
-        while (tnode->left) tnode = tnode->left;
-        return &tnode->record;
-    }
-    cdpRbTreeNode* tParent = tnode->tParent;
-    while (tParent && tnode == tParent->right) {
-        tnode = tParent;
-        tParent = tParent->tParent;
+    size_t index = rb_tree_size(tnode->left);
+    for (;  tnode->tParent;  tnode = tnode->tParent) {
+        if (tnode == tnode->tParent->right)
+            index += rb_tree_size(tnode->tParent->left) + 1;
     }
-    return tParent? &tParent->record: NULL;
+    return index;
 }
 
 
@@ -404,19 +415,22 @@ static inline void rb_tree_fixremove_node(cdpRbTree* tree, cdpRbTreeNode* x) {
 
 static inline void rb_tree_remove_record(cdpRbTree* tree, cdpRecord* record) {
     cdpRbTreeNode* tnode = rb_tree_node_from_record(record);
-    cdpRbTreeNode* y = tnode, *x;
+    cdpRbTreeNode* y = tnode, *x, *resized;
     bool wasRed = tnode->isRed;
 
     if (!tnode->left) {
         x = tnode->right;
+        resized = tnode->tParent;
         rb_tree_transplant(tree, tnode, x);
     } else if (!tnode->right) {
         x = tnode->left;
+        resized = tnode->tParent;
         rb_tree_transplant(tree, tnode, x);
     } else {
         for (y = tnode->right;  y->left;  y = y->left);
         wasRed = y->isRed;
         x = y->right;
+        resized = (y->tParent == tnode)?  y:  y->tParent;
 
         if (y->tParent == tnode) {
             if (x)  x->tParent = y;
@@ -430,10 +444,15 @@ static inline void rb_tree_remove_record(cdpRbTree* tree, cdpRecord* record) {
         y->left->tParent = y;
         y->isRed = tnode->isRed;
     }
+
+    // Subtree sizes only change along the path above the removed spot.
+    for (;  resized;  resized = resized->tParent)
+        rb_tree_update_size(resized);
+
     if (x && !wasRed)
         rb_tree_fixremove_node(tree, x);
 
-    cdp_free(tnode);
+    slab_del_item(cdpRbTreeNode, tnode);
 }
 
 
@@ -460,7 +479,7 @@ static inline void rb_tree_del_all_children_recursively(cdpRbTreeNode* tnode) {
     if (tnode->right)
         rb_tree_del_all_children_recursively(tnode->right);
 
-    cdp_free(tnode);
+    slab_del_item(cdpRbTreeNode, tnode);
 }
 
 static inline void rb_tree_del_all_children(cdpRbTree* tree) {
@@ -0,0 +1,550 @@
+/*
+ *  Copyright (c) 2024 Victor M. Barrientos (https://github.com/FirmwGuy/CacadeDP)
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of
+ *  this software and associated documentation files (the "Software"), to deal in
+ *  the Software without restriction, including without limitation the rights to
+ *  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is furnished to do
+ *  so.
+ * 
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+
+#include <stdatomic.h>
+
+
+typedef struct _cdpSkipNode     cdpSkipNode;
+typedef struct _cdpQsbrThread   cdpQsbrThread;
+
+struct _cdpSkipNode {
+    cdpSkipNode*        retired;        // Next node waiting to be reclaimed.
+    uint64_t            epoch;          // Epoch in which this node was retired.
+    atomic_bool         linked;         // The inserter is done linking upper levels.
+    bool                dispose;        // Finalize record when reclaimed.
+    unsigned            height;         // Number of levels of this node.
+    //
+    cdpRecord           record;         // Child record.
+    _Atomic(uintptr_t)  next[];         // Successor at each level (bit 0 marks deletion).
+};
+
+typedef struct {
+    cdpStore            store;          // Parent info.
+    //
+    cdpSkipNode*        head;           // Sentinel node (with all levels).
+} cdpSkipList;
+
+struct _cdpQsbrThread {
+    cdpQsbrThread*      next;           // Next registered thread.
+    atomic_uint_fast64_t seen;          // Last epoch observed in a quiescent state.
+    atomic_bool         online;         // Thread may be holding skip list nodes.
+};
+
+
+#define SKIPLIST_MAX_LEVEL      16      // With p = 1/4 this serves up to 4^16 children.
+
+#define skiplist_ptr(v)         ((cdpSkipNode*)((v) & ~(uintptr_t)1))
+#define skiplist_marked(v)      ((v) & 1)
+
+
+/*
+    Removed nodes can't be freed while other threads may still be reading
+    them, so they are "retired" instead. Each thread using shared stores
+    reports its quiescent states (points where it holds no child pointer)
+    and a retired node is reclaimed only after every online thread has
+    been quiescent since its retirement (QSBR).
+*/
+static atomic_uint_fast64_t     SKIPLIST_EPOCH = 1;
+static _Atomic(cdpSkipNode*)    SKIPLIST_RETIRED;
+static _Atomic(cdpQsbrThread*)  SKIPLIST_THREADS;
+static _Thread_local cdpQsbrThread* SKIPLIST_SELF;
+static _Thread_local uint32_t   SKIPLIST_SEED;
+
+
+
+
+/*
+    Skip list implementation
+*/
+
+static inline cdpSkipNode* skiplist_node_new(unsigned height) {
+    // Retired nodes may outlive their branch, so these never come from an arena.
+    cdpSkipNode* snode = slab_try_alloc0_shared(sizeof(cdpSkipNode) + (height * sizeof(uintptr_t)));
+    if CDP_EXPECT_PTR(snode)
+        snode->height = height;
+    return snode;
+}
+
+#define skiplist_node_del(snode)    slab_free(snode, sizeof(cdpSkipNode) + ((snode)->height * sizeof(uintptr_t)))
+
+
+static inline cdpSkipNode* skiplist_node_from_record(const cdpRecord* record) {
+    return cdp_ptr_dif(record, offsetof(cdpSkipNode, record));
+}
+
+
+static inline cdpSkipList* skiplist_new(void) {
+    SLAB_TRY_NEW(cdpSkipList, list);
+    if CDP_RARELY(!list)
+        return NULL;
+    list->head = skiplist_node_new(SKIPLIST_MAX_LEVEL);
+    if CDP_RARELY(!list->head) {
+        slab_del_item(cdpSkipList, list);
+        return NULL;
+    }
+    atomic_init(&list->head->linked, true);
+    return list;
+}
+
+
+static inline void skiplist_del(cdpSkipList* list) {
+    skiplist_node_del(list->head);
+    slab_del_item(cdpSkipList, list);
+}
+
+
+static inline unsigned skiplist_random_height(void) {
+    uint32_t x = SKIPLIST_SEED;
+    if CDP_RARELY(!x)
+        x = (uint32_t)(uintptr_t)&SKIPLIST_SEED | 1;
+    x ^= x << 13;  x ^= x >> 17;  x ^= x << 5;      // Xorshift.
+    SKIPLIST_SEED = x;
+
+    unsigned height = 1;
+    while (height < SKIPLIST_MAX_LEVEL  &&  !(x & 3)) {
+        height++;
+        x >>= 2;
+    }
+    return height;
+}
+
+
+static inline bool skiplist_find(cdpSkipList* list, const cdpRecord* key, cdpCompare compare, void* context, cdpSkipNode** preds, cdpSkipNode** succs) {
+    // Finds the first node not below key at each level, unlinking deleted nodes on the way.
+  retry:;
+    cdpSkipNode* pred = list->head;
+    cdpSkipNode* curr = NULL;
+    for (int level = SKIPLIST_MAX_LEVEL - 1;  level >= 0;  level--) {
+        curr = skiplist_ptr(atomic_load(&pred->next[level]));
+        while (curr) {
+            uintptr_t succ = atomic_load(&curr->next[level]);
+            if (skiplist_marked(succ)) {
+                uintptr_t expected = (uintptr_t) curr;
+                if (!atomic_compare_exchange_strong(&pred->next[level], &expected, (uintptr_t) skiplist_ptr(succ)))
+                    goto retry;
+                curr = skiplist_ptr(succ);
+                continue;
+            }
+            if (0 >= compare(key, &curr->record, context))
+                break;
+            pred = curr;
+            curr = skiplist_ptr(succ);
+        }
+        if (preds) {
+            preds[level] = pred;
+            succs[level] = curr;
+        }
+    }
+    return curr  &&  (0 == compare(key, &curr->record, context));
+}
+
+
+static inline cdpRecord* skiplist_insert(cdpSkipList* list, cdpRecord* record, cdpCompare compare, void* context) {
+    cdpSkipNode* preds[SKIPLIST_MAX_LEVEL], *succs[SKIPLIST_MAX_LEVEL];
+    cdpSkipNode* snode = skiplist_node_new(skiplist_random_height());
+    if CDP_RARELY(!snode)
+        return NULL;
+    cdp_record_transfer(record, &snode->record);
+    store_child_adopt(&list->store, &snode->record);   // Readers may see it as soon as it is linked.
+
+    for (;;) {
+        if (skiplist_find(list, &snode->record, compare, context, preds, succs)) {
+            // Duplicates are not allowed: give the record back.
+            store_child_orphan(&list->store, &snode->record);
+            cdp_record_transfer(&snode->record, record);
+            skiplist_node_del(snode);
+            return NULL;
+        }
+        for (unsigned level = 0;  level < snode->height;  level++)
+            atomic_store_explicit(&snode->next[level], (uintptr_t) succs[level], memory_order_relaxed);
+
+        uintptr_t expected = (uintptr_t) succs[0];
+        if (atomic_compare_exchange_strong(&preds[0]->next[0], &expected, (uintptr_t) snode))
+            break;
+    }
+
+    // Link the upper levels (unless the node gets deleted meanwhile).
+    for (unsigned level = 1;  level < snode->height;  level++) {
+        for (;;) {
+            uintptr_t next = atomic_load(&snode->next[level]);
+            if (skiplist_marked(next))
+                goto done;
+            if (skiplist_ptr(next) != succs[level]
+             && !atomic_compare_exchange_strong(&snode->next[level], &next, (uintptr_t) succs[level]))
+                goto done;      // Only deletion changes it.
+
+            uintptr_t expected = (uintptr_t) succs[level];
+            if (atomic_compare_exchange_strong(&preds[level]->next[level], &expected, (uintptr_t) snode))
+                break;
+            skiplist_find(list, &snode->record, compare, context, preds, succs);
+            if (succs[0] != snode)
+                goto done;      // Already deleted.
+        }
+    }
+  done:
+    atomic_store(&snode->linked, true);
+
+    return &snode->record;
+}
+
+
+static inline cdpRecord* skiplist_named_insert(cdpSkipList* list, cdpRecord* record) {
+    return skiplist_insert(list, record, record_compare_by_name, NULL);
+}
+
+
+static inline cdpRecord* skiplist_sorted_insert(cdpSkipList* list, cdpRecord* record, cdpCompare compare, void* context) {
+    return skiplist_insert(list, record, compare, context);
+}
+
+
+static inline cdpSkipNode* skiplist_next_node(cdpSkipNode* snode) {
+    // Next node in level 0 which isn't being deleted.
+    for (snode = skiplist_ptr(atomic_load(&snode->next[0]));  snode;  snode = skiplist_ptr(atomic_load(&snode->next[0]))) {
+        if (!skiplist_marked(atomic_load(&snode->next[0])))
+            break;
+    }
+    return snode;
+}
+
+
+static inline cdpRecord* skiplist_first(cdpSkipList* list) {
+    cdpSkipNode* snode = skiplist_next_node(list->head);
+    return snode? &snode->record: NULL;
+}
+
+
+static inline cdpRecord* skiplist_last(cdpSkipList* list) {
+    cdpSkipNode* last = list->head;
+    for (int level = SKIPLIST_MAX_LEVEL - 1;  level >= 0;  level--) {
+        for (cdpSkipNode* snode = skiplist_ptr(atomic_load(&last->next[level]));  snode;  snode = skiplist_ptr(atomic_load(&snode->next[level])))
+            last = snode;
+    }
+    if (last == list->head)
+        return NULL;
+    if (!skiplist_marked(atomic_load(&last->next[0])))
+        return &last->record;
+
+    // The last one is going away: walk the bottom level instead.
+    cdpSkipNode* alive = NULL;
+    for (cdpSkipNode* snode = skiplist_next_node(list->head);  snode;  snode = skiplist_next_node(snode))
+        alive = snode;
+    return alive? &alive->record: NULL;
+}
+
+
+static inline cdpCompare skiplist_compare(cdpSkipList* list, cdpHashCompare* byHash, void** context) {
+    // Children must be searched in the same order they were inserted (see cdp_store_add_child).
+    *context = NULL;
+    switch (list->store.indexing) {
+      case CDP_INDEX_BY_NAME: {
+        return record_compare_by_name;
+      }
+      case CDP_INDEX_BY_HASH: {
+        byHash->compare = list->store.compare;
+        byHash->context = NULL;
+        *context = byHash;
+        return record_compare_by_hash;
+      }
+    }
+    return list->store.compare;
+}
+
+
+static inline cdpRecord* skiplist_find_by_key(cdpSkipList* list, cdpRecord* key, cdpCompare compare, void* context) {
+    cdpSkipNode* preds[SKIPLIST_MAX_LEVEL], *succs[SKIPLIST_MAX_LEVEL];
+    if (skiplist_find(list, key, compare, context, preds, succs))
+        return &succs[0]->record;
+    return NULL;
+}
+
+
+static inline cdpRecord* skiplist_find_by_name(cdpSkipList* list, const cdpDT* name) {
+    if (cdp_store_is_dictionary(&list->store)) {
+        cdpRecord key = {.metarecord.domain = name->domain, .metarecord.tag = name->tag};
+        return skiplist_find_by_key(list, &key, record_compare_by_name, NULL);
+    }
+    for (cdpSkipNode* snode = skiplist_next_node(list->head);  snode;  snode = skiplist_next_node(snode)) {
+        if (cdp_record_name_is(&snode->record, name))
+            return &snode->record;
+    }
+    return NULL;
+}
+
+
+static inline cdpRecord* skiplist_find_by_position(cdpSkipList* list, size_t position) {
+    size_t n = 0;
+    for (cdpSkipNode* snode = skiplist_next_node(list->head);  snode;  snode = skiplist_next_node(snode), n++) {
+        if (n == position)
+            return &snode->record;
+    }
+    return NULL;
+}
+
+
+static inline size_t skiplist_index_of(cdpSkipList* list, const cdpRecord* record) {
+    size_t n = 0;
+    for (cdpSkipNode* snode = skiplist_next_node(list->head);  snode  &&  &snode->record != record;  snode = skiplist_next_node(snode))
+        n++;
+    return n;
+}
+
+
+static inline cdpRecord* skiplist_prev(cdpSkipList* list, cdpRecord* record) {
+    cdpSkipNode* preds[SKIPLIST_MAX_LEVEL], *succs[SKIPLIST_MAX_LEVEL];
+    cdpHashCompare byHash;
+    void* context;
+    cdpCompare compare = skiplist_compare(list, &byHash, &context);
+    skiplist_find(list, record, compare, context, preds, succs);
+    return (preds[0] != list->head)? &preds[0]->record: NULL;
+}
+
+
+static inline cdpRecord* skiplist_next(cdpRecord* record) {
+    cdpSkipNode* snode = skiplist_next_node(skiplist_node_from_record(record));
+    return snode? &snode->record: NULL;
+}
+
+
+static inline cdpRecord* skiplist_next_by_name(cdpSkipList* list, cdpDT* name, cdpSkipNode** prev) {
+    cdpSkipNode* snode = skiplist_next_node(*prev? *prev: list->head);
+    for (;  snode;  snode = skiplist_next_node(snode)) {
+        if (cdp_record_name_is(&snode->record, name)) {
+            *prev = snode;
+            return &snode->record;
+        }
+    }
+    *prev = NULL;
+    return NULL;
+}
+
+
+static inline bool skiplist_traverse(cdpSkipList* list, cdpTraverse func, void* context, cdpEntry* entry) {
+    entry->parent = list->store.owner;
+    entry->depth  = 0;
+    cdpSkipNode* snode = skiplist_next_node(list->head), *next;
+    if (!snode)
+        return true;        // Emptied by another thread.
+    do {
+        next = skiplist_next_node(snode);
+        entry->record = &snode->record;
+        entry->next = next? &next->record: NULL;
+        if (!func(entry, context))
+            return false;
+        entry->position++;
+        entry->prev = entry->record;
+        snode = next;
+    } while (snode);
+    return true;
+}
+
+
+
+
+/*
+    Removal and reclamation
+*/
+
+static inline void skiplist_node_free(cdpSkipNode* snode) {
+    if (snode->dispose)
+        cdp_record_finalize(&snode->record);
+    skiplist_node_del(snode);
+}
+
+
+static inline uint64_t skiplist_safe_epoch(void) {
+    uint64_t safe = UINT64_MAX;
+    for (cdpQsbrThread* thread = atomic_load(&SKIPLIST_THREADS);  thread;  thread = thread->next) {
+        if (atomic_load(&thread->online)) {
+            uint64_t seen = atomic_load(&thread->seen);
+            if (seen < safe)
+                safe = seen;
+        }
+    }
+    return safe;
+}
+
+
+static inline void skiplist_reclaim(void) {
+    cdpSkipNode* snode = atomic_exchange(&SKIPLIST_RETIRED, NULL);
+    if (!snode)
+        return;
+
+    uint64_t safe = skiplist_safe_epoch();
+    cdpSkipNode* keep = NULL, *tail = NULL, *next;
+    for (;  snode;  snode = next) {
+        next = snode->retired;
+        if (snode->epoch <= safe) {
+            skiplist_node_free(snode);
+        } else {
+            snode->retired = keep;
+            keep = snode;
+            if (!tail)
+                tail = snode;
+        }
+    }
+
+    if (keep) {
+        // Put back the ones still in their grace period.
+        cdpSkipNode* head = atomic_load(&SKIPLIST_RETIRED);
+        do {
+            tail->retired = head;
+        } while (!atomic_compare_exchange_weak(&SKIPLIST_RETIRED, &head, keep));
+    }
+}
+
+
+static inline void skiplist_retire(cdpSkipNode* snode, bool dispose) {
+    snode->dispose = dispose;
+    snode->epoch   = atomic_fetch_add(&SKIPLIST_EPOCH, 1) + 1;
+
+    cdpSkipNode* head = atomic_load(&SKIPLIST_RETIRED);
+    do {
+        snode->retired = head;
+    } while (!atomic_compare_exchange_weak(&SKIPLIST_RETIRED, &head, snode));
+
+    if (!SKIPLIST_SELF)
+        skiplist_reclaim();     // Single threaded users get memory back right away.
+}
+
+
+static inline bool skiplist_claim(cdpSkipNode* snode) {
+    // Marks every level, the thread marking level 0 owns the removal.
+    for (unsigned level = snode->height - 1;  level > 0;  level--) {
+        uintptr_t next = atomic_load(&snode->next[level]);
+        while (!skiplist_marked(next))
+            atomic_compare_exchange_weak(&snode->next[level], &next, next | 1);
+    }
+    uintptr_t next = atomic_load(&snode->next[0]);
+    while (!skiplist_marked(next)) {
+        if (atomic_compare_exchange_weak(&snode->next[0], &next, next | 1))
+            return true;
+    }
+    return false;
+}
+
+
+static inline void skiplist_unlink(cdpSkipList* list, cdpSkipNode* snode, bool dispose) {
+    while (!atomic_load(&snode->linked))
+        ;   // The inserter will stop linking as soon as it sees the marks.
+    cdpHashCompare byHash;
+    void* context;
+    cdpCompare compare = skiplist_compare(list, &byHash, &context);
+    skiplist_find(list, &snode->record, compare, context, NULL, NULL);
+    skiplist_retire(snode, dispose);
+}
+
+
+static inline bool skiplist_remove_record(cdpSkipList* list, cdpRecord* record, cdpRecord* target) {
+    cdpSkipNode* snode = skiplist_node_from_record(record);
+    if (!skiplist_claim(snode))
+        return false;           // Someone else removed it.
+    if (target)
+        cdp_record_transfer(record, target);
+    skiplist_unlink(list, snode, !target);     // Readers may still use the record until reclaimed.
+    return true;
+}
+
+
+static inline bool skiplist_take(cdpSkipList* list, cdpRecord* target) {
+    cdpRecord* last;
+    while ((last = skiplist_last(list))) {
+        if (skiplist_remove_record(list, last, target))
+            return true;
+    }
+    return false;
+}
+
+
+static inline bool skiplist_pop(cdpSkipList* list, cdpRecord* target) {
+    cdpRecord* first;
+    while ((first = skiplist_first(list))) {
+        if (skiplist_remove_record(list, first, target))
+            return true;
+    }
+    return false;
+}
+
+
+static inline void skiplist_del_all_children(cdpSkipList* list) {
+    // Only called when no other thread uses the store.
+    cdpSkipNode* snode = skiplist_ptr(atomic_load(&list->head->next[0])), *next;
+    while (snode) {
+        next = skiplist_ptr(atomic_load(&snode->next[0]));
+        cdp_record_finalize(&snode->record);
+        skiplist_node_del(snode);
+        snode = next;
+    }
+    for (unsigned level = 0;  level < SKIPLIST_MAX_LEVEL;  level++)
+        atomic_store(&list->head->next[level], 0);
+}
+
+
+
+
+/*
+    Thread registration (QSBR)
+*/
+
+static inline void skiplist_thread_online(void) {
+    cdpQsbrThread* thread = SKIPLIST_SELF;
+    if (!thread) {
+        thread = cdp_malloc0(sizeof(cdpQsbrThread));
+        thread->next = atomic_load(&SKIPLIST_THREADS);
+        while (!atomic_compare_exchange_weak(&SKIPLIST_THREADS, &thread->next, thread));
+        SKIPLIST_SELF = thread;
+    }
+    atomic_store(&thread->seen, atomic_load(&SKIPLIST_EPOCH));
+    atomic_store(&thread->online, true);
+}
+
+
+static inline void skiplist_thread_offline(void) {
+    if (SKIPLIST_SELF)
+        atomic_store(&SKIPLIST_SELF->online, false);
+    skiplist_reclaim();
+}
+
+
+static inline void skiplist_quiescent(void) {
+    if (SKIPLIST_SELF)
+        atomic_store(&SKIPLIST_SELF->seen, atomic_load(&SKIPLIST_EPOCH));
+    skiplist_reclaim();
+}
+
+
+static inline void skiplist_shutdown(void) {
+    // Nobody else is running: free every retired node and thread record.
+    cdpSkipNode* snode = atomic_exchange(&SKIPLIST_RETIRED, NULL), *next;
+    for (;  snode;  snode = next) {
+        next = snode->retired;
+        skiplist_node_free(snode);
+    }
+    cdpQsbrThread* thread = atomic_exchange(&SKIPLIST_THREADS, NULL), *tnext;
+    for (;  thread;  thread = tnext) {
+        tnext = thread->next;
+        cdp_free(thread);
+    }
+    SKIPLIST_SELF = NULL;
+}
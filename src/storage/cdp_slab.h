@@ -0,0 +1,334 @@
+/*
+ *  Copyright (c) 2025 Victor M. Barrientos (https://github.com/FirmwGuy/CacadeDP)
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy of
+ *  this software and associated documentation files (the "Software"), to deal in
+ *  the Software without restriction, including without limitation the rights to
+ *  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ *  of the Software, and to permit persons to whom the Software is furnished to do
+ *  so.
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+
+#include <stdatomic.h>
+
+
+typedef struct _cdpSlab         cdpSlab;
+
+struct _cdpSlab {
+    cdpSlab*        next;       // Next slab (in its class partial list or in its arena).
+    cdpSlab*        prev;       // Previous slab in the class partial list.
+    void*           free;       // Items given back (linked by their first word).
+    char*           bump;       // First item never handed out.
+    char*           end;        // End of the last item that fits.
+    cdpArena*       arena;      // Arena owning this slab (NULL if shared).
+    unsigned        used;       // Items out of the slab (handed out or cached by threads).
+    unsigned        sclass;     // Size class of its items.
+    bool            listed;     // Slab is in its class partial list.
+};
+
+typedef struct {
+    atomic_flag     lock;       // Spin lock (classes are only locked for a batch of items).
+    cdpSlab*        partial;    // Slabs with items left.
+    cdpSlab*        empty;      // A fully free slab kept for re-use.
+} cdpSlabClass;
+
+#define SLAB_CLASSES        34
+#define SLAB_MAGAZINE       32          // Items cached by each thread per class.
+
+struct _cdpArena {
+    cdpSlab*        slab;       // Every slab of this arena.
+    size_t          slabs;      // Number of them.
+    cdpSlab*        carve[SLAB_CLASSES];    // Slab being carved for each class.
+};
+
+typedef struct {
+    unsigned        count;
+    void*           item[SLAB_MAGAZINE];
+} cdpSlabMagazine;
+
+
+#define SLAB_SIZE           (64 * 1024)                                     // Slab bytes, which is also its alignment.
+#define SLAB_HEAD_SIZE      ((sizeof(cdpSlab) + 15) & ~(size_t)15)          // Items keep a 16 byte alignment.
+#ifdef CDP_SLAB_DISABLE
+  #define SLAB_ITEM_MAX     0           // Everything goes to the heap (as for memory checkers).
+#else
+  #define SLAB_ITEM_MAX     2560
+#endif
+
+#define slab_of(item)       ((cdpSlab*)((uintptr_t)(item) & ~(uintptr_t)(SLAB_SIZE - 1)))
+
+
+/*
+    Small allocations (records, stores and storage nodes) are served from
+    64 KiB slabs, each carved into items of a single size class. Every
+    thread caches a few free items per class (a magazine) so the common
+    alloc/free pair touches no lock; magazines are refilled from (or
+    drained to) the shared class in batches. An arena has slabs of its
+    own, carved by one thread at a time: items freed inside it are only
+    reclaimed when the whole arena is deleted.
+*/
+static cdpSlabClass                 SLAB_CLASS[SLAB_CLASSES];
+static _Thread_local cdpSlabMagazine SLAB_MAG[SLAB_CLASSES];
+static _Thread_local cdpArena*      SLAB_ARENA;                 // Arena used by this thread (if any).
+static cdpSlabStats                 SLAB_STATS;
+
+
+
+
+/*
+    Slab allocator implementation
+*/
+
+static inline unsigned slab_class_of(size_t size) {
+    assert(size  &&  size <= SLAB_ITEM_MAX);
+    if (size <= 256)
+        return (unsigned)((size - 1) >> 4);            // 16 byte steps.
+    if (size <= 1024)
+        return 12 + (unsigned)((size - 1) >> 6);       // 64 byte steps.
+    return 24 + (unsigned)((size - 1) >> 8);           // 256 byte steps.
+}
+
+
+static inline size_t slab_class_size(unsigned sclass) {
+    if (sclass < 16)
+        return (sclass + 1) << 4;
+    if (sclass < 28)
+        return (sclass - 11) << 6;
+    return (sclass - 23) << 8;
+}
+
+
+static inline cdpSlab* slab_new(unsigned sclass, cdpArena* arena) {
+    cdpSlab* slab = cdp_try_aligned_alloc(SLAB_SIZE, SLAB_SIZE);
+    if CDP_RARELY(!slab)
+        return NULL;
+    size_t   size = slab_class_size(sclass);
+    CDP_0(slab);
+    slab->bump   = (char*)slab + SLAB_HEAD_SIZE;
+    slab->end    = slab->bump + (((SLAB_SIZE - SLAB_HEAD_SIZE) / size) * size);
+    slab->sclass = sclass;
+    slab->arena  = arena;
+    return slab;
+}
+
+
+static inline void* slab_item_take(cdpSlab* slab) {
+    void* item = slab->free;
+    if (item) {
+        slab->free = *(void**)item;
+    } else {
+        assert(slab->bump < slab->end);
+        item = slab->bump;
+        slab->bump += slab_class_size(slab->sclass);
+    }
+    slab->used++;
+    return item;
+}
+
+#define slab_exhausted(slab)    (!(slab)->free  &&  (slab)->bump >= (slab)->end)
+
+
+static inline void slab_class_lock(cdpSlabClass* cls) {
+    while (atomic_flag_test_and_set_explicit(&cls->lock, memory_order_acquire));
+}
+
+#define slab_class_unlock(cls)  atomic_flag_clear_explicit(&(cls)->lock, memory_order_release)
+
+
+static inline void slab_class_link(cdpSlabClass* cls, cdpSlab* slab) {
+    slab->prev = NULL;
+    slab->next = cls->partial;
+    if (cls->partial)
+        cls->partial->prev = slab;
+    cls->partial = slab;
+    slab->listed = true;
+}
+
+
+static inline void slab_class_unlink(cdpSlabClass* cls, cdpSlab* slab) {
+    if (slab->prev) slab->prev->next = slab->next;
+    else            cls->partial = slab->next;
+    if (slab->next) slab->next->prev = slab->prev;
+    slab->listed = false;
+}
+
+
+static inline void slab_refill(unsigned sclass, cdpSlabMagazine* mag) {
+    cdpSlabClass* cls = &SLAB_CLASS[sclass];
+    slab_class_lock(cls);
+    while (mag->count < (SLAB_MAGAZINE / 2)) {
+        cdpSlab* slab = cls->partial;
+        if (!slab) {
+            if (cls->empty) {
+                slab = cls->empty;
+                cls->empty = NULL;
+            } else {
+                slab = slab_new(sclass, NULL);
+                if CDP_RARELY(!slab)
+                    break;      // Out of memory: hand out whatever was gathered.
+                __atomic_fetch_add(&SLAB_STATS.slabs, 1, __ATOMIC_RELAXED);
+            }
+            slab_class_link(cls, slab);
+        }
+        mag->item[mag->count++] = slab_item_take(slab);
+        if (slab_exhausted(slab))
+            slab_class_unlink(cls, slab);
+    }
+    slab_class_unlock(cls);
+}
+
+
+static inline void slab_drain(unsigned sclass, cdpSlabMagazine* mag, unsigned keep) {
+    cdpSlabClass* cls = &SLAB_CLASS[sclass];
+    slab_class_lock(cls);
+    while (mag->count > keep) {
+        void*    item = mag->item[--mag->count];
+        cdpSlab* slab = slab_of(item);
+        *(void**)item = slab->free;
+        slab->free = item;
+        slab->used--;
+        if (!slab->listed)
+            slab_class_link(cls, slab);
+
+        if (!slab->used) {
+            // Keep a single idle slab around, give the rest back.
+            slab_class_unlink(cls, slab);
+            if (cls->empty) {
+                cdp_free(slab);
+                __atomic_fetch_sub(&SLAB_STATS.slabs, 1, __ATOMIC_RELAXED);
+            } else {
+                cls->empty = slab;
+            }
+        }
+    }
+    slab_class_unlock(cls);
+}
+
+
+static inline void* slab_arena_alloc(cdpArena* arena, unsigned sclass) {
+    cdpSlab* slab = arena->carve[sclass];
+    if (!slab  ||  slab_exhausted(slab)) {
+        slab = slab_new(sclass, arena);
+        if CDP_RARELY(!slab)
+            return NULL;
+        slab->next  = arena->slab;
+        arena->slab = slab;
+        arena->slabs++;
+        arena->carve[sclass] = slab;
+        __atomic_fetch_add(&SLAB_STATS.arenaSlabs, 1, __ATOMIC_RELAXED);
+    }
+    return slab_item_take(slab);
+}
+
+
+static inline void* slab_try_alloc_shared(size_t size) {
+    if (size > SLAB_ITEM_MAX)
+        return cdp_try_malloc(size);
+    unsigned sclass = slab_class_of(size);
+    cdpSlabMagazine* mag = &SLAB_MAG[sclass];
+    if CDP_RARELY(!mag->count) {
+        slab_refill(sclass, mag);
+        if (!mag->count)
+            return NULL;
+    }
+    return mag->item[--mag->count];
+}
+
+
+static inline void* slab_try_alloc(size_t size) {
+    if (SLAB_ARENA  &&  size <= SLAB_ITEM_MAX)
+        return slab_arena_alloc(SLAB_ARENA, slab_class_of(size));
+    return slab_try_alloc_shared(size);
+}
+
+
+static inline void* slab_try_alloc0(size_t size) {
+    void* item = slab_try_alloc(size);
+    if CDP_EXPECT_PTR(item)
+        memset(item, 0, size);
+    return item;
+}
+
+
+static inline void* slab_try_alloc0_shared(size_t size) {
+    void* item = slab_try_alloc_shared(size);
+    if CDP_EXPECT_PTR(item)
+        memset(item, 0, size);
+    return item;
+}
+
+
+// These can't fail (as with cdp_malloc).
+static inline void* slab_alloc(size_t size)     {void* item = slab_try_alloc(size);   if CDP_RARELY(!item)  abort();  return item;}
+static inline void* slab_alloc0(size_t size)    {return memset(slab_alloc(size), 0, size);}
+
+
+static inline void slab_free(void* item, size_t size) {
+    if (!item)
+        return;
+    if (size > SLAB_ITEM_MAX) {
+        cdp_free(item);
+        return;
+    }
+    if (slab_of(item)->arena)
+        return;             // Released along with its arena.
+    unsigned sclass = slab_class_of(size);
+    cdpSlabMagazine* mag = &SLAB_MAG[sclass];
+    if CDP_RARELY(mag->count == SLAB_MAGAZINE)
+        slab_drain(sclass, mag, SLAB_MAGAZINE / 2);
+    mag->item[mag->count++] = item;
+}
+
+
+#define slab_new_item(T)            ((T*) slab_alloc0(sizeof(T)))
+#define slab_try_new_item(T)        ((T*) slab_try_alloc0(sizeof(T)))
+#define SLAB_NEW(T, p)              CDP_I(T, p, slab_new_item(T))
+#define SLAB_TRY_NEW(T, p)          CDP_I(T, p, slab_try_new_item(T))
+#define slab_del_item(T, p)         slab_free(p, sizeof(T))
+
+
+static inline void slab_thread_flush(void) {
+    for (unsigned n = 0;  n < SLAB_CLASSES;  n++) {
+        if (SLAB_MAG[n].count)
+            slab_drain(n, &SLAB_MAG[n], 0);
+    }
+}
+
+
+static inline void slab_shutdown(void) {
+    // Nobody else is running: idle slabs go back to the heap.
+    slab_thread_flush();
+    for (unsigned n = 0;  n < SLAB_CLASSES;  n++) {
+        cdpSlabClass* cls = &SLAB_CLASS[n];
+        if (cls->empty) {
+            cdp_free(cls->empty);
+            cls->empty = NULL;
+            SLAB_STATS.slabs--;
+        }
+    }
+}
+
+
+static inline void slab_arena_del(cdpArena* arena) {
+    assert(arena != SLAB_ARENA);
+    cdpSlab* slab = arena->slab, *next;
+    for (;  slab;  slab = next) {
+        next = slab->next;
+        cdp_free(slab);
+    }
+    __atomic_fetch_sub(&SLAB_STATS.arenaSlabs, arena->slabs, __ATOMIC_RELAXED);
+    cdp_free(arena);
+}
@@ -26,7 +26,10 @@
 
 #include "test.h"
 #include "cdp_record.h"
+#include "cdp_pool.h"
 #include <stdio.h>      // sprintf()
+#include <math.h>
+#include <pthread.h>
 
 
 
@@ -63,6 +66,12 @@ static bool print_values(cdpEntry* entry, void* unused) {
     return true;
 }
 
+static bool count_children(cdpEntry* entry, size_t* count) {
+    assert_not_null(entry->record);
+    (*count)++;
+    return true;
+}
+
 
 static void test_records_value(cdpRecord* rec, uint32_t trueval) {
     cdpData* data = rec->data;
@@ -294,6 +303,10 @@ static void test_records_tech_dictionary(unsigned storage) {
         found = cdp_record_find_by_position(dict, cdp_record_children(dict) - 1);
         test_records_value(found, vmax);
 
+        size_t position = munit_rand_uint32() % cdp_record_children(dict);
+        found = cdp_record_find_by_position(dict, position);
+        assert_size(cdp_record_index_of(found), ==, position);
+
         path->dt[0] = *cdp_record_get_name(item);
         found = cdp_record_find_by_path(dict, path);
         assert_ptr_equal(found, item);
@@ -474,6 +487,174 @@ static void test_records_tech_sequencing_list(void) {
 }
 
 
+static void test_records_tech_packed_queue(void) {
+    size_t maxItems = munit_rand_int_range(2, 400);
+
+    cdpRecord* bookQ = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+1), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_PACKED_QUEUE, (size_t)3);
+    cdpRecord* bookL = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+2), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_LINKED_LIST);
+
+    for (unsigned n = 0; n < maxItems;  n++) {
+        uint32_t value = n + 1;
+        cdpID name = CDP_NAME_ENUMERATION + value;
+
+        if (munit_rand_uint32() & 1) {
+            cdp_record_append_value(bookQ, CDP_DTS(CDP_ACRO("CDP"), name), CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+            cdp_record_append_value(bookL, CDP_DTS(CDP_ACRO("CDP"), name), CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        } else {
+            cdp_record_prepend_value(bookQ, CDP_DTS(CDP_ACRO("CDP"), name), CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+            cdp_record_prepend_value(bookL, CDP_DTS(CDP_ACRO("CDP"), name), CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        }
+
+        if (munit_rand_int_range(0, 2) == 1) {
+            // Removal from anywhere in the queue.
+            size_t position = munit_rand_uint32() % cdp_record_children(bookL);
+            cdp_record_delete(cdp_record_find_by_position(bookQ, position));
+            cdp_record_delete(cdp_record_find_by_position(bookL, position));
+        }
+        assert_size(cdp_record_children(bookQ), ==, cdp_record_children(bookL));
+        if (!cdp_record_children(bookL))
+            continue;
+
+        cdpRecord* recordQ = cdp_record_first(bookQ);
+        cdpRecord* recordL = cdp_record_first(bookL);
+        size_t position = 0;
+        do {
+            test_records_value(recordQ, *(uint32_t*)cdp_record_data(recordL));
+            assert_size(cdp_record_index_of(recordQ), ==, position++);
+            recordQ = cdp_record_next(bookQ, recordQ);
+            recordL = cdp_record_next(bookL, recordL);
+        } while (recordL);
+        assert_null(recordQ);
+
+        recordQ = cdp_record_last(bookQ);
+        recordL = cdp_record_last(bookL);
+        do {
+            test_records_value(recordQ, *(uint32_t*)cdp_record_data(recordL));
+            recordQ = cdp_record_prev(bookQ, recordQ);
+            recordL = cdp_record_prev(bookL, recordL);
+        } while (recordL);
+        assert_null(recordQ);
+    }
+
+    size_t count = 0;
+    assert_true(cdp_record_deep_traverse(bookQ, (cdpTraverse) count_children, NULL, &count, NULL));
+    assert_size(count, ==, cdp_record_children(bookQ));
+
+    cdp_record_delete(bookL);
+    cdp_record_delete(bookQ);
+
+    // Steady state producer/consumer: drained chunks are recycled.
+    cdpRecord* fifo = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+3), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_PACKED_QUEUE, (size_t)3);
+    cdp_store_share_chunks(fifo->store, true);
+    cdpChunkStats before, after;
+    for (unsigned n = 0;  n < 4 * maxItems;  n++) {
+        uint32_t value = n + 1;
+        cdp_record_append_value(fifo, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        if (cdp_record_children(fifo) > 8)
+            cdp_record_delete(cdp_record_first(fifo));
+        if (n == 2 * maxItems)
+            cdp_store_chunk_stats(fifo->store, &before);
+    }
+    cdp_store_chunk_stats(fifo->store, &after);
+    if (maxItems > 20) {
+        assert_size(after.allocated, ==, before.allocated);
+        assert_size(after.recycled, >, before.recycled);
+    }
+    cdp_record_delete(fifo);
+
+    cdp_store_chunk_stats(NULL, &after);
+    assert_size(after.spare, >, 0);     // Spares went to the shared pool.
+    cdp_store_chunk_pool_flush();
+    cdp_store_chunk_stats(NULL, &after);
+    assert_size(after.spare, ==, 0);
+}
+
+
+
+static void test_records_tech_deque(unsigned storage) {
+    size_t maxItems = munit_rand_int_range(2, 400);
+
+    cdpRecord* bookA = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+1), 0, CDP_DTAW("CDP", "list"), storage, (size_t)2);
+    cdpRecord* bookL = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+2), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_LINKED_LIST);
+
+    for (unsigned n = 0; n < maxItems;  n++) {
+        uint32_t value = n + 1;
+        cdpID name = CDP_NAME_ENUMERATION + value;
+
+        switch (munit_rand_uint32() % 4) {
+          case 0: {
+            cdp_record_append_value(bookA, CDP_DTS(CDP_ACRO("CDP"), name), CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+            cdp_record_append_value(bookL, CDP_DTS(CDP_ACRO("CDP"), name), CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+            break;
+          }
+          case 1: {
+            cdp_record_prepend_value(bookA, CDP_DTS(CDP_ACRO("CDP"), name), CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+            cdp_record_prepend_value(bookL, CDP_DTS(CDP_ACRO("CDP"), name), CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+            break;
+          }
+          case 2: {
+            // Insertion in the middle, with a child store that must follow its owner.
+            size_t position = munit_rand_uint32() % (cdp_record_children(bookL) + 1);
+            cdpRecord* listA = cdp_record_add_list(bookA, CDP_DTS(CDP_ACRO("CDP"), name), position, CDP_DTAW("CDP", "list"), CDP_STORAGE_LINKED_LIST);
+            cdp_record_add_value(listA, CDP_DTS(CDP_ACRO("CDP"), name), 0, CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+            cdp_record_add_value(bookL, CDP_DTS(CDP_ACRO("CDP"), name), position, CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+            break;
+          }
+          default: {
+            if (!cdp_record_children(bookL))
+                break;
+            cdpRecord tempA = {0}, tempL = {0};
+            unsigned op = munit_rand_uint32() % 3;
+            if (op == 0) {
+                cdp_record_child_pop(bookA, &tempA);
+                cdp_record_child_pop(bookL, &tempL);
+                cdp_record_finalize(&tempA);
+                cdp_record_finalize(&tempL);
+            } else if (op == 1) {
+                cdp_record_child_take(bookA, &tempA);
+                cdp_record_child_take(bookL, &tempL);
+                cdp_record_finalize(&tempA);
+                cdp_record_finalize(&tempL);
+            } else {
+                size_t position = munit_rand_uint32() % cdp_record_children(bookL);
+                cdp_record_delete(cdp_record_find_by_position(bookA, position));
+                cdp_record_delete(cdp_record_find_by_position(bookL, position));
+            }
+          }
+        }
+        assert_size(cdp_record_children(bookA), ==, cdp_record_children(bookL));
+        if (!cdp_record_children(bookL))
+            continue;
+
+        cdpRecord* recordA = cdp_record_first(bookA);
+        cdpRecord* recordL = cdp_record_first(bookL);
+        size_t position = 0;
+        do {
+            uint32_t expected = *(uint32_t*)cdp_record_data(recordL);
+            if (cdp_record_children(recordA)) {
+                cdpRecord* inner = cdp_record_first(recordA);
+                assert_ptr_equal(cdp_record_parent(inner), recordA);
+                test_records_value(inner, expected);
+            } else {
+                test_records_value(recordA, expected);
+            }
+            assert_ptr_equal(cdp_record_find_by_position(bookA, position), recordA);
+            assert_size(cdp_record_index_of(recordA), ==, position++);
+            recordA = cdp_record_next(bookA, recordA);
+            recordL = cdp_record_next(bookL, recordL);
+        } while (recordL);
+        assert_null(recordA);
+    }
+
+    size_t count = 0;
+    assert_true(cdp_record_deep_traverse(bookA, (cdpTraverse) count_children, NULL, &count, NULL));
+    assert_size(count, >=, cdp_record_children(bookA));
+
+    cdp_record_delete(bookL);
+    cdp_record_delete(bookA);
+}
+
+
 static void test_records_tech_sequencing_dictionary(void) {
     size_t maxItems = munit_rand_int_range(2, 100);
 
@@ -605,6 +786,1738 @@ static void test_records_tech_sequencing_catalog(void) {
 }
 
 
+static int tech_value_compare(const cdpRecord* key, const cdpRecord* record, void* unused) {
+    return (int)*(uint32_t*)cdp_record_data(key) - (int)*(uint32_t*)cdp_record_data(record);
+}
+
+static int tech_value_descending(const cdpRecord* restrict key, const cdpRecord* restrict rec, void* unused) {
+    return tech_value_compare(rec, key, unused);
+}
+
+static void tech_array_keys_check(cdpRecord* dict, const bool* present, const cdpID* domain, size_t domains, size_t tags) {
+    // Every present name is found (and only those), and children are kept in name order.
+    size_t count = 0;
+    for (size_t d = 0;  d < domains;  d++) {
+        for (size_t t = 0;  t < tags;  t++) {
+            cdpRecord* found = cdp_record_find_by_name(dict, CDP_DTS(domain[d], CDP_NAME_ENUMERATION + t));
+            if (!present[d * tags + t]) {
+                assert_null(found);
+                continue;
+            }
+            assert_not_null(found);
+            assert_uint32(*(uint32_t*)cdp_record_data(found), ==, d * tags + t);
+            count++;
+        }
+    }
+    assert_size(cdp_record_children(dict), ==, count);
+
+    cdpRecord* prev = NULL;
+    for (cdpRecord* record = cdp_record_first(dict);  record;  record = cdp_record_next(dict, record)) {
+        if (prev)
+            assert_int(cdp_dt_compare(CDP_DT(&prev->metarecord), CDP_DT(&record->metarecord)), <, 0);
+        prev = record;
+    }
+}
+
+static void test_records_tech_array_keys(void) {
+    // Names spread over several domains, so both halves of the packed keys matter.
+    cdpID domain[] = {CDP_ACRO("CDP"), CDP_ACRO("ABC"), CDP_ACRO("XYZ")};
+    size_t domains = cdp_lengthof(domain);
+    size_t tags    = munit_rand_int_range(2, 64);
+    bool*  present = cdp_malloc0(domains * tags * sizeof(bool));
+
+    // Small capacity, so the array (and its keys) grows and slides around.
+    cdpRecord* dict = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_ARRAY, (size_t)2);
+    size_t steps = domains * tags * 2;
+    for (size_t n = 0;  n < steps;  n++) {
+        uint32_t value = munit_rand_uint32() % (domains * tags);
+        cdpRecord* found = cdp_record_find_by_name(dict, CDP_DTS(domain[value / tags], CDP_NAME_ENUMERATION + value % tags));
+        if (present[value]) {
+            assert_not_null(found);
+            cdp_record_delete(found);
+            present[value] = false;
+        } else {
+            assert_null(found);
+            cdp_dict_add_value(dict, CDP_DTS(domain[value / tags], CDP_NAME_ENUMERATION + value % tags), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+            present[value] = true;
+        }
+        if (!(n % 16))
+            tech_array_keys_check(dict, present, domain, domains, tags);
+    }
+    tech_array_keys_check(dict, present, domain, domains, tags);
+
+    // Ends are taken out too (moving the window start).
+    while (cdp_record_children(dict) > 1) {
+        cdpRecord* record = cdp_record_children(dict) & 1?  cdp_record_first(dict):  cdp_record_last(dict);
+        present[*(uint32_t*)cdp_record_data(record)] = false;
+        cdp_record_delete(record);
+        tech_array_keys_check(dict, present, domain, domains, tags);
+    }
+    cdp_record_delete(dict);
+
+    // A list turned into a dictionary gets its keys once sorted.
+    cdpRecord* list = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_ARRAY, (size_t)2);
+    memset(present, 0, domains * tags * sizeof(bool));
+    for (size_t n = 0;  n < steps;  n++) {
+        uint32_t value = munit_rand_uint32() % (domains * tags);
+        if (present[value])
+            continue;
+        cdp_record_append_value(list, CDP_DTS(domain[value / tags], CDP_NAME_ENUMERATION + value % tags), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        present[value] = true;
+    }
+    cdp_record_to_dictionary(list);
+    tech_array_keys_check(list, present, domain, domains, tags);
+
+    cdp_record_delete(list);
+    cdp_free(present);
+}
+
+static void test_records_tech_hash_table(void) {
+    size_t maxItems = munit_rand_int_range(2, 200);
+
+    cdpRecord* dictH = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+1), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_HASH_TABLE, 2);
+    cdpRecord* dictT = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+2), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_RED_BLACK_T);
+    cdpRecord* catH  = cdp_record_add_child(cdp_root(), CDP_TYPE_NORMAL, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+3), 0, NULL, cdp_store_new(CDP_DTAW("CDP", "catalog"), CDP_STORAGE_HASH_TABLE, CDP_INDEX_BY_HASH, (size_t)2, tech_value_compare));
+
+    cdpRecord* foundH, *foundT;
+
+    for (unsigned n = 0; n < maxItems;  n++) {
+        uint32_t value = 1 + (munit_rand_uint32() % maxItems);
+        cdpID name = CDP_NAME_ENUMERATION + value;
+
+        foundH = cdp_record_find_by_name(dictH, CDP_DTS(CDP_ACRO("CDP"), name));
+        foundT = cdp_record_find_by_name(dictT, CDP_DTS(CDP_ACRO("CDP"), name));
+        assert((!foundH && !foundT) || (foundH && foundT));
+        if (foundH) {
+            test_records_value(foundH, value);
+            cdp_record_delete(foundH);
+            cdp_record_delete(foundT);
+        }
+
+        if (cdp_record_children(dictH) && (munit_rand_int_range(0, 4) == 1)) {
+            foundH = cdp_record_first(dictH);
+            foundT = cdp_record_find_by_name(dictT, cdp_record_get_name(foundH));
+            assert_not_null(foundT);
+            cdp_record_delete(foundH);
+            cdp_record_delete(foundT);
+        }
+
+        cdp_record_add_value(dictH, CDP_DTS(CDP_ACRO("CDP"), name), 0, CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        cdp_record_add_value(dictT, CDP_DTS(CDP_ACRO("CDP"), name), 0, CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        assert_size(cdp_record_children(dictH), ==, cdp_record_children(dictT));
+
+        cdpRecord* recordT = cdp_record_first(dictT);
+        do {
+            foundH = cdp_record_find_by_name(dictH, cdp_record_get_name(recordT));
+            assert_not_null(foundH);
+            test_records_value(foundH, *(uint32_t*)cdp_record_data(recordT));
+            recordT = cdp_record_next(dictT, recordT);
+        } while (recordT);
+
+        size_t count = 0;
+        assert_true(cdp_record_traverse(dictH, (cdpTraverse) count_children, &count, NULL));
+        assert_size(count, ==, cdp_record_children(dictH));
+
+        // Hash indexed catalog.
+        cdpRecord key = {0};
+        cdp_record_initialize_value(&key, CDP_DTS(CDP_ACRO("CDP"), name), CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        foundH = cdp_record_find_by_key(catH, &key, tech_value_compare, NULL);
+        if (foundH) {
+            test_records_value(foundH, value);
+            cdp_record_finalize(&key);
+        } else {
+            foundH = cdp_record_add(catH, 0, &key);
+            assert_ptr_equal(foundH, cdp_record_find_by_position(catH, cdp_record_children(catH) - 1));
+        }
+    }
+
+    // Hash tables keep no order to sort.
+    assert_false(cdp_record_sort(dictH, tech_value_compare, NULL));
+    assert_true(cdp_record_is_dictionary(dictH));
+
+    cdp_record_delete(catH);
+    cdp_record_delete(dictT);
+    cdp_record_delete(dictH);
+}
+
+
+static void test_records_tech_content_hash(unsigned storage) {
+    // Hashes depend on all content bytes (and length).
+    uint8_t bytes[130];
+    for (unsigned n = 0;  n < sizeof(bytes);  n++)
+        bytes[n] = (uint8_t) munit_rand_uint32();
+    for (size_t size = 1;  size <= sizeof(bytes);  size++) {
+        uint64_t hash = cdp_hash64(bytes, size, 0);
+        assert_uint64(hash, ==, cdp_hash64(bytes, size, 0));
+        assert_uint64(hash, !=, cdp_hash64(bytes, size - 1, 0));
+        size_t pick = munit_rand_uint32() % size;
+        bytes[pick] ^= 0x10;
+        assert_uint64(hash, !=, cdp_hash64(bytes, size, 0));
+        bytes[pick] ^= 0x10;
+    }
+
+    // Data hash is kept until content changes.
+    uint32_t value = 1;
+    cdpRecord* single = cdp_record_add_value(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP), 0, CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+    assert_uint64(single->data->hash, ==, 0);
+    uint64_t hash = cdp_data_hash(single->data);
+    assert_uint64(hash, ==, cdp_hash64(&value, sizeof(value), 0));
+    assert_uint64(single->data->hash, ==, hash);
+    value = 2;
+    cdp_record_update_value(single, sizeof(uint32_t), &value);
+    assert_uint64(single->data->hash, ==, 0);
+    assert_uint64(cdp_data_hash(single->data), !=, hash);
+    cdp_record_delete(single);
+
+    // Hash indexed catalogs are kept in hash order (then by value).
+    size_t maxItems = munit_rand_int_range(2, 200);
+    cdpStore* store = (storage == CDP_STORAGE_ARRAY  ||  storage == CDP_STORAGE_INLINE)?
+                      cdp_store_new(CDP_DTAW("CDP", "catalog"), storage, CDP_INDEX_BY_HASH, (size_t)4, tech_value_compare):
+                      cdp_store_new(CDP_DTAW("CDP", "catalog"), storage, CDP_INDEX_BY_HASH, tech_value_compare);
+    cdpRecord* catalog = cdp_record_add_child(cdp_root(), CDP_TYPE_NORMAL, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP), 0, NULL, store);
+    for (unsigned n = 0;  n < maxItems;  n++) {
+        value = 1 + (munit_rand_uint32() % maxItems);
+        cdpRecord key = {0};
+        cdp_record_initialize_value(&key, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + value), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        cdpRecord* found = cdp_record_find_by_key(catalog, &key, tech_value_compare, NULL);
+        if (found) {
+            test_records_value(found, value);
+            cdp_record_finalize(&key);
+        } else {
+            found = cdp_record_add(catalog, 0, &key);
+            test_records_value(found, value);
+        }
+    }
+
+    uint64_t previous = 0;
+    for (cdpRecord* child = cdp_record_first(catalog);  child;  child = cdp_record_next(catalog, child)) {
+        hash = cdp_data_hash(child->data);
+        assert_uint64(hash, >, previous);       // (No two values share a hash here.)
+        previous = hash;
+    }
+
+    // Removals find their children in that same order (every other value goes).
+    for (value = 2;  value <= maxItems;  value += 2) {
+        cdpRecord key = {0};
+        cdp_record_initialize_value(&key, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + value), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        cdpRecord* found = cdp_record_find_by_key(catalog, &key, tech_value_compare, NULL);
+        cdp_record_finalize(&key);
+        if (found)
+            cdp_record_delete(found);
+    }
+    size_t count = 0;
+    previous = UINT64_MAX;
+    for (cdpRecord* child = cdp_record_last(catalog);  child;  child = cdp_record_prev(catalog, child), count++) {
+        assert_uint32(*(uint32_t*)cdp_record_data(child) & 1, ==, 1);
+        hash = cdp_data_hash(child->data);
+        assert_uint64(hash, <, previous);
+        previous = hash;
+    }
+    assert_size(count, ==, cdp_record_children(catalog));
+
+    cdp_record_delete(catalog);
+}
+
+
+static void tech_btree_check(cdpRecord* btree, cdpRecord* reference) {
+    assert_size(cdp_record_children(btree), ==, cdp_record_children(reference));
+    if (!cdp_record_children(reference))
+        return;
+
+    cdpRecord* recordB = cdp_record_first(btree);
+    cdpRecord* recordT = cdp_record_first(reference);
+    size_t position = 0;
+    do {
+        test_records_value(recordB, *(uint32_t*)cdp_record_data(recordT));
+        assert_size(cdp_record_index_of(recordT), ==, position);
+        if (!(position % 37)) {
+            assert_ptr_equal(recordB, cdp_record_find_by_position(btree, position));
+            assert_ptr_equal(recordT, cdp_record_find_by_position(reference, position));
+            assert_size(cdp_record_index_of(recordB), ==, position);
+        }
+        recordB = cdp_record_next(btree, recordB);
+        recordT = cdp_record_next(reference, recordT);
+        position++;
+    } while (recordT);
+    assert_null(recordB);
+
+    recordB = cdp_record_last(btree);
+    recordT = cdp_record_last(reference);
+    do {
+        test_records_value(recordB, *(uint32_t*)cdp_record_data(recordT));
+        recordB = cdp_record_prev(btree, recordB);
+        recordT = cdp_record_prev(reference, recordT);
+    } while (recordT);
+    assert_null(recordB);
+}
+
+static void test_records_tech_btree(void) {
+    size_t maxItems = munit_rand_int_range(500, 3000);     // Enough to split leaves and inner nodes.
+
+    cdpRecord* dictB = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+1), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_BTREE);
+    cdpRecord* dictT = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+2), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_RED_BLACK_T);
+    cdpRecord* catB  = cdp_record_add_catalog(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+3), 0, CDP_DTAW("CDP", "catalog"), CDP_STORAGE_BTREE, tech_value_compare);
+    cdpRecord* catT  = cdp_record_add_catalog(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+4), 0, CDP_DTAW("CDP", "catalog"), CDP_STORAGE_RED_BLACK_T, tech_value_compare);
+
+    cdpRecord* foundB, *foundT;
+
+    for (unsigned n = 0; n < maxItems;  n++) {
+        uint32_t value = 1 + (munit_rand_uint32() % maxItems);
+        cdpID name = CDP_NAME_ENUMERATION + value;
+
+        foundB = cdp_record_find_by_name(dictB, CDP_DTS(CDP_ACRO("CDP"), name));
+        foundT = cdp_record_find_by_name(dictT, CDP_DTS(CDP_ACRO("CDP"), name));
+        assert((!foundB && !foundT) || (foundB && foundT));
+        if (foundB) {
+            test_records_value(foundB, value);
+            cdp_record_delete(foundB);
+            cdp_record_delete(foundT);
+        } else {
+            cdp_record_add_value(dictB, CDP_DTS(CDP_ACRO("CDP"), name), 0, CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+            cdp_record_add_value(dictT, CDP_DTS(CDP_ACRO("CDP"), name), 0, CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        }
+
+        cdpRecord key = {0};
+        cdp_record_initialize_value(&key, CDP_DTS(CDP_ACRO("CDP"), name), CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        foundB = cdp_record_find_by_key(catB, &key, tech_value_compare, NULL);
+        foundT = cdp_record_find_by_key(catT, &key, tech_value_compare, NULL);
+        assert((!foundB && !foundT) || (foundB && foundT));
+        if (foundB) {
+            cdp_record_finalize(&key);
+            cdp_record_delete(foundB);
+            cdp_record_delete(foundT);
+        } else {
+            cdp_record_add(catT, 0, &key);
+            cdp_record_initialize_value(&key, CDP_DTS(CDP_ACRO("CDP"), name), CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+            cdp_record_add(catB, 0, &key);
+        }
+
+        if (cdp_record_children(catB) > 1) {
+            switch (munit_rand_int_range(0, 16)) {
+              case 1:
+                cdp_record_delete(cdp_record_first(catB));
+                cdp_record_delete(cdp_record_first(catT));
+                break;
+              case 2:
+                cdp_record_delete(cdp_record_last(catB));
+                cdp_record_delete(cdp_record_last(catT));
+                break;
+            }
+        }
+
+        if (!(n % 64)) {
+            tech_btree_check(dictB, dictT);
+            tech_btree_check(catB, catT);
+        }
+    }
+
+    tech_btree_check(dictB, dictT);
+    tech_btree_check(catB, catT);
+
+    size_t count = 0;
+    assert_true(cdp_record_traverse(dictB, (cdpTraverse) count_children, &count, NULL));
+    assert_size(count, ==, cdp_record_children(dictB));
+
+    // Sorting rebuilds the tree in the new order (and removals keep merging its leaves).
+    assert_true(cdp_record_sort(dictB, tech_value_descending, NULL));
+    for (unsigned pass = 0;  pass < 2;  pass++) {
+        cdpRecord* recordB = cdp_record_first(dictB);
+        for (cdpRecord* recordT = cdp_record_last(dictT);  recordT;  recordT = cdp_record_prev(dictT, recordT)) {
+            uint32_t value = *(uint32_t*)cdp_record_data(recordT);
+            test_records_value(recordB, value);
+            assert_ptr_equal(cdp_record_find_by_key(dictB, recordT, tech_value_descending, NULL), recordB);
+            recordB = cdp_record_next(dictB, recordB);
+        }
+        assert_null(recordB);
+
+        for (cdpRecord* recordT = cdp_record_first(dictT), *nextT;  recordT;  recordT = nextT) {
+            nextT = cdp_record_next(dictT, recordT);
+            if (munit_rand_int_range(0, 4)) {
+                cdp_record_delete(cdp_record_find_by_key(dictB, recordT, tech_value_descending, NULL));
+                cdp_record_delete(recordT);
+            }
+        }
+        assert_size(cdp_record_children(dictB), ==, cdp_record_children(dictT));
+    }
+
+    cdp_record_delete(catT);
+    cdp_record_delete(catB);
+    cdp_record_delete(dictT);
+    cdp_record_delete(dictB);
+}
+
+
+static void test_records_tech_storage_switch(void) {
+    size_t maxItems = munit_rand_int_range(100, 300);
+    cdpStoreTuning tuning = CDP_STORE_TUNING_DEFAULT;
+    tuning.minOps = maxItems;
+
+    // A list accessed mostly by position moves into an array.
+    cdpRecord* list = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+1), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_LINKED_LIST);
+    cdp_store_profile(list->store, true);
+    for (uint32_t value = 1;  value <= maxItems;  value++)
+        cdp_record_append_value(list, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION+value), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION+value), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+    cdpRecord* nested = cdp_record_append_list(list, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP), CDP_DTAW("CDP", "list"), CDP_STORAGE_LINKED_LIST);
+    uint32_t value = 1;
+    cdpRecord* item = cdp_record_append_value(nested, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+    for (unsigned n = 0;  n < 2 * maxItems;  n++)
+        cdp_record_find_by_position(list, munit_rand_uint32() % maxItems);
+    assert_uint(cdp_store_advise(list->store, &tuning), ==, CDP_STORAGE_ARRAY);
+    assert_true(cdp_record_adapt_storage(list, &tuning));
+    assert_uint(list->store->storage, ==, CDP_STORAGE_ARRAY);
+    assert_size(cdp_record_children(list), ==, maxItems + 1);
+    cdpRecord* found = cdp_record_first(list);
+    for (uint32_t n = 1;  n <= maxItems;  n++) {
+        test_records_value(found, n);
+        found = cdp_record_next(list, found);
+    }
+    nested = cdp_record_last(list);
+    item = cdp_record_first(nested);
+    assert_ptr_equal(cdp_record_parent(item), nested);
+    assert_ptr_equal(cdp_record_parent(nested), list);
+    cdp_record_delete(nested);
+
+    // Then, as a FIFO, it moves into a packed queue.
+    for (unsigned n = 0;  n < 2 * maxItems;  n++) {
+        cdp_record_delete(cdp_record_first(list));
+        value = maxItems + n + 1;
+        cdp_record_append_value(list, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION+value), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION+value), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+    }
+    assert_true(cdp_record_adapt_storage(list, &tuning));
+    assert_uint(list->store->storage, ==, CDP_STORAGE_PACKED_QUEUE);
+    found = cdp_record_first(list);
+    for (uint32_t n = 2 * maxItems + 1;  found;  n++) {
+        test_records_value(found, n);
+        found = cdp_record_next(list, found);
+    }
+    assert_false(cdp_record_adapt_storage(list, &tuning));     // No new observations.
+    cdp_record_delete(list);
+
+    // A large dictionary looked up by name moves into a red-black tree.
+    cdpRecord* dict = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+2), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_ARRAY, 8);
+    cdp_store_profile(dict->store, true);
+    for (unsigned n = 0;  n < maxItems;  n++) {
+        value = munit_rand_int_range(1, 10000);
+        if (!cdp_record_find_by_name(dict, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION+value)))
+            cdp_record_add_value(dict, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION+value), 0, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION+value), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+    }
+    size_t children = cdp_record_children(dict);
+    assert_true(cdp_record_adapt_storage(dict, &tuning));
+    assert_uint(dict->store->storage, ==, CDP_STORAGE_RED_BLACK_T);
+    assert_size(cdp_record_children(dict), ==, children);
+    cdpRecord* prev = cdp_record_first(dict);
+    for (found = cdp_record_next(dict, prev);  found;  prev = found, found = cdp_record_next(dict, found)) {
+        assert_uint(*(uint32_t*)cdp_record_data(prev), <, *(uint32_t*)cdp_record_data(found));
+        assert_ptr_equal(cdp_record_find_by_name(dict, cdp_record_get_name(found)), found);
+    }
+    cdp_record_delete(dict);
+}
+
+
+typedef struct {
+    float       min[3], max[3];     // Query box.
+    float       center[3];          // Query sphere center or ray origin.
+    float       vector[3];          // Ray direction.
+    float       radius;             // Query sphere radius or ray length.
+    unsigned    kind;
+    size_t      hits;
+} TechSpatialQuery;
+
+enum {TECH_SPATIAL_BOX, TECH_SPATIAL_SPHERE, TECH_SPATIAL_RAY};
+
+static int tech_spatial_compare(const cdpRecord* record, const cdpRecord* unused, void* context) {
+    const cdpOctreeBound* bound = context;
+    const float* item = cdp_record_data(record);
+    for (unsigned i = 0;  i < 3;  i++) {
+        if (fabsf(item[i] - bound->center[i]) + item[3] > bound->subwide)
+            return 0;
+    }
+    return 1;
+}
+
+static void tech_spatial_locate(const cdpRecord* record, void* context, float center[3], float* radius) {
+    const float* item = cdp_record_data(record);
+    memcpy(center, item, 3 * sizeof(float));
+    *radius = item[3];
+}
+
+static bool tech_spatial_hit(const float* item, const TechSpatialQuery* query, float slack) {
+    // Brute force check (with some slack for rounding).
+    float r = item[3] + slack;
+    switch (query->kind) {
+      case TECH_SPATIAL_BOX: {
+        float d2 = 0.0f;
+        for (unsigned i = 0;  i < 3;  i++) {
+            float d = (item[i] < query->min[i])?  query->min[i] - item[i]:  (item[i] > query->max[i])?  item[i] - query->max[i]:  0.0f;
+            d2 += d * d;
+        }
+        return sqrtf(d2) <= r;     // Not squared: the slack may turn r negative.
+      }
+      case TECH_SPATIAL_SPHERE: {
+        float d2 = 0.0f;
+        for (unsigned i = 0;  i < 3;  i++)
+            d2 += (item[i] - query->center[i]) * (item[i] - query->center[i]);
+        return sqrtf(d2) <= query->radius + r;
+      }
+      default: {
+        float dd = 0.0f, t = 0.0f, d2 = 0.0f;
+        for (unsigned i = 0;  i < 3;  i++) {
+            dd += query->vector[i] * query->vector[i];
+            t  += (item[i] - query->center[i]) * query->vector[i];
+        }
+        t = fminf(fmaxf(t / dd, 0.0f), query->radius);
+        for (unsigned i = 0;  i < 3;  i++) {
+            float d = query->center[i] + t * query->vector[i] - item[i];
+            d2 += d * d;
+        }
+        return sqrtf(d2) <= r;     // Not squared: the slack may turn r negative.
+      }
+    }
+}
+
+static bool tech_spatial_count(cdpRecord* record, float distance, TechSpatialQuery* query) {
+    assert_true(tech_spatial_hit(cdp_record_data(record), query, 1e-3f));
+    query->hits++;
+    return true;
+}
+
+static void test_records_tech_spatial(void) {
+    size_t maxItems = munit_rand_int_range(50, 2000);
+    float  center[3] = {0.0f, 0.0f, 0.0f};
+    float (*items)[4] = cdp_malloc(maxItems * sizeof(*items));
+    bool*  alive = cdp_malloc0(maxItems * sizeof(bool));
+
+    cdpRecord* space = cdp_record_add_child(cdp_root(), CDP_TYPE_NORMAL, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP), 0, NULL, cdp_store_new(CDP_DTAW("CDP", "space"), CDP_STORAGE_OCTREE, CDP_INDEX_BY_FUNCTION, center, 128.0, tech_spatial_compare));
+    cdp_store_octree_limits(space->store, 1 + munit_rand_uint32() % 16, 4 + munit_rand_uint32() % 16);
+
+    for (size_t n = 0;  n < maxItems;  n++) {
+        for (unsigned i = 0;  i < 3;  i++)
+            items[n][i] = (float)(munit_rand_uint32() % 20000) / 100.0f - 100.0f;
+        items[n][3] = (munit_rand_uint32() & 1)?  (float)(munit_rand_uint32() % 200) / 100.0f:  0.0f;
+        cdpID name = CDP_NAME_ENUMERATION + n;
+        cdp_record_add_value(space, CDP_DTS(CDP_ACRO("CDP"), name), 0, CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), items[n], sizeof(items[n]), sizeof(items[n]));
+        alive[n] = true;
+    }
+
+    for (unsigned round = 0;  round < 2;  round++) {
+        for (unsigned q = 0;  q < 16;  q++) {
+            TechSpatialQuery query = {.kind = q % 3};
+            for (unsigned i = 0;  i < 3;  i++) {
+                float a = (float)(munit_rand_uint32() % 24000) / 100.0f - 120.0f;
+                float b = (float)(munit_rand_uint32() % 24000) / 100.0f - 120.0f;
+                query.min[i] = fminf(a, b);
+                query.max[i] = fmaxf(a, b);
+                query.center[i] = a;
+                query.vector[i] = b - a;
+            }
+            query.radius = (query.kind == TECH_SPATIAL_RAY)?  1.0f:  (float)(munit_rand_uint32() % 6000) / 100.0f;
+
+            switch (query.kind) {
+              case TECH_SPATIAL_BOX:    assert_true(cdp_record_spatial_box(space, query.min, query.max, tech_spatial_locate, (cdpSpatialFunc) tech_spatial_count, &query));   break;
+              case TECH_SPATIAL_SPHERE: assert_true(cdp_record_spatial_sphere(space, query.center, query.radius, tech_spatial_locate, (cdpSpatialFunc) tech_spatial_count, &query));   break;
+              default:                  assert_true(cdp_record_spatial_ray(space, query.center, query.vector, query.radius, tech_spatial_locate, (cdpSpatialFunc) tech_spatial_count, &query));   break;
+            }
+
+            size_t expected = 0;
+            for (size_t n = 0;  n < maxItems;  n++) {
+                if (alive[n] && tech_spatial_hit(items[n], &query, -1e-3f))
+                    expected++;
+            }
+            assert_size(query.hits, >=, expected);
+        }
+
+        // Nearest neighbours.
+        cdpRecord* nearest[8];
+        float distance[8], bruteDist[8];
+        size_t k = 1 + munit_rand_uint32() % 8, found = 0;
+        size_t count = cdp_record_spatial_nearest(space, center, k, tech_spatial_locate, NULL, nearest, distance);
+        for (size_t n = 0;  n < maxItems;  n++) {
+            if (!alive[n])
+                continue;
+            float d = fmaxf(sqrtf(items[n][0]*items[n][0] + items[n][1]*items[n][1] + items[n][2]*items[n][2]) - items[n][3], 0.0f);
+            size_t i;
+            if (found < k)
+                i = found++;
+            else if (d < bruteDist[k - 1])
+                i = k - 1;
+            else
+                continue;
+            for (;  i && bruteDist[i - 1] > d;  i--)
+                bruteDist[i] = bruteDist[i - 1];
+            bruteDist[i] = d;
+        }
+        assert_size(count, ==, found);
+        for (size_t i = 0;  i < count;  i++) {
+            assert_float(fabsf(distance[i] - bruteDist[i]), <, 1e-3f);
+            if (i)
+                assert_float(distance[i - 1], <=, distance[i]);
+        }
+
+        if (round)
+            break;
+
+        // Remove half the items before querying again.
+        for (size_t n = 0;  n < maxItems;  n += 2) {
+            cdp_record_delete(cdp_record_find_by_name(space, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + n)));
+            alive[n] = false;
+        }
+        assert_size(cdp_record_children(space), ==, maxItems >> 1);
+    }
+
+    // Emptied trees collapse back into the root and can be refilled.
+    for (size_t n = 1;  n < maxItems;  n += 2)
+        cdp_record_delete(cdp_record_find_by_name(space, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + n)));
+    assert_size(cdp_record_children(space), ==, 0);
+    assert_null(cdp_record_first(space));
+    for (size_t n = 0;  n < 4;  n++) {
+        cdpID name = CDP_NAME_ENUMERATION + n;
+        cdp_record_add_value(space, CDP_DTS(CDP_ACRO("CDP"), name), 0, CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), items[n], sizeof(items[n]), sizeof(items[n]));
+    }
+    TechSpatialQuery all = {.kind = TECH_SPATIAL_SPHERE, .radius = 1000.0f};
+    assert_true(cdp_record_spatial_sphere(space, center, all.radius, tech_spatial_locate, (cdpSpatialFunc) tech_spatial_count, &all));
+    assert_size(all.hits, ==, 4);
+
+    cdp_record_delete(space);
+    cdp_free(alive);
+    cdp_free(items);
+}
+
+
+typedef struct {
+    cdpRecord*  dict;
+    unsigned    first;          // First value (name) owned by this thread.
+    unsigned    count;
+    unsigned    failures;
+} TechSkiplistWorker;
+
+#define TECH_SKIPLIST_SHARED    64
+
+static void* tech_skiplist_worker(TechSkiplistWorker* worker) {
+    cdp_store_thread_online();
+    for (unsigned n = 0;  n < worker->count;  n++) {
+        uint32_t value = worker->first + n;
+        cdpID name = CDP_NAME_ENUMERATION + value;
+        cdpRecord* item = cdp_record_add_value(worker->dict, CDP_DTS(CDP_ACRO("CDP"), name), 0, CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        if (!item  ||  *(uint32_t*)cdp_record_data(item) != value)
+            worker->failures++;
+
+        // Everyone races to remove the same shared items.
+        cdpRecord* shared = cdp_record_find_by_name(worker->dict, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + (n % TECH_SKIPLIST_SHARED)));
+        if (shared)
+            cdp_record_delete(shared);
+
+        // Own odd items go away too.
+        if (n & 1) {
+            cdpRecord* found = cdp_record_find_by_name(worker->dict, CDP_DTS(CDP_ACRO("CDP"), name));
+            if (found != item)
+                worker->failures++;
+            cdp_record_delete(found);
+        }
+        if (!(n % 16))
+            cdp_store_quiescent();
+    }
+    cdp_store_thread_offline();
+    return NULL;
+}
+
+#define TECH_SKIPLIST_LINKS     0x10000     // Offset of the link names.
+
+static void* tech_skiplist_link_worker(TechSkiplistWorker* worker) {
+    cdp_store_thread_online();
+    for (unsigned n = 0;  n < worker->count;  n++) {
+        uint32_t value = worker->first + n;
+        cdpID name = CDP_NAME_ENUMERATION + value;
+        cdpRecord* item = cdp_record_add_value(worker->dict, CDP_DTS(CDP_ACRO("CDP"), name), 0, CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        cdpRecord* link = cdp_dict_add_link(worker->dict, CDP_DTS(CDP_ACRO("CDP"), name + TECH_SKIPLIST_LINKS), item);
+        cdpRecord* pulled = link?  cdp_link_pull(link):  NULL;
+        if (!pulled  ||  *(uint32_t*)cdp_record_data(pulled) != value)
+            worker->failures++;
+
+        // Odd targets go away (their links are nulled once reclaimed), then the links too.
+        if (n & 1) {
+            cdp_record_delete(item);
+            cdp_record_delete(link);
+        }
+        if (!(n % 16))
+            cdp_store_quiescent();
+    }
+    cdp_store_thread_offline();
+    return NULL;
+}
+
+static void test_records_tech_skiplist(void) {
+    size_t maxItems = munit_rand_int_range(2, 500);
+
+    cdpRecord* dictS = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+1), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_SKIPLIST);
+    cdpRecord* dictT = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+2), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_RED_BLACK_T);
+
+    // Single threaded use against a red-black tree.
+    for (unsigned n = 0;  n < maxItems;  n++) {
+        uint32_t value = 1 + (munit_rand_uint32() % maxItems);
+        cdpID name = CDP_NAME_ENUMERATION + value;
+
+        cdpRecord* foundT = cdp_record_find_by_name(dictT, CDP_DTS(CDP_ACRO("CDP"), name));
+        cdpRecord* foundS = cdp_record_find_by_name(dictS, CDP_DTS(CDP_ACRO("CDP"), name));
+        assert((!foundT && !foundS) || (foundT && foundS));
+        if (foundS) {
+            assert_null(cdp_record_add_value(dictS, CDP_DTS(CDP_ACRO("CDP"), name), 0, CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t)));
+            cdp_record_delete(foundT);
+            cdp_record_delete(foundS);
+        } else {
+            cdp_record_add_value(dictT, CDP_DTS(CDP_ACRO("CDP"), name), 0, CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+            cdpRecord* item = cdp_record_add_value(dictS, CDP_DTS(CDP_ACRO("CDP"), name), 0, CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+            test_records_value(item, value);
+        }
+        if (cdp_record_children(dictT) > 2  &&  !(n % 7)) {
+            cdpRecord tempT = {0}, tempS = {0};
+            if (n & 1) {
+                cdp_record_child_pop(dictT, &tempT);
+                assert_true(cdp_record_child_pop(dictS, &tempS));
+            } else {
+                cdp_record_child_take(dictT, &tempT);
+                assert_true(cdp_record_child_take(dictS, &tempS));
+            }
+            assert_true(cdp_record_name_is(&tempS, cdp_record_get_name(&tempT)));
+            cdp_record_finalize(&tempT);
+            cdp_record_finalize(&tempS);
+        }
+        assert_size(cdp_record_children(dictS), ==, cdp_record_children(dictT));
+        if (!cdp_record_children(dictT))
+            continue;
+
+        cdpRecord* recordT = cdp_record_first(dictT);
+        cdpRecord* recordS = cdp_record_first(dictS);
+        size_t position = 0;
+        do {
+            test_records_value(recordS, *(uint32_t*)cdp_record_data(recordT));
+            assert_size(cdp_record_index_of(recordS), ==, position++);
+            recordT = cdp_record_next(dictT, recordT);
+            recordS = cdp_record_next(dictS, recordS);
+        } while (recordT);
+        assert_null(recordS);
+
+        recordT = cdp_record_last(dictT);
+        recordS = cdp_record_last(dictS);
+        do {
+            test_records_value(recordS, *(uint32_t*)cdp_record_data(recordT));
+            recordT = cdp_record_prev(dictT, recordT);
+            recordS = cdp_record_prev(dictS, recordS);
+        } while (recordT);
+        assert_null(recordS);
+    }
+    cdp_record_delete(dictT);
+    cdp_record_delete_children(dictS);
+
+    // Several writers (and removers) at once.
+    for (uint32_t value = 0;  value < TECH_SKIPLIST_SHARED;  value++)
+        cdp_record_add_value(dictS, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + value), 0, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + value), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+    enum {WORKERS = 4};
+    pthread_t thread[WORKERS];
+    TechSkiplistWorker worker[WORKERS];
+    for (unsigned w = 0;  w < WORKERS;  w++) {
+        worker[w] = (TechSkiplistWorker){.dict = dictS, .first = TECH_SKIPLIST_SHARED + (w * (unsigned)maxItems), .count = (unsigned)maxItems};
+        pthread_create(&thread[w], NULL, (void*(*)(void*)) tech_skiplist_worker, &worker[w]);
+    }
+    for (unsigned w = 0;  w < WORKERS;  w++) {
+        pthread_join(thread[w], NULL);
+        assert_uint(worker[w].failures, ==, 0);
+    }
+
+    size_t expected = WORKERS * ((maxItems + 1) >> 1);
+    for (unsigned n = 0;  n < TECH_SKIPLIST_SHARED;  n++) {
+        if (cdp_record_find_by_name(dictS, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + n)))
+            expected++;
+    }
+    assert_size(cdp_record_children(dictS), ==, expected);
+
+    cdpRecord* prev = cdp_record_first(dictS);
+    for (cdpRecord* found = cdp_record_next(dictS, prev);  found;  prev = found, found = cdp_record_next(dictS, found)) {
+        uint32_t value = *(uint32_t*)cdp_record_data(found);
+        assert_uint(*(uint32_t*)cdp_record_data(prev), <, value);
+        assert_true(value < TECH_SKIPLIST_SHARED  ||  !((value - TECH_SKIPLIST_SHARED) % maxItems & 1));
+    }
+
+    // Links (and their targets) added and deleted from several threads at once.
+    cdp_record_delete_children(dictS);
+    for (unsigned w = 0;  w < WORKERS;  w++) {
+        worker[w] = (TechSkiplistWorker){.dict = dictS, .first = w * (unsigned)maxItems, .count = (unsigned)maxItems};
+        pthread_create(&thread[w], NULL, (void*(*)(void*)) tech_skiplist_link_worker, &worker[w]);
+    }
+    for (unsigned w = 0;  w < WORKERS;  w++) {
+        pthread_join(thread[w], NULL);
+        assert_uint(worker[w].failures, ==, 0);
+    }
+    assert_size(cdp_record_children(dictS), ==, 2 * WORKERS * ((maxItems + 1) >> 1));
+    for (unsigned n = 0;  n < WORKERS * maxItems;  n++) {
+        cdpRecord* link = cdp_record_find_by_name(dictS, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + n + TECH_SKIPLIST_LINKS));
+        if ((n % maxItems) & 1) {
+            assert_null(link);
+        } else {
+            assert_not_null(link);
+            test_records_value(cdp_link_pull(link), n);
+        }
+    }
+
+    cdp_record_delete(dictS);
+}
+
+
+static cdpDT* tech_art_name(uint32_t value, cdpDT* name) {
+    // Values spread over three domains: one with dense tags, the others with scattered ones (all name bytes vary).
+    switch (value % 3) {
+      case 0:   name->domain = CDP_ACRO("CDP");  name->tag = CDP_NAME_ENUMERATION + value;  break;
+      case 1:   name->domain = CDP_ACRO("ART");  name->tag = cdp_id_to_numeric(((cdpID)value * 0x9E3779B97F4A7C15ULL) & CDP_AUTOID_MAXVAL);  break;
+      default:  name->domain = CDP_ACRO("KEY");  name->tag = cdp_id_to_numeric(((cdpID)value * 0x2545F4914F6CDD1DULL) & CDP_AUTOID_MAXVAL);  break;
+    }
+    return name;
+}
+
+static bool tech_art_count(cdpEntry* entry, size_t* count) {
+    assert_true(!entry->prev  ||  0 > cdp_dt_compare(cdp_record_get_name(entry->prev), cdp_record_get_name(entry->record)));
+    (*count)++;
+    return true;
+}
+
+static void test_records_tech_art(void) {
+    size_t maxItems = munit_rand_int_range(500, 4000);     // Enough to grow nodes up to 256 branches.
+
+    cdpRecord* dictA = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+1), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_ART);
+    cdpRecord* dictT = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+2), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_RED_BLACK_T);
+
+    cdpRecord* foundA, *foundT;
+    cdpDT name;
+
+    for (unsigned n = 0; n < maxItems;  n++) {
+        uint32_t value = 1 + (munit_rand_uint32() % maxItems);
+        tech_art_name(value, &name);
+
+        foundA = cdp_record_find_by_name(dictA, &name);
+        foundT = cdp_record_find_by_name(dictT, &name);
+        assert((!foundA && !foundT) || (foundA && foundT));
+        if (foundA) {
+            test_records_value(foundA, value);
+            cdp_record_delete(foundA);
+            cdp_record_delete(foundT);
+        } else {
+            cdp_record_add_value(dictA, &name, 0, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+            cdp_record_add_value(dictT, &name, 0, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        }
+
+        if (cdp_record_children(dictA) > 1) {
+            cdpRecord taken = {0};
+            switch (munit_rand_int_range(0, 16)) {
+              case 1:
+                assert_true(cdp_record_child_pop(dictA, &taken));
+                test_records_value(&taken, *(uint32_t*)cdp_record_data(cdp_record_first(dictT)));
+                cdp_record_finalize(&taken);
+                cdp_record_delete(cdp_record_first(dictT));
+                break;
+              case 2:
+                assert_true(cdp_record_child_take(dictA, &taken));
+                test_records_value(&taken, *(uint32_t*)cdp_record_data(cdp_record_last(dictT)));
+                cdp_record_finalize(&taken);
+                cdp_record_delete(cdp_record_last(dictT));
+                break;
+            }
+        }
+
+        if (!(n % 64))
+            tech_btree_check(dictA, dictT);
+    }
+    tech_btree_check(dictA, dictT);
+
+    // Walks each domain group (and nothing else).
+    size_t total = 0;
+    const char* domain[] = {"CDP", "ART", "KEY", "NONE"};
+    for (unsigned d = 0;  d < cdp_lengthof(domain);  d++) {
+        cdpID acro = cdp_text_to_acronym(domain[d]);
+        size_t countA = 0, countT = 0;
+        assert_true(cdp_record_traverse_domain(dictA, acro, (cdpTraverse) tech_art_count, &countA, NULL));
+        assert_true(cdp_record_traverse_domain(dictT, acro, (cdpTraverse) tech_art_count, &countT, NULL));
+        assert_size(countA, ==, countT);
+        total += countA;
+    }
+    assert_size(total, ==, cdp_record_children(dictA));
+
+    // Hash tables don't keep names sorted, so a domain may show up again after others.
+    uint32_t one = 1;
+    cdpRecord* dictH = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+3), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_HASH_TABLE, (size_t)4);
+    cdp_dict_add_value(dictH, CDP_DTS(CDP_ACRO("AAA"), CDP_NAME_ENUMERATION + 1), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &one, sizeof(uint32_t), sizeof(uint32_t));
+    cdp_dict_add_value(dictH, CDP_DTS(CDP_ACRO("ZZZ"), CDP_NAME_ENUMERATION + 1), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &one, sizeof(uint32_t), sizeof(uint32_t));
+    cdp_dict_add_value(dictH, CDP_DTS(CDP_ACRO("AAA"), CDP_NAME_ENUMERATION + 2), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &one, sizeof(uint32_t), sizeof(uint32_t));
+    size_t countH = 0;
+    assert_true(cdp_record_traverse_domain(dictH, CDP_ACRO("AAA"), (cdpTraverse) tech_art_count, &countH, NULL));
+    assert_size(countH, ==, 2);
+    cdp_record_delete(dictH);
+
+    // A red-black tree dictionary moves into a radix tree.
+    assert_true(cdp_record_convert_storage(dictT, CDP_STORAGE_ART));
+    assert_uint(dictT->store->storage, ==, CDP_STORAGE_ART);
+    tech_btree_check(dictT, dictA);
+
+    cdp_record_delete(dictT);
+    cdp_record_delete(dictA);
+}
+
+
+static void test_records_tech_inline(void) {
+    size_t capacity = munit_rand_int_range(1, 16);
+
+    cdpRecord* dictI = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+1), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_INLINE, capacity);
+    cdpRecord* dictT = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+2), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_RED_BLACK_T);
+    cdpRecord* catI  = cdp_record_add_catalog(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+3), 0, CDP_DTAW("CDP", "catalog"), CDP_STORAGE_INLINE, capacity, tech_value_compare);
+    cdpRecord* catT  = cdp_record_add_catalog(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+4), 0, CDP_DTAW("CDP", "catalog"), CDP_STORAGE_RED_BLACK_T, tech_value_compare);
+
+    // Fills them up (staying inline), then overflows them into arrays.
+    for (unsigned n = 0;  n <= capacity;  n++) {
+        uint32_t value = munit_rand_int_range(1, 1000);
+        cdpID name = CDP_NAME_ENUMERATION + value;
+        if (cdp_record_find_by_name(dictT, CDP_DTS(CDP_ACRO("CDP"), name))) {
+            n--;
+            continue;
+        }
+
+        // Children with their own store must follow their owner when moved.
+        cdpRecord* listI = cdp_record_add_list(dictI, CDP_DTS(CDP_ACRO("CDP"), name), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_INLINE, (size_t)1);
+        cdp_record_add_value(listI, CDP_DTS(CDP_ACRO("CDP"), name), 0, CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        cdp_record_add_value(dictT, CDP_DTS(CDP_ACRO("CDP"), name), 0, CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        assert_uint(dictI->store->storage, ==, (n < capacity)?  CDP_STORAGE_INLINE:  CDP_STORAGE_ARRAY);
+
+        cdp_record_add_value(catI, CDP_DTS(CDP_ACRO("CDP"), name), 0, CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        cdp_record_add_value(catT, CDP_DTS(CDP_ACRO("CDP"), name), 0, CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        tech_btree_check(catI, catT);
+
+        assert_size(cdp_record_children(dictI), ==, cdp_record_children(dictT));
+        cdpRecord* recordI = cdp_record_first(dictI);
+        cdpRecord* recordT = cdp_record_first(dictT);
+        do {
+            cdpRecord* inner = cdp_record_first(recordI);
+            assert_ptr_equal(cdp_record_parent(inner), recordI);
+            test_records_value(inner, *(uint32_t*)cdp_record_data(recordT));
+            assert_ptr_equal(cdp_record_find_by_name(dictI, cdp_record_get_name(recordT)), recordI);
+            recordI = cdp_record_next(dictI, recordI);
+            recordT = cdp_record_next(dictT, recordT);
+        } while (recordT);
+        assert_null(recordI);
+    }
+    assert_uint(dictI->store->storage, ==, CDP_STORAGE_ARRAY);
+    assert_uint(catI->store->storage,  ==, CDP_STORAGE_ARRAY);
+
+    // Back inline once there is room again.
+    cdp_record_delete(cdp_record_last(catI));
+    cdp_record_delete(cdp_record_last(catT));
+    assert_true(cdp_record_convert_storage(catI, CDP_STORAGE_INLINE));
+    tech_btree_check(catI, catT);
+
+    cdp_record_delete(catT);
+    cdp_record_delete(catI);
+    cdp_record_delete(dictT);
+    cdp_record_delete(dictI);
+}
+
+
+static void test_records_tech_filter(unsigned storage) {
+    size_t maxItems = munit_rand_int_range(2, 1000);
+
+    cdpRecord* listF = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+1), 0, CDP_DTAW("CDP", "list"), storage, (size_t)4);
+    cdpRecord* listL = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+2), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_LINKED_LIST);
+    cdp_store_filter(listF->store, true);
+
+    for (unsigned n = 0;  n < maxItems;  n++) {
+        uint32_t value = munit_rand_int_range(1, 2000);
+        cdpID name = CDP_NAME_ENUMERATION + value;
+
+        cdpRecord* foundF = cdp_record_find_by_name(listF, CDP_DTS(CDP_ACRO("CDP"), name));
+        cdpRecord* foundL = cdp_record_find_by_name(listL, CDP_DTS(CDP_ACRO("CDP"), name));
+        assert((!foundF && !foundL) || (foundF && foundL));
+        if (foundF) {
+            test_records_value(foundF, value);
+            uintptr_t idx = 0;
+            assert_ptr_equal(cdp_record_find_next_by_name(listF, CDP_DTS(CDP_ACRO("CDP"), name), &idx), foundF);
+            cdp_record_delete(foundF);
+            cdp_record_delete(foundL);
+        } else {
+            cdp_record_append_value(listF, CDP_DTS(CDP_ACRO("CDP"), name), CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+            cdp_record_append_value(listL, CDP_DTS(CDP_ACRO("CDP"), name), CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        }
+
+        if (cdp_record_children(listL) > 1  &&  !munit_rand_int_range(0, 8)) {
+            cdpRecord tempF = {0}, tempL = {0};
+            if (munit_rand_uint32() & 1) {
+                cdp_record_child_pop(listF, &tempF);
+                cdp_record_child_pop(listL, &tempL);
+            } else {
+                cdp_record_child_take(listF, &tempF);
+                cdp_record_child_take(listL, &tempL);
+            }
+            cdp_record_finalize(&tempF);
+            cdp_record_finalize(&tempL);
+        }
+
+        if (!munit_rand_int_range(0, 200)) {
+            // Bulk delete (leaving the filter full of stale names).
+            while (cdp_record_children(listL) > 1) {
+                cdp_record_delete(cdp_record_last(listF));
+                cdp_record_delete(cdp_record_last(listL));
+            }
+        }
+        assert_size(cdp_record_children(listF), ==, cdp_record_children(listL));
+    }
+
+    // Every remaining child is still found.
+    for (cdpRecord* recordL = cdp_record_first(listL);  recordL;  recordL = cdp_record_next(listL, recordL)) {
+        cdpRecord* foundF = cdp_record_find_by_name(listF, cdp_record_get_name(recordL));
+        assert_not_null(foundF);
+        test_records_value(foundF, *(uint32_t*)cdp_record_data(recordL));
+    }
+
+    cdp_store_delete_children(listF->store);
+    assert_null(cdp_record_find_by_name(listF, cdp_record_get_name(cdp_record_first(listL))));
+    cdp_store_filter(listF->store, false);
+
+    cdp_record_delete(listL);
+    cdp_record_delete(listF);
+}
+
+
+static void test_records_tech_slab(void) {
+    size_t maxItems = munit_rand_int_range(2, 2000);
+    cdpSlabStats before, peak, after;
+    cdp_slab_flush();
+    cdp_slab_stats(&before);
+
+    // Churn through a list (nodes and data come from shared slabs).
+    cdpRecord* list = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+1), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_LINKED_LIST);
+    for (unsigned n = 0;  n < maxItems;  n++) {
+        uint32_t value = n + 1;
+        cdp_record_append_value(list, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + value), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        if (!munit_rand_int_range(0, 3))
+            cdp_record_delete(cdp_record_first(list));
+    }
+    test_records_value(cdp_record_last(list), maxItems);
+    cdp_slab_stats(&peak);
+  #ifndef CDP_SLAB_DISABLE
+    assert_size(peak.slabs, >, 0);
+  #endif
+    cdp_record_delete(list);
+    cdp_slab_flush();
+    cdp_slab_stats(&after);
+    assert_size(after.slabs, <=, peak.slabs);
+    assert_size(after.arenaSlabs, ==, before.arenaSlabs);
+
+    // Build a branch in an arena, then let it go at once.
+    cdpRecord* branch = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+2), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_RED_BLACK_T);
+    cdpArena* arena = cdp_arena_new();
+    cdp_store_arena(branch->store, arena);
+    cdpArena* previous = cdp_arena_use(arena);
+    assert_null(previous);
+    for (unsigned n = 0;  n < maxItems;  n++) {
+        uint32_t value = n + 1;
+        cdpRecord* sub = cdp_record_add_list(branch, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + value), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_INLINE, (size_t)2);
+        cdp_record_append_value(sub, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 1), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        if (!munit_rand_int_range(0, 4)) {
+            cdp_record_append_value(sub, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 2), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+            cdp_record_append_value(sub, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 3), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));  // Promoted out of inline.
+        }
+    }
+    assert_ptr_equal(cdp_arena_use(previous), arena);
+    cdp_slab_stats(&peak);
+  #ifndef CDP_SLAB_DISABLE
+    assert_size(peak.arenaSlabs, >, before.arenaSlabs);
+  #endif
+
+    // Children added after leaving the arena are freed one by one as usual.
+    uint32_t extra = maxItems + 1;
+    cdpRecord* sub = cdp_record_add_list(branch, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + extra), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_LINKED_LIST);
+    cdp_record_append_value(sub, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 1), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &extra, sizeof(uint32_t), sizeof(uint32_t));
+
+    assert_size(cdp_record_children(branch), ==, maxItems + 1);
+    for (unsigned n = 0;  n <= maxItems;  n++) {
+        cdpRecord* found = cdp_record_find_by_name(branch, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + n + 1));
+        assert_not_null(found);
+        test_records_value(cdp_record_first(found), n + 1);
+    }
+
+    cdp_record_delete(branch);
+    cdp_slab_stats(&after);
+    assert_size(after.arenaSlabs, ==, before.arenaSlabs);
+}
+
+
+static void test_records_tech_shared(void) {
+    size_t frameSize = munit_rand_int_range(1, 64) * 256;
+    size_t outputs   = munit_rand_int_range(2, 40);
+    uint32_t* frame = cdp_malloc(frameSize);
+    for (unsigned n = 0;  n < frameSize / sizeof(uint32_t);  n++)
+        frame[n] = n;
+
+    // One payload fanned out to several outputs (no copies).
+    cdpRecord* source = cdp_record_add_data(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP), 0, CDP_DTAW("CDP", "frame"), (cdpID)0, CDP_ID(0), frame, frameSize, frameSize, cdp_free);
+    cdpRecord* fanout = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+1), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_ARRAY, outputs);
+    for (unsigned n = 1;  n <= outputs;  n++) {
+        cdpRecord* output = cdp_record_append_shared(fanout, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + n), source);
+        assert_not_null(output);
+        assert_ptr_equal(cdp_record_data(output), frame);
+    }
+    assert_true(cdp_data_is_shared(source->data));
+    assert_uint32(source->data->refs, ==, outputs + 1);
+
+    // Writing to one output gives it a private copy.
+    size_t pick = munit_rand_int_range(0, outputs - 1);
+    cdpRecord* output = cdp_record_find_by_position(fanout, pick);
+    uint32_t value = 0xF00D;
+    uint32_t* written = cdp_record_update(output, sizeof(value), sizeof(value), &value, false);
+    assert_ptr_not_equal(written, frame);
+    assert_uint32(written[0], ==, value);
+    assert_uint32(written[1], ==, 1);
+    assert_false(cdp_data_is_shared(output->data));
+    assert_uint32(source->data->refs, ==, outputs);
+    assert_uint32(frame[0], ==, 0);
+
+    // The rest keep the payload after the source is gone.
+    cdp_record_delete(source);
+    for (unsigned n = 0;  n < outputs;  n++) {
+        if (n == pick)
+            continue;
+        uint32_t* shared = cdp_record_data(cdp_record_find_by_position(fanout, n));
+        assert_ptr_equal(shared, frame);
+        assert_uint32(shared[frameSize/sizeof(uint32_t) - 1], ==, frameSize/sizeof(uint32_t) - 1);
+    }
+
+    // Values are shared (and copied on write) the same way.
+    value = 7;
+    cdpRecord* small = cdp_record_append_value(fanout, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + outputs + 1), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+    cdpRecord* twin  = cdp_record_append_shared(fanout, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + outputs + 2), small);
+    small = cdp_record_find_by_position(fanout, outputs);     // (The array may have moved it.)
+    assert_ptr_equal(cdp_record_data(twin), cdp_record_data(small));
+    value = 8;
+    cdp_record_update_value(twin, sizeof(uint32_t), &value);
+    test_records_value(twin, 8);
+    test_records_value(small, 7);
+
+    cdp_record_delete(fanout);
+}
+
+
+static void test_records_tech_intern(void) {
+    size_t maxItems = munit_rand_int_range(2, 500);
+    size_t distinct = munit_rand_int_range(1, 8);
+    size_t before   = cdp_data_interned_count();
+
+    // Replicated values end up in one (read-only) data each.
+    cdpRecord* list = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_LINKED_LIST);
+    cdpRecord* first[8] = {0};
+    for (unsigned n = 1;  n <= maxItems;  n++) {
+        uint32_t value = n % distinct;
+        cdpData* data = cdp_data_new_interned(CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t));
+        cdpRecord* item = cdp_record_append_child(list, CDP_TYPE_NORMAL, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + n), false, data, NULL);
+        test_records_value(item, value);
+        if (first[value])
+            assert_ptr_equal(item->data, first[value]->data);
+        else
+            first[value] = item;
+    }
+    assert_size(cdp_data_interned_count(), ==, before + cdp_min(distinct, maxItems));
+    uint32_t other = 0xBAD;
+    assert_null(cdp_record_update_value(first[maxItems % distinct], sizeof(uint32_t), &other));
+    test_records_value(first[maxItems % distinct], maxItems % distinct);
+
+    // Data buffers (and DTs) are interned by content too.
+    char blob[] = "key=value;mode=fast;level=3";
+    cdpData* a = cdp_data_intern(cdp_data_new(CDP_DTAW("CDP", "config"), (cdpID)0, CDP_ID(0), CDP_DATATYPE_DATA, false, NULL, blob, sizeof(blob), sizeof(blob), NULL));
+    cdpData* b = cdp_data_intern(cdp_data_new(CDP_DTAW("CDP", "config"), (cdpID)0, CDP_ID(0), CDP_DATATYPE_DATA, false, NULL, blob, sizeof(blob), sizeof(blob), NULL));
+    cdpData* c = cdp_data_intern(cdp_data_new(CDP_DTAW("CDP", "other"),  (cdpID)0, CDP_ID(0), CDP_DATATYPE_DATA, false, NULL, blob, sizeof(blob), sizeof(blob), NULL));
+    assert_ptr_equal(a, b);
+    assert_ptr_not_equal(a, c);
+    cdpDT dt = *CDP_DTAW("CDP", "list");
+    cdpRecord* dtA = cdp_record_add_new_data(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+1), 0, cdp_data_new_interned(CDP_DTAW("CDP", "dt"), (cdpID)0, CDP_ID(0), &dt, sizeof(dt)));
+    cdpRecord* dtB = cdp_record_add_new_data(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+2), 0, cdp_data_new_interned(CDP_DTAW("CDP", "dt"), (cdpID)0, CDP_ID(0), &dt, sizeof(dt)));
+    assert_ptr_equal(dtA->data, dtB->data);
+
+    // Entries leave with their last user.
+    cdp_data_del(a);
+    cdp_data_del(b);
+    cdp_data_del(c);
+    cdp_record_delete(dtA);
+    cdp_record_delete(dtB);
+    cdp_record_delete(list);
+    assert_size(cdp_data_interned_count(), ==, before);
+}
+
+
+static void test_records_tech_compiled_path(void) {
+    static const unsigned storages[] = {CDP_STORAGE_LINKED_LIST, CDP_STORAGE_ARRAY, CDP_STORAGE_RED_BLACK_T, CDP_STORAGE_HASH_TABLE, CDP_STORAGE_BTREE, CDP_STORAGE_ART};
+    unsigned depth = munit_rand_int_range(2, 8);
+
+    // A deep branch (of assorted dictionaries) with some siblings on each level.
+    cdpRecord* level[8];
+    cdpRecord* record = cdp_root();
+    for (unsigned d = 0;  d < depth;  d++) {
+        unsigned storage = storages[munit_rand_int_range(0, cdp_lengthof(storages) - 1)];
+        cdpDT* dt = CDP_DTAW("CDP", "dictionary");
+        cdpStore* store = (storage == CDP_STORAGE_ARRAY || storage == CDP_STORAGE_HASH_TABLE)?
+                          cdp_store_new(dt, storage, CDP_INDEX_BY_NAME, (size_t)2):
+                          cdp_store_new(dt, storage, CDP_INDEX_BY_NAME);
+        for (unsigned n = munit_rand_int_range(0, 3);  n;  n--) {
+            uint32_t value = n;
+            cdp_record_add_value(record, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 100 + n), 0, CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        }
+        record = cdp_record_add_child(record, CDP_TYPE_NORMAL, CDP_DTS(CDP_ACRO("CDP"), (d? CDP_NAME_ENUMERATION + d: CDP_NAME_TEMP)), 0, NULL, store);
+        level[d] = record;
+    }
+    uint32_t value = depth;
+    cdpRecord* leaf = cdp_record_add_value(record, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 50), 0, CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+
+    cdpPath* path = cdp_malloc(sizeof(cdpPath) + ((depth + 1) * sizeof(cdpDT)));
+    path->length = path->capacity = depth + 1;
+    for (unsigned d = 0;  d < depth;  d++)
+        path->dt[d] = *cdp_record_get_name(level[d]);
+    path->dt[depth] = *cdp_record_get_name(leaf);
+    cdpCompiledPath* compiled = cdp_compiled_path_new(cdp_root(), path);
+
+    // First resolution walks every level, later ones none.
+    assert_ptr_equal(cdp_record_find_by_compiled_path(compiled), leaf);
+    assert_size(compiled->walks, ==, path->length);
+    for (unsigned n = 0;  n < 3;  n++)
+        assert_ptr_equal(cdp_record_find_by_compiled_path(compiled), leaf);
+    assert_size(compiled->walks, ==, path->length);
+
+    // Changing a level only searches that level again.
+    unsigned d = munit_rand_int_range(0, depth - 1);
+    value = 1;
+    cdp_record_add_value(level[d], CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 200), 0, CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+    size_t walks = compiled->walks;
+    leaf = cdp_record_find_by_compiled_path(compiled);
+    assert_ptr_equal(leaf, cdp_record_find_by_path(cdp_root(), path));
+    test_records_value(leaf, depth);
+    assert_size(compiled->walks, ==, walks + 1);
+
+    // Removed records aren't found (until they are back).
+    record = cdp_root();
+    for (unsigned d = 0;  d < depth;  d++)
+        level[d] = record = cdp_record_find_by_name(record, &path->dt[d]);     // (Siblings may have moved them.)
+    cdp_record_delete(leaf);
+    assert_null(cdp_record_find_by_compiled_path(compiled));
+    value = depth + 1;
+    leaf = cdp_record_add_value(level[depth - 1], CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 50), 0, CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+    assert_ptr_equal(cdp_record_find_by_compiled_path(compiled), leaf);
+    test_records_value(leaf, depth + 1);
+
+    // So it goes with whole branches.
+    cdp_record_delete(level[0]);
+    assert_null(cdp_record_find_by_compiled_path(compiled));
+
+    cdp_compiled_path_del(compiled);
+    cdp_free(path);
+}
+
+
+typedef struct {
+    size_t      count;
+    uint64_t    sum;
+    unsigned    maxDepth;
+} tech_scan_t;
+
+static bool tech_scan(cdpEntry* entry, tech_scan_t* scan) {
+    scan->count++;
+    if (cdp_record_has_data(entry->record))
+        scan->sum += *(uint32_t*)cdp_record_data(entry->record);
+    scan->maxDepth = cdp_max(scan->maxDepth, entry->depth);
+    return true;
+}
+
+static void tech_scan_reduce(tech_scan_t* total, tech_scan_t* scan) {
+    total->count += scan->count;
+    total->sum   += scan->sum;
+    total->maxDepth = cdp_max(total->maxDepth, scan->maxDepth);
+}
+
+static bool tech_scan_until(cdpEntry* entry, uint32_t* stopAt) {
+    return !(cdp_record_has_data(entry->record)  &&  *(uint32_t*)cdp_record_data(entry->record) == *stopAt);
+}
+
+static void tech_scan_branch(cdpRecord* branch, unsigned depth, uint32_t* value) {
+    unsigned children = munit_rand_int_range(depth? 1: 4, 12);
+    for (unsigned n = 1;  n <= children;  n++) {
+        if (depth < 5  &&  !munit_rand_int_range(0, 2)) {
+            cdpRecord* sub = cdp_record_add_dictionary(branch, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + n), 0, CDP_DTAW("CDP", "dictionary"), (n & 1)? CDP_STORAGE_RED_BLACK_T: CDP_STORAGE_LINKED_LIST);
+            tech_scan_branch(sub, depth + 1, value);
+        } else {
+            ++*value;
+            cdp_record_add_value(branch, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + n), 0, CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), value, sizeof(uint32_t), sizeof(uint32_t));
+        }
+    }
+}
+
+static void test_records_tech_parallel_traverse(void) {
+    uint32_t values = 0;
+    cdpRecord* tree = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_RED_BLACK_T);
+    tech_scan_branch(tree, 0, &values);
+
+    tech_scan_t expected = {0};
+    assert_true(cdp_record_deep_traverse(tree, (cdpTraverse) tech_scan, NULL, &expected, NULL));
+    assert_uint64(expected.sum, ==, ((uint64_t)values * (values + 1)) / 2);
+
+    // Each worker counts on its own, then they are added up.
+    unsigned workers = munit_rand_int_range(1, 8);
+    tech_scan_t scan[8] = {0};
+    tech_scan_t total = {0};
+    assert_true(cdp_record_parallel_traverse(tree, (cdpTraverse) tech_scan, workers, scan, sizeof(tech_scan_t), (cdpReduce) tech_scan_reduce, &total));
+    assert_size(total.count, ==, expected.count);
+    assert_uint64(total.sum, ==, expected.sum);
+    assert_uint(total.maxDepth, ==, expected.maxDepth);
+
+    // Any worker may stop it.
+    uint32_t stopAt = munit_rand_int_range(1, values);
+    assert_false(cdp_record_parallel_traverse(tree, (cdpTraverse) tech_scan_until, workers, &stopAt, 0, NULL, NULL));
+
+    cdp_record_delete(tree);
+}
+
+
+static void tech_cursor_check(cdpRecord* parent) {
+    size_t children = cdp_record_children(parent);
+    cdpRecord** expected = cdp_malloc(children * sizeof(cdpRecord*));
+    size_t n = 0;
+    for (cdpRecord* child = cdp_record_first(parent);  child;  child = cdp_record_next(parent, child))
+        expected[n++] = child;
+    assert_size(n, ==, children);
+
+    // Step by step, in the same order as the store.
+    cdpCursor cursor;
+    n = 0;
+    cdp_cursor_foreach(&cursor, parent, child) {
+        assert_ptr_equal(child, expected[n]);
+        assert_size(cursor.position, ==, n);
+        n++;
+    }
+    assert_size(n, ==, children);
+    assert_null(cdp_cursor_next(&cursor));
+
+    // In batches.
+    cdpRecord* batch[16];
+    size_t max = 1 + munit_rand_uint32() % 16;
+    n = 0;
+    cdp_cursor_first(&cursor, parent);
+    for (size_t got = cdp_cursor_batch(&cursor, batch, max);  got;  got = cdp_cursor_batch(&cursor, batch, max)) {
+        assert_size(got, <=, max);
+        for (size_t i = 0;  i < got;  i++)
+            assert_ptr_equal(batch[i], expected[n++]);
+        assert_size(cursor.position, ==, n);
+    }
+    assert_size(n, ==, children);
+
+    // In contiguous spans.
+    cdpRecord* span;
+    n = 0;
+    cdp_cursor_first(&cursor, parent);
+    for (size_t size = cdp_cursor_span(&cursor, &span);  size;  size = cdp_cursor_span(&cursor, &span)) {
+        for (size_t i = 0;  i < size;  i++)
+            assert_ptr_equal(&span[i], expected[n++]);
+    }
+    assert_size(n, ==, children);
+
+    // Seeking, then going on from there.
+    for (unsigned round = 0;  round < 8;  round++) {
+        size_t position = munit_rand_uint32() % children;
+        cdp_cursor_first(&cursor, parent);
+        assert_ptr_equal(cdp_cursor_seek_position(&cursor, position), expected[position]);
+        assert_ptr_equal(cdp_cursor_next(&cursor), (position + 1 < children)?  expected[position + 1]:  NULL);
+
+        cdpRecord* child = expected[munit_rand_uint32() % children];
+        assert_ptr_equal(cdp_cursor_seek(&cursor, CDP_DT(&child->metarecord)), child);
+        assert_size(cursor.position, ==, SIZE_MAX);       // Not worked out until asked.
+        assert_size(cdp_cursor_position(&cursor), ==, cdp_record_index_of(child));
+        cdp_cursor_next(&cursor);
+        assert_size(cdp_cursor_position(&cursor), ==, cdp_record_index_of(child) + 1);
+    }
+    assert_null(cdp_cursor_seek_position(&cursor, children));
+    assert_size(cursor.position, ==, children);
+
+    cdp_free(expected);
+}
+
+static void test_records_tech_cursor(void) {
+    float center[3] = {0.0f, 0.0f, 0.0f};
+    size_t maxItems = munit_rand_int_range(1, 300);
+    cdpRecord* record[7];
+    record[0] = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_LINKED_LIST);
+    record[1] = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+1), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_ARRAY, (size_t)4);
+    record[2] = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+2), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_PACKED_QUEUE, (size_t)4);
+    record[3] = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+3), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_INLINE, (size_t)16);   // Overflows into an array past 16.
+    record[4] = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+4), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_RED_BLACK_T);
+    record[5] = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+5), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_BTREE);
+    record[6] = cdp_record_add_child(cdp_root(), CDP_TYPE_NORMAL, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+6), 0, NULL, cdp_store_new(CDP_DTAW("CDP", "space"), CDP_STORAGE_OCTREE, CDP_INDEX_BY_FUNCTION, center, 128.0, tech_spatial_compare));
+    cdp_store_octree_limits(record[6]->store, 1 + munit_rand_uint32() % 4, 4 + munit_rand_uint32() % 8);
+
+    // Names are unique, but they go in shuffled.
+    size_t step = 1 + munit_rand_uint32() % 16;
+    for (;;) {      // It must be coprime with maxItems.
+        size_t a = maxItems, b = step;
+        while (b) { size_t t = a % b;  a = b;  b = t; }
+        if (a == 1)
+            break;
+        step--;
+    }
+    for (size_t n = 0;  n < maxItems;  n++) {
+        cdpID name = CDP_NAME_ENUMERATION + (n * step) % maxItems;
+        float item[4] = {(float)(munit_rand_uint32() % 20000) / 100.0f - 100.0f,
+                         (float)(munit_rand_uint32() % 20000) / 100.0f - 100.0f,
+                         (float)(munit_rand_uint32() % 20000) / 100.0f - 100.0f,
+                         0.0f};
+        uint32_t value = (uint32_t) n;
+        for (unsigned r = 0;  r < 4;  r++)
+            cdp_record_append_value(record[r], CDP_DTS(CDP_ACRO("CDP"), name), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        for (unsigned r = 4;  r < 6;  r++)
+            cdp_dict_add_value(record[r], CDP_DTS(CDP_ACRO("CDP"), name), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        cdp_record_add_value(record[6], CDP_DTS(CDP_ACRO("CDP"), name), 0, CDP_DTS(CDP_ACRO("CDP"), name), (cdpID)0, CDP_ID(0), item, sizeof(item), sizeof(item));
+    }
+
+    for (unsigned r = 0;  r < 7;  r++) {
+        assert_size(cdp_record_children(record[r]), ==, maxItems);
+        tech_cursor_check(record[r]);
+        cdp_record_delete(record[r]);
+    }
+}
+
+
+static void test_records_tech_handles(unsigned storage) {
+    size_t baseline = cdp_handle_count();
+    size_t maxItems = munit_rand_int_range(2, 400);
+    bool   byName   = (storage != CDP_STORAGE_PACKED_QUEUE);
+    cdpRecord* parent = byName?
+                        cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP), 0, CDP_DTAW("CDP", "dictionary"), storage, (size_t)4):
+                        cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP), 0, CDP_DTAW("CDP", "list"), storage, (size_t)4);
+    cdpRecord* links  = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+1), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_RED_BLACK_T);
+    cdpHandle* handle = cdp_malloc0(maxItems * sizeof(cdpHandle));
+
+    // Every other record gets a handle (and a link), then siblings keep moving them around.
+    for (uint32_t value = 1;  value <= maxItems;  value++) {
+        cdpDT* name = CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + value);
+        cdpRecord* record = byName?
+                            cdp_dict_add_value(parent, name, CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t)):
+                            cdp_record_prepend_value(parent, name, CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        if (value & 1) {
+            handle[value - 1] = cdp_record_handle(record);
+            assert_uint64(handle[value - 1], ==, cdp_record_handle(record));
+            cdp_dict_add_link(links, name, record);
+        }
+    }
+    assert_size(cdp_handle_count(), ==, baseline + 2 * ((maxItems + 1) / 2));     // Links have their own handles.
+    size_t handled = (maxItems + 1) / 2;
+    assert_size(parent->store->handled, ==, handled);                               // Stores count their handled children.
+    assert_size(links->store->handled, ==, handled);
+
+    for (uint32_t value = 1;  value <= maxItems;  value += 2) {
+        cdpRecord* record = cdp_handle_resolve(handle[value - 1]);
+        assert_not_null(record);
+        test_records_value(record, value);
+        cdpRecord* link = cdp_record_find_by_name(links, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + value));
+        assert_uint32(*(uint32_t*)cdp_record_data(link), ==, value);
+    }
+
+    // Deleted records invalidate their handles (and links), without touching the others.
+    for (unsigned n = 0;  n < maxItems / 4;  n++) {
+        cdpRecord* child = cdp_record_find_by_position(parent, munit_rand_uint32() % cdp_record_children(parent));
+        uint32_t value = *(uint32_t*)cdp_record_data(child);
+        bool isHandled = cdp_record_is_handled(child);
+        cdp_record_delete(child);
+        if (isHandled) {
+            handled--;
+            assert_null(cdp_handle_resolve(handle[value - 1]));
+            cdpRecord* link = cdp_record_find_by_name(links, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + value));
+            assert_null(cdp_record_data(link));
+            cdp_record_delete(link);
+            handle[value - 1] = 0;
+        }
+    }
+
+    // Sorting and switching storage move every record.
+    if (storage == CDP_STORAGE_ARRAY  ||  storage == CDP_STORAGE_BTREE)
+        assert_true(cdp_record_sort(parent, tech_value_descending, NULL));
+    if (byName)
+        assert_true(cdp_record_convert_storage(parent, (storage == CDP_STORAGE_ARRAY)?  CDP_STORAGE_RED_BLACK_T:  CDP_STORAGE_ARRAY));
+
+    for (uint32_t value = 1;  value <= maxItems;  value += 2) {
+        if (!handle[value - 1])
+            continue;
+        cdpRecord* record = cdp_handle_resolve(handle[value - 1]);
+        assert_not_null(record);
+        test_records_value(record, value);
+        assert_ptr_equal(cdp_record_parent(record), parent);
+    }
+    assert_size(parent->store->handled, ==, handled);
+
+    // Records taken out take their handle along (and leave the store count).
+    cdpRecord taken;
+    if (cdp_record_child_pop(parent, &taken)) {
+        bool isHandled = cdp_record_is_handled(&taken);
+        assert_size(parent->store->handled, ==, handled - isHandled);
+        if (isHandled)
+            assert_ptr_equal(cdp_handle_resolve(handle[*(uint32_t*)cdp_record_data(&taken) - 1]), &taken);
+        cdpRecord* back = byName?  cdp_record_add(parent, 0, &taken):  cdp_record_append(parent, false, &taken);
+        assert_not_null(back);
+        assert_size(parent->store->handled, ==, handled);
+        if (isHandled)
+            assert_ptr_equal(cdp_handle_resolve(handle[*(uint32_t*)cdp_record_data(back) - 1]), back);
+    }
+
+    cdp_record_delete(links);
+    cdp_record_delete(parent);
+    assert_size(cdp_handle_count(), ==, baseline);
+    for (size_t n = 0;  n < maxItems;  n++)
+        assert_null(cdp_handle_resolve(handle[n]));
+    cdp_free(handle);
+}
+
+
+static void test_records_tech_shadows(void) {
+    size_t baseline = cdp_handle_count();
+    uint32_t one = 1, two = 2;
+    cdpRecord* targets = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_ARRAY, (size_t)4);
+    cdpRecord* links   = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+1), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_ARRAY, (size_t)4);
+    cdp_dict_add_value(targets, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 1), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &one, sizeof(uint32_t), sizeof(uint32_t));
+    cdp_dict_add_value(targets, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 2), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &two, sizeof(uint32_t), sizeof(uint32_t));
+
+    // Links are prepended, so earlier ones keep moving.
+    size_t maxLinks = munit_rand_int_range(1, 64);
+    for (size_t n = 0;  n < maxLinks;  n++) {
+        cdpRecord* first = cdp_record_find_by_name(targets, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 1));
+        cdp_record_prepend_link(links, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + n), first);
+        assert_size(cdp_record_shadows(first, NULL, 0), ==, n + 1);
+    }
+    cdpRecord* first = cdp_record_find_by_name(targets, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 1));
+    cdpRecord* shadow[64];
+    assert_size(cdp_record_shadows(first, shadow, 64), ==, maxLinks);
+    for (size_t n = 0;  n < maxLinks;  n++) {
+        assert_ptr_equal(cdp_record_parent(shadow[n]), links);
+        assert_uint32(*(uint32_t*)cdp_record_data(shadow[n]), ==, 1);
+    }
+
+    // Deleting links takes them out of the shadows.
+    size_t deleted = munit_rand_uint32() % maxLinks;
+    for (size_t n = 0;  n < deleted;  n++)
+        cdp_record_delete(cdp_record_find_by_position(links, munit_rand_uint32() % cdp_record_children(links)));
+    assert_size(cdp_record_shadows(first, NULL, 0), ==, maxLinks - deleted);
+
+    // Links may be moved to another target all at once.
+    cdpRecord* second = cdp_record_find_by_name(targets, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 2));
+    cdp_link_redirect(first, second);
+    assert_false(cdp_record_is_shadowed(first));
+    assert_size(cdp_record_shadows(second, NULL, 0), ==, maxLinks - deleted);
+    for (cdpRecord* link = cdp_record_first(links);  link;  link = cdp_record_next(links, link))
+        assert_uint32(*(uint32_t*)cdp_record_data(link), ==, 2);
+
+    // Deleting the target nulls its links.
+    cdp_record_delete(second);
+    for (cdpRecord* link = cdp_record_first(links);  link;  link = cdp_record_next(links, link))
+        assert_null(cdp_record_data(link));
+
+    cdp_record_delete(links);
+    cdp_record_delete(targets);
+    assert_size(cdp_handle_count(), ==, baseline);
+}
+
+
+static bool tech_link_leaf(cdpEntry* entry, size_t* count) {
+    ++*count;
+    return !cdp_record_children(entry->record);     // Links are leaves.
+}
+
+static void test_records_tech_link_chains(void) {
+    size_t baseline = cdp_handle_count();
+    uint32_t one = 1, two = 2;
+    cdpRecord* targets = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_ARRAY, (size_t)4);
+    cdpRecord* links   = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+1), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_ARRAY, (size_t)4);
+    cdp_dict_add_value(targets, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 1), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &one, sizeof(uint32_t), sizeof(uint32_t));
+    cdp_dict_add_value(targets, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 2), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &two, sizeof(uint32_t), sizeof(uint32_t));
+
+    // Each link is prepended pointing to the previous one (so the chain keeps moving), the last one is at position 0.
+    size_t maxLinks = munit_rand_int_range(2, 32);
+    cdpRecord* first = cdp_record_find_by_name(targets, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 1));
+    cdp_record_prepend_link(links, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION), first);
+    for (size_t n = 1;  n < maxLinks;  n++)
+        cdp_record_prepend_link(links, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + n), cdp_record_first(links));
+    first = cdp_record_find_by_name(targets, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 1));
+    for (size_t n = 0;  n < maxLinks;  n++) {
+        cdpRecord* link = cdp_record_find_by_position(links, munit_rand_uint32() % maxLinks);
+        assert_ptr_equal(cdp_link_pull(link), first);
+        assert_uint32(*(uint32_t*)cdp_record_data(link), ==, 1);
+    }
+
+    // Traversals take links (caching their target) as leaves.
+    cdpRecord* mixed = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+2), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_RED_BLACK_T);
+    cdpRecord* value = cdp_dict_add_value(mixed, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 1), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &one, sizeof(uint32_t), sizeof(uint32_t));
+    cdpRecord* link  = cdp_dict_add_link(mixed, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 2), value);
+    assert_ptr_equal(cdp_link_pull(link), value);
+    assert_null(link->store);
+    assert_size(cdp_record_children(link), ==, 0);
+    size_t visited = 0;
+    assert_true(cdp_record_deep_traverse(mixed, (cdpTraverse) tech_link_leaf, NULL, &visited, NULL));
+    assert_size(visited, ==, 2);
+    visited = 0;
+    assert_true(cdp_record_deep_traverse(links, (cdpTraverse) tech_link_leaf, NULL, &visited, NULL));
+    assert_size(visited, ==, maxLinks);
+    cdp_record_delete(mixed);
+
+    // Re-pointing a link in the middle reaches every link leading to it.
+    size_t middle = munit_rand_uint32() % maxLinks;
+    cdpRecord* second = cdp_record_find_by_name(targets, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 2));
+    cdp_link_set(cdp_record_find_by_position(links, middle), second);
+    for (size_t n = 0;  n < maxLinks;  n++)
+        assert_ptr_equal(cdp_link_pull(cdp_record_find_by_position(links, n)), (n <= middle)? second: first);
+
+    // Redirecting a target does too.
+    cdp_link_redirect(second, first);
+    for (size_t n = 0;  n < maxLinks;  n++)
+        assert_ptr_equal(cdp_link_pull(cdp_record_find_by_position(links, n)), first);
+
+    // Deleting a link in the middle breaks the chain above it (links past the re-pointed one don't lead there anymore).
+    middle = munit_rand_uint32() % (middle + 1);
+    cdp_record_delete(cdp_record_find_by_position(links, middle));
+    for (size_t n = 0;  n < maxLinks - 1;  n++) {
+        cdpRecord* link = cdp_record_find_by_position(links, n);
+        if (n < middle)
+            assert_null(cdp_link_pull(link));
+        else
+            assert_ptr_equal(cdp_link_pull(link), first);
+    }
+
+    // Deleting the final target leaves nothing to reach.
+    cdp_record_delete(first);
+    for (cdpRecord* link = cdp_record_first(links);  link;  link = cdp_record_next(links, link))
+        assert_null(cdp_record_data(link));
+
+    cdp_record_delete(links);
+    cdp_record_delete(targets);
+    assert_size(cdp_handle_count(), ==, baseline);
+}
+
+
+static void test_records_tech_pool(void) {
+  #ifdef CDP_SLAB_DISABLE
+    size_t bufSize = 256 * 1024;
+  #else
+    size_t bufSize = 4 * 1024 * 1024;       // Room for a few 64 KiB slabs.
+  #endif
+    void* buffer = cdp_malloc(bufSize);
+    cdpPool pool;
+    cdp_pool_init(&pool, buffer, bufSize);
+    cdpAllocator allocator = cdp_pool_allocator(&pool);
+    cdp_record_system_allocator(&allocator);
+    cdp_record_system_initiate();
+
+    // Fill until memory runs out: additions fail gracefully.
+    unsigned storage = munit_rand_int_range(0, 1)?  CDP_STORAGE_LINKED_LIST:  CDP_STORAGE_ARRAY;
+    cdpRecord* list = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP), 0, CDP_DTAW("CDP", "list"), storage, (size_t)16);
+    assert_not_null(list);
+    uint32_t value;
+    for (value = 1;  ;  value++) {
+        cdpRecord* item = cdp_record_append_value(list, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + value), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+        if (!item)
+            break;
+    }
+    assert_size(pool.failures, >, 0);
+    assert_size(cdp_record_children(list), ==, value - 1);
+    test_records_value(cdp_record_first(list), 1);
+    test_records_value(cdp_record_last(list), value - 1);
+    assert_null(cdp_record_add_data(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+1), 0, CDP_DTAW("CDP", "data"), (cdpID)0, CDP_ID(0), NULL, 0, bufSize, NULL));
+
+    // Once memory is given back, records may be added again.
+    size_t peak = pool.used;
+    cdp_record_delete(list);
+    assert_size(pool.used, <, peak);
+    list = cdp_record_add_list(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP), 0, CDP_DTAW("CDP", "list"), CDP_STORAGE_LINKED_LIST);
+    assert_not_null(list);
+    assert_not_null(cdp_record_append_value(list, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + 1), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t)));
+
+    cdp_record_system_shutdown();
+    assert_size(pool.used, ==, 0);      // Nothing leaks into the pool.
+    cdp_record_system_allocator(NULL);
+    cdp_free(buffer);
+}
+
+
+static size_t TECH_FAIL_AFTER;     // Allocations left before the next one fails (0 means none fails).
+
+static bool tech_failing_now(void) {
+    return (TECH_FAIL_AFTER  &&  !--TECH_FAIL_AFTER);
+}
+static void* tech_failing_alloc(void* context, size_t z)                {return tech_failing_now()?  NULL:  malloc(z);}
+static void* tech_failing_realloc(void* context, void* p, size_t z)     {return tech_failing_now()?  NULL:  realloc(p, z);}
+static void* tech_failing_aligned(void* context, size_t a, size_t z)    {return tech_failing_now()?  NULL:  aligned_alloc(a, z);}
+
+static void test_records_tech_convert_oom(void) {
+    cdpAllocator allocator = {tech_failing_alloc, tech_failing_realloc, tech_failing_aligned, cdp_libc_free, NULL};
+    cdp_record_system_allocator(&allocator);
+    cdp_record_system_initiate();
+
+    size_t capacity = munit_rand_int_range(1, 16);
+    cdpRecord* dict = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_INLINE, capacity);
+    for (uint32_t value = 1;  value <= capacity;  value++)
+        cdp_dict_add_value(dict, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + value), CDP_DTAW("CDP", "value"), (cdpID)0, CDP_ID(0), &value, sizeof(uint32_t), sizeof(uint32_t));
+
+    // An array store comes and goes first, so the slab for them is there already.
+    cdp_record_delete(cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP+1), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_ARRAY, (size_t)8));
+
+    // A full inline store is promoted while adding: each allocation along the way fails in turn.
+    cdpRecord child;
+    for (size_t failing = 1;  ;  failing++) {
+        cdp_record_initialize(&child, CDP_TYPE_NORMAL, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION), NULL, NULL);
+        TECH_FAIL_AFTER = failing;
+        cdpRecord* added = cdp_record_add(dict, 0, &child);
+        TECH_FAIL_AFTER = 0;
+        if (added)
+            break;
+
+        // Children are all there (the store may be promoted already).
+        cdp_record_finalize(&child);
+        assert_size(cdp_record_children(dict), ==, capacity);
+        uint32_t value = 1;
+        for (cdpRecord* record = cdp_record_first(dict);  record;  record = cdp_record_next(dict, record), value++) {
+            test_records_value(record, value);
+            assert_ptr_equal(cdp_record_parent(record), dict);
+        }
+    }
+    assert_uint(dict->store->storage, ==, CDP_STORAGE_ARRAY);
+    assert_size(cdp_record_children(dict), ==, capacity + 1);
+    for (uint32_t value = 1;  value <= capacity;  value++)
+        test_records_value(cdp_record_find_by_name(dict, CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_ENUMERATION + value)), value);
+
+    cdp_record_system_shutdown();
+    cdp_record_system_allocator(NULL);
+}
+
+static void test_records_tech_parallel_oom(void) {
+    cdpAllocator allocator = {tech_failing_alloc, tech_failing_realloc, tech_failing_aligned, cdp_libc_free, NULL};
+    cdp_record_system_allocator(&allocator);
+    cdp_record_system_initiate();
+
+    uint32_t values = 0;
+    cdpRecord* tree = cdp_record_add_dictionary(cdp_root(), CDP_DTS(CDP_ACRO("CDP"), CDP_NAME_TEMP), 0, CDP_DTAW("CDP", "dictionary"), CDP_STORAGE_RED_BLACK_T);
+    tech_scan_branch(tree, 0, &values);
+    tech_scan_t expected = {0};
+    assert_true(cdp_record_deep_traverse(tree, (cdpTraverse) tech_scan, NULL, &expected, NULL));
+
+    // Running out of memory anywhere along the way is reported (a single worker, so failures are repeatable).
+    for (size_t failing = 1;  ;  failing++) {
+        tech_scan_t scan = {0};
+        TECH_FAIL_AFTER = failing;
+        bool done = cdp_record_parallel_traverse(tree, (cdpTraverse) tech_scan, 1, &scan, sizeof(tech_scan_t), NULL, NULL);
+        bool failed = !TECH_FAIL_AFTER;
+        TECH_FAIL_AFTER = 0;
+        if (!failed) {
+            assert_true(done);
+            assert_size(scan.count, ==, expected.count);
+            break;
+        }
+        assert_false(done);
+    }
+
+    cdp_record_system_shutdown();
+    cdp_record_system_allocator(NULL);
+}
+
 MunitResult test_records(const MunitParameter params[], void* user_data_or_fixture) {
     cdp_record_system_initiate();
 
@@ -612,18 +2525,59 @@ MunitResult test_records(const MunitParameter params[], void* user_data_or_fixtu
     test_records_tech_list(CDP_STORAGE_ARRAY);
     test_records_tech_list(CDP_STORAGE_PACKED_QUEUE);
     test_records_tech_sequencing_list();
+    test_records_tech_packed_queue();
+    test_records_tech_deque(CDP_STORAGE_ARRAY);
+    test_records_tech_deque(CDP_STORAGE_INLINE);
 
     test_records_tech_dictionary(CDP_STORAGE_LINKED_LIST);
     test_records_tech_dictionary(CDP_STORAGE_ARRAY);
     test_records_tech_dictionary(CDP_STORAGE_RED_BLACK_T);
+    test_records_tech_dictionary(CDP_STORAGE_BTREE);
+    test_records_tech_dictionary(CDP_STORAGE_ART);
     test_records_tech_sequencing_dictionary();
 
     test_records_tech_catalog(CDP_STORAGE_LINKED_LIST);
     test_records_tech_catalog(CDP_STORAGE_ARRAY);
     test_records_tech_catalog(CDP_STORAGE_RED_BLACK_T);
+    test_records_tech_catalog(CDP_STORAGE_BTREE);
     test_records_tech_sequencing_catalog();
 
+    test_records_tech_array_keys();
+    test_records_tech_hash_table();
+    test_records_tech_content_hash(CDP_STORAGE_LINKED_LIST);
+    test_records_tech_content_hash(CDP_STORAGE_ARRAY);
+    test_records_tech_content_hash(CDP_STORAGE_RED_BLACK_T);
+    test_records_tech_content_hash(CDP_STORAGE_BTREE);
+    test_records_tech_content_hash(CDP_STORAGE_SKIPLIST);
+    test_records_tech_content_hash(CDP_STORAGE_INLINE);
+    test_records_tech_btree();
+    test_records_tech_storage_switch();
+    test_records_tech_spatial();
+    test_records_tech_skiplist();
+    test_records_tech_art();
+    test_records_tech_inline();
+    test_records_tech_filter(CDP_STORAGE_LINKED_LIST);
+    test_records_tech_filter(CDP_STORAGE_ARRAY);
+    test_records_tech_filter(CDP_STORAGE_PACKED_QUEUE);
+    test_records_tech_filter(CDP_STORAGE_INLINE);
+    test_records_tech_slab();
+    test_records_tech_shared();
+    test_records_tech_intern();
+    test_records_tech_compiled_path();
+    test_records_tech_parallel_traverse();
+    test_records_tech_cursor();
+    test_records_tech_handles(CDP_STORAGE_ARRAY);
+    test_records_tech_handles(CDP_STORAGE_INLINE);
+    test_records_tech_handles(CDP_STORAGE_BTREE);
+    test_records_tech_handles(CDP_STORAGE_PACKED_QUEUE);
+    test_records_tech_shadows();
+    test_records_tech_link_chains();
+
     cdp_record_system_shutdown();
+
+    test_records_tech_pool();
+    test_records_tech_convert_oom();
+    test_records_tech_parallel_oom();
     return MUNIT_OK;
 }
 